@@ -31,7 +31,9 @@
 #include "../src/data/data.cc"
 #include "../src/data/simple_csr_source.cc"
 #include "../src/data/simple_dmatrix.cc"
+#include "../src/data/parser_batches.cc"
 #include "../src/data/sparse_page_raw_format.cc"
+#include "../src/data/sparse_page_column_format.cc"
 
 // prediction
 #include "../src/predictor/predictor.cc"
@@ -66,6 +68,7 @@
 #include "../src/common/common.cc"
 #include "../src/common/host_device_vector.cc"
 #include "../src/common/hist_util.cc"
+#include "../src/common/io.cc"
 
 // c_api
 #include "../src/c_api/c_api.cc"
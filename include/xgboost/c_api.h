@@ -221,6 +221,37 @@ XGB_DLL int XGDMatrixSliceDMatrix(DMatrixHandle handle,
                                   const int *idxset,
                                   bst_ulong len,
                                   DMatrixHandle *out);
+/*!
+ * \brief append rows in CSR format to an existing in-memory matrix in place,
+ *  a booster training on the matrix bins the new rows with its existing
+ *  histogram cuts
+ * \param handle instance of data matrix to be extended
+ * \param indptr pointer to row headers
+ * \param indices findex, must be below the number of columns of the matrix
+ * \param data fvalue
+ * \param nindptr number of appended rows + 1
+ * \param nelem number of nonzero elements in the appended rows
+ * \param label label of the appended rows, can be NULL when the matrix has no labels
+ * \param weight weight of the appended rows, can be NULL when the matrix has no weights
+ * \return 0 when success, -1 when failure happens
+ */
+XGB_DLL int XGDMatrixAppendRows(DMatrixHandle handle,
+                                const size_t* indptr,
+                                const unsigned* indices,
+                                const float* data,
+                                size_t nindptr,
+                                size_t nelem,
+                                const float* label,
+                                const float* weight);
+/*!
+ * \brief quantize the matrix for the hist tree method ahead of training, the
+ *  result is shared by boosters with the same max_bin and saved by
+ *  XGDMatrixSaveBinary
+ * \param handle instance of data matrix
+ * \param max_bin maximum number of bins per feature
+ * \return 0 when success, -1 when failure happens
+ */
+XGB_DLL int XGDMatrixQuantize(DMatrixHandle handle, int max_bin);
 /*!
  * \brief free space in data matrix
  * \return 0 when success, -1 when failure happens
@@ -400,6 +431,55 @@ XGB_DLL int XGBoosterPredict(BoosterHandle handle,
                              unsigned ntree_limit,
                              bst_ulong *out_len,
                              const float **out_result);
+/*!
+ * \brief make prediction based on dmat, writing into a caller-owned buffer.
+ *  Several threads can predict with the same booster concurrently, with any
+ *  option_mask, as long as it is not trained or modified at the same time.
+ * \param handle handle
+ * \param dmat data matrix
+ * \param option_mask bit-mask of options taken in prediction, same as XGBoosterPredict
+ * \param ntree_limit limit number of trees used for prediction, this is only valid for boosted trees
+ *    when the parameter is set to 0, we will use all the trees
+ * \param out_size number of floats out_result can hold
+ * \param out_result caller-allocated buffer that receives the predictions
+ * \param out_len used to store the number of predictions, also set when
+ *    out_size is too small and the call fails
+ * \return 0 when success, -1 when failure happens
+ */
+XGB_DLL int XGBoosterPredictToBuffer(BoosterHandle handle,
+                                     DMatrixHandle dmat,
+                                     int option_mask,
+                                     unsigned ntree_limit,
+                                     bst_ulong out_size,
+                                     float *out_result,
+                                     bst_ulong *out_len);
+/*!
+ * \brief make prediction on a dense row-major matrix, which is read in place
+ *  without creating a DMatrix
+ * \param handle handle
+ * \param data pointer to the nrow * ncol feature values
+ * \param nrow number of rows
+ * \param ncol number of columns
+ * \param missing which value to represent missing value, NaN is always missing
+ * \param option_mask bit-mask of options taken in prediction, possible values
+ *          0:normal prediction
+ *          1:output margin instead of transformed value
+ * \param ntree_limit limit number of trees used for prediction, this is only valid for boosted trees
+ *    when the parameter is set to 0, we will use all the trees
+ * \param out_result caller-allocated buffer of nrow * max(num_class, 1) floats
+ *    that receives the predictions.  Every objective writes nrow * max(num_class, 1)
+ *    values, row by row, except multi:softmax without the output margin option,
+ *    which writes only the nrow predicted class indices.
+ * \return 0 when success, -1 when failure happens
+ */
+XGB_DLL int XGBoosterPredictFromDense(BoosterHandle handle,
+                                      const float *data,
+                                      bst_ulong nrow,
+                                      bst_ulong ncol,
+                                      float missing,
+                                      int option_mask,
+                                      unsigned ntree_limit,
+                                      float *out_result);
 
 /*!
  * \brief load model from existing file
@@ -12,6 +12,7 @@
 #include <rabit/rabit.h>
 #include <cstring>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <algorithm>
 #include <string>
@@ -203,45 +204,16 @@ class SparsePage {
     data.HostVector().clear();
   }
 
-  SparsePage GetTranspose(int num_columns) const {
-    SparsePage transpose;
-    common::ParallelGroupBuilder<Entry> builder(&transpose.offset.HostVector(),
-                                                &transpose.data.HostVector());
-    const int nthread = omp_get_max_threads();
-    builder.InitBudget(num_columns, nthread);
-    long batch_size = static_cast<long>(this->Size());  // NOLINT(*)
-#pragma omp parallel for schedule(static)
-    for (long i = 0; i < batch_size; ++i) {  // NOLINT(*)
-      int tid = omp_get_thread_num();
-      auto inst = (*this)[i];
-      for (bst_uint j = 0; j < inst.size(); ++j) {
-        builder.AddBudget(inst[j].index, tid);
-      }
-    }
-    builder.InitStorage();
-#pragma omp parallel for schedule(static)
-    for (long i = 0; i < batch_size; ++i) {  // NOLINT(*)
-      int tid = omp_get_thread_num();
-      auto inst = (*this)[i];
-      for (bst_uint j = 0; j < inst.size(); ++j) {
-        builder.Push(
-            inst[j].index,
-            Entry(static_cast<bst_uint>(this->base_rowid + i), inst[j].fvalue),
-            tid);
-      }
-    }
-    return transpose;
-  }
+  SparsePage GetTranspose(int num_columns) const;
 
   void SortRows() {
     auto ncol = static_cast<bst_omp_uint>(this->Size());
+    const size_t* offset_ptr = offset.ConstHostVector().data();
+    Entry* data_ptr = data.HostVector().data();
 #pragma omp parallel for schedule(dynamic, 1)
     for (bst_omp_uint i = 0; i < ncol; ++i) {
-      if (this->offset.HostVector()[i] < this->offset.HostVector()[i + 1]) {
-        std::sort(
-            this->data.HostVector().begin() + this->offset.HostVector()[i],
-            this->data.HostVector().begin() + this->offset.HostVector()[i + 1],
-            Entry::CmpValue);
+      if (offset_ptr[i] < offset_ptr[i + 1]) {
+        std::sort(data_ptr + offset_ptr[i], data_ptr + offset_ptr[i + 1], Entry::CmpValue);
       }
     }
   }
@@ -280,6 +252,76 @@ class SparsePage {
   size_t Size() { return offset.Size() - 1; }
 };
 
+/*!
+ * \brief Read-only view of a SparsePage for hot loops.
+ *  The host pointers of the page and the bounds behaviour are resolved once at
+ *  construction instead of on every row access, so the page must not be
+ *  modified while the view is in use.
+ */
+class SparsePageView {
+ public:
+  using Inst = SparsePage::Inst;
+
+  explicit SparsePageView(const SparsePage& page)
+      : base_rowid(page.base_rowid),
+        offset_(page.offset.ConstHostVector().data()),
+        data_(page.data.ConstHostVector().data()),
+        size_(page.offset.Size() - 1),
+        allow_past_end_(rabit::IsDistributed()) {}
+
+  /*! \brief get i-th row from the page */
+  inline Inst operator[](size_t i) const {
+    // in distributed mode, some partitions may not get any instance for a feature. Therefore
+    // a row past the end is empty
+    if (allow_past_end_ && i >= size_) {
+      return {data_ + offset_[size_], static_cast<Inst::index_type>(0)};
+    }
+    return {data_ + offset_[i], static_cast<Inst::index_type>(offset_[i + 1] - offset_[i])};
+  }
+  /*! \return number of instance in the page */
+  inline size_t Size() const { return size_; }
+
+  /*! \brief row id of the first row of the page */
+  size_t base_rowid;
+
+ private:
+  const size_t* offset_;
+  const Entry* data_;
+  size_t size_;
+  bool allow_past_end_;
+};
+
+inline SparsePage SparsePage::GetTranspose(int num_columns) const {
+  SparsePage transpose;
+  common::ParallelGroupBuilder<Entry> builder(&transpose.offset.HostVector(),
+                                              &transpose.data.HostVector());
+  const int nthread = omp_get_max_threads();
+  builder.InitBudget(num_columns, nthread);
+  const SparsePageView page(*this);
+  long batch_size = static_cast<long>(this->Size());  // NOLINT(*)
+#pragma omp parallel for schedule(static)
+  for (long i = 0; i < batch_size; ++i) {  // NOLINT(*)
+    int tid = omp_get_thread_num();
+    auto inst = page[i];
+    for (bst_uint j = 0; j < inst.size(); ++j) {
+      builder.AddBudget(inst[j].index, tid);
+    }
+  }
+  builder.InitStorage();
+#pragma omp parallel for schedule(static)
+  for (long i = 0; i < batch_size; ++i) {  // NOLINT(*)
+    int tid = omp_get_thread_num();
+    auto inst = page[i];
+    for (bst_uint j = 0; j < inst.size(); ++j) {
+      builder.Push(
+          inst[j].index,
+          Entry(static_cast<bst_uint>(this->base_rowid + i), inst[j].fvalue),
+          tid);
+    }
+  }
+  return transpose;
+}
+
 class BatchIteratorImpl {
  public:
   virtual ~BatchIteratorImpl() {}
@@ -393,6 +435,10 @@ class RowSet {
   std::vector<bst_uint> rows_;
 };
 
+namespace common {
+struct QuantizedMatrix;
+}  // namespace common
+
 /*!
  * \brief Internal data structured used by XGBoost during training.
  *  There are two ways to create a customized DMatrix that reads in user defined-format.
@@ -422,6 +468,26 @@ class DMatrix {
   virtual bool SingleColBlock() const = 0;
   /*! \brief get column density */
   virtual float GetColDensity(size_t cidx) = 0;
+  /*!
+   * \brief Append rows to the end of the matrix in place.
+   *  Column pages derived from the rows are rebuilt on their next use, and
+   *  consumers caching per row data detect the change by the row count.
+   *  Only in-memory matrices support this.
+   * \param page The new rows, their feature indices must be below Info().num_col_
+   *  unless the matrix is empty.
+   * \param info Meta information of the new rows. Labels, weights, base margins,
+   *  query ids and groups are required exactly when the matrix has them.
+   */
+  virtual void AppendRows(const SparsePage& page, const MetaInfo& info);
+  /*!
+   * \brief Quantized copy of the data shared by the boosters training on this
+   *  matrix with the hist updater. It is built by the first of them or loaded
+   *  along with a binary file, and saved with SaveToLocalFile.
+   *  Hold QuantizedMutex() while accessing it from concurrent boosters.
+   */
+  std::shared_ptr<common::QuantizedMatrix>& Quantized() { return quantized_; }
+  /*! \brief lock of Quantized() */
+  std::mutex& QuantizedMutex() { return quantized_mutex_; }
   /*! \brief virtual destructor */
   virtual ~DMatrix() = default;
   /*!
@@ -475,6 +541,10 @@ class DMatrix {
 
   /*! \brief page size 32 MB */
   static const size_t kPageSize = 32UL << 20UL;
+
+ private:
+  std::shared_ptr<common::QuantizedMatrix> quantized_;
+  std::mutex quantized_mutex_;
 };
 
 // implementation of inline functions
@@ -98,6 +98,19 @@ class GradientBooster {
                        std::vector<bst_float>* out_preds,
                        unsigned ntree_limit = 0,
                        unsigned root_index = 0) = 0;
+  /*!
+   * \brief predict the rows of a dense row-major matrix without building a DMatrix
+   * \param data nrow * ncol feature values, values equal to missing or NaN are missing
+   * \param nrow number of rows
+   * \param ncol number of columns
+   * \param missing value marking missing features
+   * \param out_preds caller-owned buffer of nrow * num_output_group margins
+   * \param ntree_limit limit the number of trees used in prediction, when it equals 0, this means
+   *    we do not limit number of trees, this parameter is only valid for gbtree, but not for gblinear
+   */
+  virtual void PredictDense(const bst_float* data, size_t nrow, size_t ncol,
+                            bst_float missing, bst_float* out_preds,
+                            unsigned ntree_limit = 0) = 0;
   /*!
    * \brief predict the leaf index of each tree, the output will be nsample * ntree vector
    *        this is only valid in gbtree predictor
@@ -108,6 +108,9 @@ class Learner : public rabit::Serializable {
    * \param pred_contribs whether to only predict the feature contributions
    * \param approx_contribs whether to approximate the feature contributions for speed
    * \param pred_interactions whether to compute the feature pair contributions
+   *
+   *  Predictions with cpu_predictor can run concurrently from several threads,
+   *  as long as the model is not updated at the same time.
    */
   virtual void Predict(DMatrix* data,
                        bool output_margin,
@@ -117,6 +120,23 @@ class Learner : public rabit::Serializable {
                        bool pred_contribs = false,
                        bool approx_contribs = false,
                        bool pred_interactions = false) const = 0;
+  /*!
+   * \brief get prediction for the rows of a dense row-major matrix, read in place
+   *  without building a DMatrix.
+   * \param data nrow * ncol feature values
+   * \param nrow number of rows
+   * \param ncol number of columns
+   * \param missing value marking missing features, NaN is always missing
+   * \param output_margin whether to only predict margin value instead of transformed prediction
+   * \param out_preds caller-owned buffer of nrow * max(num_class, 1) values, all
+   *   of which are written except for the transformed output of multi:softmax,
+   *   which fills only the first nrow with the predicted class
+   * \param ntree_limit limit number of trees used for boosted tree
+   *   predictor, when it equals 0, this means we are using all the trees
+   */
+  virtual void PredictDense(const bst_float* data, size_t nrow, size_t ncol,
+                            bst_float missing, bool output_margin,
+                            bst_float* out_preds, unsigned ntree_limit = 0) const = 0;
 
   /*!
    * \brief Set additional attribute to the Booster.
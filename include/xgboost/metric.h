@@ -11,6 +11,7 @@
 #include <vector>
 #include <string>
 #include <functional>
+#include <memory>
 #include <utility>
 
 #include "./data.h"
@@ -64,6 +65,20 @@ class Metric {
    * \return the created metric.
    */
   static Metric* Create(const std::string& name);
+  /*!
+   * \brief evaluate several metrics on the same predictions. The elementwise
+   *  metrics are reduced together in one pass over the data, and the rank
+   *  metrics share one sort of the predictions.
+   * \param metrics the metrics to evaluate
+   * \param preds prediction
+   * \param info information, including label etc.
+   * \param distributed whether a call to Allreduce is needed, as in Eval
+   * \return the value of each metric
+   */
+  static std::vector<bst_float> EvalMany(const std::vector<std::unique_ptr<Metric> >& metrics,
+                                         const HostDeviceVector<bst_float>& preds,
+                                         const MetaInfo& info,
+                                         bool distributed);
 };
 
 /*!
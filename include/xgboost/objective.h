@@ -53,7 +53,9 @@ class ObjFunction {
   virtual const char* DefaultEvalMetric() const = 0;
   // the following functions are optional, most of time default implementation is good enough
   /*!
-   * \brief transform prediction values, this is only called when Prediction is called
+   * \brief transform prediction values, this is only called when Prediction is called.
+   *  Several threads can predict with the same learner at once, so the
+   *  transformation must not modify the objective.
    * \param io_preds prediction values, saves to this vector as well
    */
   virtual void PredTransform(HostDeviceVector<bst_float> *io_preds) {}
@@ -113,6 +113,27 @@ class Predictor {
                                unsigned ntree_limit = 0,
                                unsigned root_index = 0) = 0;
 
+  /**
+   * \brief Predict rows of a dense row-major matrix in place, without building
+   * a DMatrix. Values equal to missing, or NaN, are treated as missing. The
+   * default implementation reports that the predictor does not support it.
+   *
+   * \param           data        Row-major buffer of nrow * ncol values.
+   * \param           nrow        Number of rows.
+   * \param           ncol        Number of columns.
+   * \param           missing     Value marking a missing feature.
+   * \param [out]     out_preds   Caller-owned buffer of nrow * num_output_group
+   * margins.
+   * \param           model       The model to predict from.
+   * \param           ntree_limit (Optional) The ntree limit. 0 means do not
+   * limit trees.
+   */
+
+  virtual void PredictDense(const bst_float* data, size_t nrow, size_t ncol,
+                            bst_float missing, bst_float* out_preds,
+                            const gbm::GBTreeModel& model,
+                            unsigned ntree_limit = 0);
+
   /**
    * \fn  virtual void Predictor::PredictLeaf(DMatrix* dmat,
    * std::vector<bst_float>* out_preds, const gbm::GBTreeModel& model, unsigned
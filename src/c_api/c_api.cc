@@ -12,15 +12,20 @@
 #include <cstdio>
 #include <cstring>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
 #include <vector>
 #include <string>
 #include <memory>
+#include <utility>
 
 #include "./c_api_error.h"
 #include "../data/simple_csr_source.h"
 #include "../common/math.h"
 #include "../common/io.h"
 #include "../common/group_data.h"
+#include "../common/quantized_matrix.h"
+#include "../tree/param.h"
 
 
 namespace xgboost {
@@ -30,6 +35,7 @@ class Booster {
   explicit Booster(const std::vector<std::shared_ptr<DMatrix> >& cache_mats)
       : configured_(false),
         initialized_(false),
+        ready_(false),
         learner_(Learner::Create(cache_mats)) {}
 
   inline Learner* learner() {  // NOLINT
@@ -55,6 +61,11 @@ class Booster {
   }
 
   inline void LazyInit() {
+    // predictions from several threads only take the lock before the first one
+    if (ready_.load(std::memory_order_acquire)) {
+      return;
+    }
+    std::lock_guard<std::mutex> guard(init_mutex_);
     if (!configured_) {
       LoadSavedParamFromAttr();
       learner_->Configure(cfg_);
@@ -64,6 +75,7 @@ class Booster {
       learner_->InitModel();
       initialized_ = true;
     }
+    ready_.store(true, std::memory_order_release);
   }
 
   inline void LoadSavedParamFromAttr() {
@@ -96,6 +108,9 @@ class Booster {
  private:
   bool configured_;
   bool initialized_;
+  // configured_ and initialized_ are both set
+  std::atomic<bool> ready_;
+  std::mutex init_mutex_;
   std::unique_ptr<Learner> learner_;
   std::vector<std::pair<std::string, std::string> > cfg_;
 };
@@ -220,8 +235,8 @@ struct XGBAPIThreadLocalEntry {
   std::vector<std::string> ret_vec_str;
   /*! \brief result holder for returning string pointers */
   std::vector<const char *> ret_vec_charp;
-  /*! \brief returning float vector. */
-  std::vector<bst_float> ret_vec_float;
+  /*! \brief returning predictions, reused by the predictions of the thread. */
+  HostDeviceVector<bst_float> ret_vec_preds;
   /*! \brief temp variable of gradient pairs. */
   std::vector<GradientPair> tmp_gpair;
 };
@@ -729,6 +744,55 @@ XGB_DLL int XGDMatrixSliceDMatrix(DMatrixHandle handle,
   API_END();
 }
 
+XGB_DLL int XGDMatrixAppendRows(DMatrixHandle handle,
+                                const size_t* indptr,
+                                const unsigned* indices,
+                                const bst_float* data,
+                                size_t nindptr,
+                                size_t nelem,
+                                const bst_float* label,
+                                const bst_float* weight) {
+  API_BEGIN();
+  CHECK_HANDLE();
+  SparsePage page;
+  MetaInfo info;
+  auto& offset_vec = page.offset.HostVector();
+  auto& data_vec = page.data.HostVector();
+  offset_vec.reserve(nindptr);
+  data_vec.reserve(nelem);
+  for (size_t i = 1; i < nindptr; ++i) {
+    for (size_t j = indptr[i - 1]; j < indptr[i]; ++j) {
+      if (!common::CheckNAN(data[j])) {
+        // automatically skip nan.
+        data_vec.emplace_back(Entry(indices[j], data[j]));
+      }
+    }
+    offset_vec.push_back(page.data.Size());
+  }
+  const size_t num_row = nindptr == 0 ? 0 : nindptr - 1;
+  if (label != nullptr) {
+    info.labels_.HostVector().assign(label, label + num_row);
+  }
+  if (weight != nullptr) {
+    info.weights_.HostVector().assign(weight, weight + num_row);
+  }
+  static_cast<std::shared_ptr<DMatrix>*>(handle)->get()->AppendRows(page, info);
+  API_END();
+}
+
+XGB_DLL int XGDMatrixQuantize(DMatrixHandle handle, int max_bin) {
+  API_BEGIN();
+  CHECK_HANDLE();
+  tree::TrainParam param;
+  param.InitAllowUnknown(
+      std::vector<std::pair<std::string, std::string> >{{"max_bin", std::to_string(max_bin)}});
+  DMatrix* dmat = static_cast<std::shared_ptr<DMatrix>*>(handle)->get();
+  std::lock_guard<std::mutex> guard(dmat->QuantizedMutex());
+  dmat->Quantized() =
+      common::QuantizedMatrix::Create(dmat, param.max_bin, param.sparse_threshold);
+  API_END();
+}
+
 XGB_DLL int XGDMatrixFree(DMatrixHandle handle) {
   API_BEGIN();
   CHECK_HANDLE();
@@ -935,24 +999,69 @@ XGB_DLL int XGBoosterPredict(BoosterHandle handle,
                              unsigned ntree_limit,
                              xgboost::bst_ulong *len,
                              const bst_float **out_result) {
-  std::vector<bst_float>&preds =
-    XGBAPIThreadLocalStore::Get()->ret_vec_float;
+  HostDeviceVector<bst_float>& preds =
+    XGBAPIThreadLocalStore::Get()->ret_vec_preds;
+  API_BEGIN();
+  CHECK_HANDLE();
+  auto *bst = static_cast<Booster*>(handle);
+  bst->LazyInit();
+  bst->learner()->Predict(
+      static_cast<std::shared_ptr<DMatrix>*>(dmat)->get(),
+      (option_mask & 1) != 0,
+      &preds, ntree_limit,
+      (option_mask & 2) != 0,
+      (option_mask & 4) != 0,
+      (option_mask & 8) != 0,
+      (option_mask & 16) != 0);
+  *out_result = dmlc::BeginPtr(preds.HostVector());
+  *len = static_cast<xgboost::bst_ulong>(preds.Size());
+  API_END();
+}
+
+XGB_DLL int XGBoosterPredictToBuffer(BoosterHandle handle,
+                                     DMatrixHandle dmat,
+                                     int option_mask,
+                                     unsigned ntree_limit,
+                                     xgboost::bst_ulong out_size,
+                                     bst_float *out_result,
+                                     xgboost::bst_ulong *out_len) {
+  HostDeviceVector<bst_float>& preds =
+    XGBAPIThreadLocalStore::Get()->ret_vec_preds;
   API_BEGIN();
   CHECK_HANDLE();
   auto *bst = static_cast<Booster*>(handle);
   bst->LazyInit();
-  HostDeviceVector<bst_float> tmp_preds;
   bst->learner()->Predict(
       static_cast<std::shared_ptr<DMatrix>*>(dmat)->get(),
       (option_mask & 1) != 0,
-      &tmp_preds, ntree_limit,
+      &preds, ntree_limit,
       (option_mask & 2) != 0,
       (option_mask & 4) != 0,
       (option_mask & 8) != 0,
       (option_mask & 16) != 0);
-  preds = tmp_preds.HostVector();
-  *out_result = dmlc::BeginPtr(preds);
-  *len = static_cast<xgboost::bst_ulong>(preds.size());
+  *out_len = static_cast<xgboost::bst_ulong>(preds.Size());
+  CHECK_LE(preds.Size(), out_size)
+      << "Output buffer is too small, " << preds.Size() << " predictions are needed";
+  std::copy(preds.HostVector().begin(), preds.HostVector().end(), out_result);
+  API_END();
+}
+
+XGB_DLL int XGBoosterPredictFromDense(BoosterHandle handle,
+                                      const bst_float *data,
+                                      xgboost::bst_ulong nrow,
+                                      xgboost::bst_ulong ncol,
+                                      bst_float missing,
+                                      int option_mask,
+                                      unsigned ntree_limit,
+                                      bst_float *out_result) {
+  API_BEGIN();
+  CHECK_HANDLE();
+  CHECK_EQ(option_mask & ~1, 0)
+      << "XGBoosterPredictFromDense only supports the output margin option";
+  auto *bst = static_cast<Booster*>(handle);
+  bst->LazyInit();
+  bst->learner()->PredictDense(data, static_cast<size_t>(nrow), static_cast<size_t>(ncol),
+                               missing, (option_mask & 1) != 0, out_result, ntree_limit);
   API_END();
 }
 
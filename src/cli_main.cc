@@ -15,12 +15,15 @@
 #include <dmlc/timer.h>
 #include <iomanip>
 #include <ctime>
+#include <memory>
 #include <string>
 #include <cstdio>
 #include <cstring>
 #include <vector>
 #include "./common/common.h"
 #include "./common/config.h"
+#include "./common/io.h"
+#include "./data/parser_batches.h"
 
 
 namespace xgboost {
@@ -31,6 +34,11 @@ enum CLITask {
   kPredict = 2
 };
 
+enum CLIPredFormat {
+  kPredText = 0,
+  kPredBinary = 1
+};
+
 struct CLIParam : public dmlc::Parameter<CLIParam> {
   /*! \brief the task name */
   int task;
@@ -58,6 +66,10 @@ struct CLIParam : public dmlc::Parameter<CLIParam> {
   int ntree_limit;
   /*!\brief whether to directly output margin value */
   bool pred_margin;
+  /*! \brief number of test rows predicted at a time, 0 means all at once */
+  int pred_batch_rows;
+  /*! \brief format of the prediction file */
+  int pred_format;
   /*! \brief whether dump statistics along with model */
   int dump_stats;
   /*! \brief what format to dump the model in */
@@ -108,6 +120,13 @@ struct CLIParam : public dmlc::Parameter<CLIParam> {
         .describe("Number of trees used for prediction, 0 means use all trees.");
     DMLC_DECLARE_FIELD(pred_margin).set_default(false)
         .describe("Whether to predict margin value instead of probability.");
+    DMLC_DECLARE_FIELD(pred_batch_rows).set_default(0).set_lower_bound(0)
+        .describe("Number of test rows predicted at a time, 0 loads the whole test set. "
+                  "A positive value streams test:data through the parser in batches.");
+    DMLC_DECLARE_FIELD(pred_format).set_default(kPredText)
+        .add_enum("text", kPredText)
+        .add_enum("binary", kPredBinary)
+        .describe("Format of the prediction file, one value per line or raw floats.");
     DMLC_DECLARE_FIELD(dump_stats).set_default(false)
         .describe("Whether dump the model statistics.");
     DMLC_DECLARE_FIELD(dump_format).set_default("text")
@@ -300,15 +319,42 @@ void CLIDumpModel(const CLIParam& param) {
   os.set_stream(nullptr);
 }
 
+/*!
+ * \brief predict test:data in batches of pred_batch_rows rows as the parser
+ *  reads it, so only one batch is held in memory while the parser prefetches
+ *  the next chunk of the file
+ */
+void CLIPredictStream(const CLIParam& param, Learner* learner, dmlc::Stream* fo) {
+  CHECK_EQ(param.test_path.find('#'), std::string::npos)
+      << "An external memory cache cannot be used with pred_batch_rows.";
+  int partid = 0, npart = 1;
+  if (param.dsplit == 2) {
+    partid = rabit::GetRank();
+    npart = rabit::GetWorldSize();
+  } else {
+    // DMatrix::Load would add the margins of this file to the predictions
+    std::unique_ptr<dmlc::Stream> margin(
+        dmlc::Stream::Create((param.test_path + ".base_margin").c_str(), "r", true));
+    CHECK(margin == nullptr)
+        << param.test_path << ".base_margin is not read when streaming the "
+        << "prediction, set pred_batch_rows=0 to use it.";
+  }
+  std::unique_ptr<dmlc::Parser<uint32_t> > parser(
+      dmlc::Parser<uint32_t>::Create(param.test_path.c_str(), partid, npart, "auto"));
+  data::ParserBatches batches(parser.get(), static_cast<size_t>(param.pred_batch_rows));
+  HostDeviceVector<bst_float> preds;
+  size_t num_row = 0;
+  while (batches.Next()) {
+    num_row += batches.Value()->Info().num_row_;
+    learner->Predict(batches.Value(), param.pred_margin, &preds, param.ntree_limit);
+    common::WritePredictions(preds.ConstHostVector(), param.pred_format == kPredBinary, fo);
+  }
+  LOG(INFO) << "predicted " << num_row << " rows in batches of " << param.pred_batch_rows;
+}
+
 void CLIPredict(const CLIParam& param) {
   CHECK_NE(param.test_path, "NULL")
       << "Test dataset parameter test:data must be specified.";
-  // load data
-  std::unique_ptr<DMatrix> dtest(
-      DMatrix::Load(
-          param.test_path,
-          ConsoleLogger::GlobalVerbosity() > ConsoleLogger::DefaultVerbosity(),
-          param.dsplit == 2));
   // load model
   CHECK_NE(param.model_in, "NULL")
       << "Must specify model_in for predict";
@@ -318,6 +364,20 @@ void CLIPredict(const CLIParam& param) {
   learner->Load(fi.get());
   learner->Configure(param.cfg);
 
+  if (param.pred_batch_rows != 0) {
+    LOG(CONSOLE) << "streaming prediction to " << param.name_pred;
+    std::unique_ptr<dmlc::Stream> fo(
+        dmlc::Stream::Create(param.name_pred.c_str(), "w"));
+    CLIPredictStream(param, learner.get(), fo.get());
+    return;
+  }
+  // load data
+  std::unique_ptr<DMatrix> dtest(
+      DMatrix::Load(
+          param.test_path,
+          ConsoleLogger::GlobalVerbosity() > ConsoleLogger::DefaultVerbosity(),
+          param.dsplit == 2));
+
   LOG(INFO) << "start prediction...";
   HostDeviceVector<bst_float> preds;
   learner->Predict(dtest.get(), param.pred_margin, &preds, param.ntree_limit);
@@ -325,13 +385,8 @@ void CLIPredict(const CLIParam& param) {
 
   std::unique_ptr<dmlc::Stream> fo(
       dmlc::Stream::Create(param.name_pred.c_str(), "w"));
-  dmlc::ostream os(fo.get());
-  for (bst_float p : preds.ConstHostVector()) {
-    os << std::setprecision(std::numeric_limits<bst_float>::max_digits10)
-       << p << '\n';
-  }
-  // force flush before fo destruct.
-  os.set_stream(nullptr);
+  common::WritePredictions(preds.ConstHostVector(), param.pred_format == kPredBinary,
+                           fo.get());
 }
 
 int CLIRunTask(int argc, char *argv[]) {
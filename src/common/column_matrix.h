@@ -24,10 +24,12 @@ enum ColumnType {
 };
 
 /*! \brief a column storage, to be used with ApplySplit. Note that each
-    bin id is stored as index[i] + index_base. */
+    bin id is stored as index[i] + index_base. The maximum value of BinIdxType
+    marks a missing value. */
+template <typename BinIdxType>
 class Column {
  public:
-  Column(ColumnType type, const uint32_t* index, uint32_t index_base,
+  Column(ColumnType type, const BinIdxType* index, uint32_t index_base,
          const size_t* row_ind, size_t len)
       : type_(type),
         index_(index),
@@ -35,8 +37,10 @@ class Column {
         row_ind_(row_ind),
         len_(len) {}
   size_t Size() const { return len_; }
-  uint32_t GetGlobalBinIdx(size_t idx) const { return index_base_ + index_[idx]; }
-  uint32_t GetFeatureBinIdx(size_t idx) const { return index_[idx]; }
+  uint32_t GetGlobalBinIdx(size_t idx) const {
+    return index_base_ + static_cast<uint32_t>(index_[idx]);
+  }
+  BinIdxType GetFeatureBinIdx(size_t idx) const { return index_[idx]; }
   // column.GetFeatureBinIdx(idx) + column.GetBaseIdx(idx) ==
   // column.GetGlobalBinIdx(idx)
   uint32_t GetBaseIdx() const { return index_base_; }
@@ -47,13 +51,13 @@ class Column {
     return type_ == ColumnType::kDenseColumn ? idx : row_ind_[idx];  // NOLINT
   }
   bool IsMissing(size_t idx) const {
-    return index_[idx] == std::numeric_limits<uint32_t>::max();
+    return index_[idx] == std::numeric_limits<BinIdxType>::max();
   }
   const size_t* GetRowData() const { return row_ind_; }
 
  private:
   ColumnType type_;
-  const uint32_t* index_;
+  const BinIdxType* index_;
   uint32_t index_base_;
   const size_t* row_ind_;
   const size_t len_;
@@ -114,7 +118,9 @@ class ColumnMatrix {
       boundary_[fid].row_ind_end = accum_row_ind_;
     }
 
-    index_.resize(boundary_[nfeature - 1].index_end);
+    // feature-local bins are stored in the same width as dense GHistIndexMatrix
+    bins_type_size_ = GetBinTypeSize(gmat.GetMaxBinsPerFeature());
+    index_.resize(boundary_[nfeature - 1].index_end * bins_type_size_);
     row_ind_.resize(boundary_[nfeature - 1].row_ind_end);
 
     // store least bin id for each feature
@@ -123,21 +129,85 @@ class ColumnMatrix {
       index_base_[fid] = gmat.cut.row_ptr[fid];
     }
 
+    switch (bins_type_size_) {
+      case kUint8BinsTypeSize:
+        SetIndex<uint8_t>(gmat);
+        break;
+      case kUint16BinsTypeSize:
+        SetIndex<uint16_t>(gmat);
+        break;
+      default:
+        SetIndex<uint32_t>(gmat);
+    }
+  }
+
+  /* Fetch an individual column. BinIdxType must match GetTypeSize() */
+  template <typename BinIdxType>
+  inline Column<BinIdxType> GetColumn(unsigned fid) const {
+    CHECK_EQ(sizeof(BinIdxType), bins_type_size_);
+    const BinIdxType* index = reinterpret_cast<const BinIdxType*>(index_.data());
+    Column<BinIdxType> c(type_[fid], index + boundary_[fid].index_begin, index_base_[fid],
+                         (type_[fid] == ColumnType::kSparseColumn ?
+                          &row_ind_[boundary_[fid].row_ind_begin] : nullptr),
+                         boundary_[fid].index_end - boundary_[fid].index_begin);
+    return c;
+  }
+
+  inline BinTypeSize GetTypeSize() const {
+    return bins_type_size_;
+  }
+
+ private:
+  struct ColumnBoundary {
+    // indicate where each column's index and row_ind is stored.
+    // index_begin and index_end are logical offsets, counted in elements of
+    // the bin type given by bins_type_size_
+    size_t index_begin;
+    size_t index_end;
+    size_t row_ind_begin;
+    size_t row_ind_end;
+  };
+
+  template <typename BinIdxType>
+  inline void SetIndex(const GHistIndexMatrix& gmat) {
+    const int32_t nfeature = static_cast<int32_t>(gmat.cut.row_ptr.size() - 1);
+    const size_t nrow = gmat.row_ptr.size() - 1;
+    BinIdxType* local_index = reinterpret_cast<BinIdxType*>(index_.data());
+
+    if (gmat.index.IsDense()) {
+      // no missing values, so every column is dense; gmat already holds
+      // feature-local bins of the same width, stored row by row
+      CHECK_EQ(gmat.index.GetBinTypeSize(), bins_type_size_);
+      for (int32_t fid = 0; fid < nfeature; ++fid) {
+        CHECK(type_[fid] == kDenseColumn);
+      }
+      const BinIdxType* gmat_index = gmat.index.data<BinIdxType>();
+      #pragma omp parallel for
+      for (int32_t fid = 0; fid < nfeature; ++fid) {
+        BinIdxType* begin = &local_index[boundary_[fid].index_begin];
+        for (size_t rid = 0; rid < nrow; ++rid) {
+          begin[rid] = gmat_index[rid * nfeature + fid];
+        }
+      }
+      return;
+    }
+
     // pre-fill index_ for dense columns
 
     #pragma omp parallel for
     for (int32_t fid = 0; fid < nfeature; ++fid) {
       if (type_[fid] == kDenseColumn) {
         const size_t ibegin = boundary_[fid].index_begin;
-        uint32_t* begin = &index_[ibegin];
-        uint32_t* end = begin + nrow;
-        std::fill(begin, end, std::numeric_limits<uint32_t>::max());
+        BinIdxType* begin = &local_index[ibegin];
+        BinIdxType* end = begin + nrow;
+        std::fill(begin, end, std::numeric_limits<BinIdxType>::max());
         // max() indicates missing values
       }
     }
 
     // loop over all rows and fill column entries
     // num_nonzeros[fid] = how many nonzeros have this feature accumulated so far?
+    const uint32_t* gmat_index = gmat.index.data<uint32_t>();
     std::vector<size_t> num_nonzeros;
     num_nonzeros.resize(nfeature);
     std::fill(num_nonzeros.begin(), num_nonzeros.end(), 0);
@@ -146,16 +216,16 @@ class ColumnMatrix {
       const size_t iend = gmat.row_ptr[rid + 1];
       size_t fid = 0;
       for (size_t i = ibegin; i < iend; ++i) {
-        const uint32_t bin_id = gmat.index[i];
+        const uint32_t bin_id = gmat_index[i];
         while (bin_id >= gmat.cut.row_ptr[fid + 1]) {
           ++fid;
         }
+        BinIdxType* begin = &local_index[boundary_[fid].index_begin];
+        const auto local_bin = static_cast<BinIdxType>(bin_id - index_base_[fid]);
         if (type_[fid] == kDenseColumn) {
-          uint32_t* begin = &index_[boundary_[fid].index_begin];
-          begin[rid] = bin_id - index_base_[fid];
+          begin[rid] = local_bin;
         } else {
-          uint32_t* begin = &index_[boundary_[fid].index_begin];
-          begin[num_nonzeros[fid]] = bin_id - index_base_[fid];
+          begin[num_nonzeros[fid]] = local_bin;
           row_ind_[boundary_[fid].row_ind_begin + num_nonzeros[fid]] = rid;
           ++num_nonzeros[fid];
         }
@@ -163,30 +233,11 @@ class ColumnMatrix {
     }
   }
 
-  /* Fetch an individual column. This code should be used with XGBOOST_TYPE_SWITCH
-     to determine type of bin id's */
-  inline Column GetColumn(unsigned fid) const {
-    Column c(type_[fid], &index_[boundary_[fid].index_begin], index_base_[fid],
-             (type_[fid] == ColumnType::kSparseColumn ?
-              &row_ind_[boundary_[fid].row_ind_begin] : nullptr),
-             boundary_[fid].index_end - boundary_[fid].index_begin);
-    return c;
-  }
-
- private:
-  struct ColumnBoundary {
-    // indicate where each column's index and row_ind is stored.
-    // index_begin and index_end are logical offsets, so they should be converted to
-    // actual offsets by scaling with packing_factor_
-    size_t index_begin;
-    size_t index_end;
-    size_t row_ind_begin;
-    size_t row_ind_end;
-  };
-
   std::vector<size_t> feature_counts_;
   std::vector<ColumnType> type_;
-  SimpleArray<uint32_t> index_;  // index_: may store smaller integers; needs padding
+  // feature-local bin ids, each stored in bins_type_size_ bytes
+  SimpleArray<uint8_t> index_;
+  BinTypeSize bins_type_size_{kUint32BinsTypeSize};
   SimpleArray<size_t> row_ind_;
   std::vector<ColumnBoundary> boundary_;
 
@@ -4,7 +4,11 @@
  */
 #include <rabit/rabit.h>
 #include <dmlc/omp.h>
+#include <algorithm>
+#include <cmath>
 #include <numeric>
+#include <random>
+#include <unordered_set>
 #include <vector>
 
 #include "./random.h"
@@ -42,24 +46,172 @@ size_t HistCutMatrix::SearchGroupIndFromBaseRow(
   return group_ind;
 }
 
-void HistCutMatrix::Init(DMatrix* p_fmat, uint32_t max_num_bins) {
+namespace {
+/*!
+ * \brief Entries of a block of rows grouped by feature and sorted by value, the
+ *  row-parallel first phase of HistCutMatrix::Init. The blocks are then merged
+ *  into the sketch of each feature in parallel over features.
+ */
+class SketchBlock {
+ public:
+  using WXQSketch = HistCutMatrix::WXQSketch;
+  using QEntry = WXQSketch::Summary::Queue::QEntry;
+
+  void Build(const SparsePageView& page, size_t begin, size_t end, size_t ncol,
+             const MetaInfo& info, bool use_group_ind) {
+    col_ptr_.assign(ncol + 1, 0);
+    for (size_t i = begin; i < end; ++i) {
+      for (auto const& entry : page[i]) {
+        ++col_ptr_[entry.index + 1];
+      }
+    }
+    for (size_t fid = 0; fid < ncol; ++fid) {
+      col_ptr_[fid + 1] += col_ptr_[fid];
+    }
+    entries_.resize(col_ptr_.back());
+    pos_.assign(col_ptr_.begin(), col_ptr_.end() - 1);
+    // weights are given per group in ranking
+    std::vector<bst_uint> const& group_ptr = info.group_ptr_;
+    size_t group_ind = 0;
+    if (use_group_ind && begin < end) {
+      group_ind = std::upper_bound(group_ptr.cbegin(), group_ptr.cend(),
+                                   page.base_rowid + begin) - group_ptr.cbegin() - 1;
+    }
+    for (size_t i = begin; i < end; ++i) {
+      size_t const ridx = page.base_rowid + i;
+      while (use_group_ind && group_ptr[group_ind + 1] <= ridx) {
+        ++group_ind;
+      }
+      bst_float const w = info.GetWeight(use_group_ind ? group_ind : ridx);
+      for (auto const& entry : page[i]) {
+        entries_[pos_[entry.index]++] = QEntry(entry.fvalue, w);
+      }
+    }
+    for (size_t fid = 0; fid < ncol; ++fid) {
+      if (col_ptr_[fid + 1] - col_ptr_[fid] > 1) {
+        std::sort(entries_.begin() + col_ptr_[fid], entries_.begin() + col_ptr_[fid + 1]);
+      }
+    }
+  }
+
+  /*!
+   * \brief add the entries of feature fid to its sketch; a large run is turned into
+   *  an exact summary and merged at once instead of going through the input queue
+   */
+  void Push(bst_uint fid, size_t summary_threshold, WXQSketch* sketch,
+            WXQSketch::SummaryContainer* temp) const {
+    const QEntry* begin = entries_.data() + col_ptr_[fid];
+    const QEntry* end = entries_.data() + col_ptr_[fid + 1];
+    if (static_cast<size_t>(end - begin) < summary_threshold) {
+      for (const QEntry* it = begin; it != end; ++it) {
+        sketch->Push(it->value, it->weight);
+      }
+      return;
+    }
+    temp->Reserve(end - begin);
+    temp->size = 0;
+    bst_float wsum = 0;
+    for (const QEntry* it = begin; it != end;) {
+      const QEntry* next = it + 1;
+      bst_float w = it->weight;
+      while (next != end && next->value == it->value) {
+        w += next->weight;
+        ++next;
+      }
+      if (w != 0) {
+        temp->data[temp->size++] = WXQSketch::Entry(wsum, wsum + w, w, it->value);
+        wsum += w;
+      }
+      it = next;
+    }
+    if (temp->size != 0) {
+      sketch->PushSummary(*temp);
+    }
+  }
+
+ private:
+  /*! \brief position of the entries of each feature */
+  std::vector<size_t> col_ptr_;
+  /*! \brief write position of each feature while building */
+  std::vector<size_t> pos_;
+  /*! \brief (value, weight) of the entries, feature by feature */
+  std::vector<QEntry> entries_;
+};
+
+/*!
+ * \brief Draw about sample_rows rows of p_fmat for sketching the cuts.
+ *  Every group of a ranking dataset is a stratum getting a share of the sample
+ *  proportional to its size, and at least one row. The rows of a stratum are
+ *  chosen uniformly without replacement with Floyd's algorithm, and their weight
+ *  is divided by the sampling rate of the stratum. The weighted distribution of
+ *  the sample is then an unbiased estimate of the one of the full data, also
+ *  when the summaries of workers with different numbers of rows are merged.
+ */
+void SampleRows(DMatrix* p_fmat, size_t sample_rows, bool use_group_ind,
+                SparsePage* out, MetaInfo* out_info) {
+  const MetaInfo& info = p_fmat->Info();
+  std::vector<size_t> strata {0, info.num_row_};
+  if (info.group_ptr_.size() > 1) {
+    strata.assign(info.group_ptr_.cbegin(), info.group_ptr_.cend());
+    CHECK_EQ(strata.back(), info.num_row_) << "Groups do not cover the rows of the data";
+  }
+  const double rate = static_cast<double>(sample_rows) / info.num_row_;
+  auto& rng = common::GlobalRandom();
+  // sorted ids of the chosen rows, with their stratum
+  std::vector<size_t> rows;
+  std::vector<size_t> row_stratum;
+  // inverse of the sampling rate of each stratum
+  std::vector<bst_float> scale(strata.size() - 1, 0.0f);
+  std::unordered_set<size_t> chosen;
+  for (size_t s = 0; s + 1 < strata.size(); ++s) {
+    const size_t n = strata[s + 1] - strata[s];
+    if (n == 0) continue;
+    const size_t quota = std::min(n, std::max(static_cast<size_t>(1),
+                                              static_cast<size_t>(std::llround(n * rate))));
+    chosen.clear();
+    for (size_t j = n - quota; j < n; ++j) {
+      const size_t t = std::uniform_int_distribution<size_t>(0, j)(rng);
+      if (!chosen.insert(t).second) {
+        chosen.insert(j);
+      }
+    }
+    const size_t first = rows.size();
+    for (size_t i : chosen) {
+      rows.push_back(strata[s] + i);
+    }
+    std::sort(rows.begin() + first, rows.end());
+    row_stratum.resize(rows.size(), s);
+    scale[s] = static_cast<bst_float>(n) / quota;
+  }
+
+  auto& weights = out_info->weights_.HostVector();
+  weights.clear();
+  size_t k = 0;
+  for (const auto &batch : p_fmat->GetRowBatches()) {
+    const SparsePageView page(batch);
+    for (; k < rows.size() && rows[k] < page.base_rowid + page.Size(); ++k) {
+      const size_t ridx = rows[k];
+      const size_t s = row_stratum[k];
+      out->Push(page[ridx - page.base_rowid]);
+      weights.push_back(info.GetWeight(use_group_ind ? s : ridx) * scale[s]);
+    }
+  }
+  out_info->num_row_ = rows.size();
+  out_info->num_col_ = info.num_col_;
+  out_info->num_nonzero_ = out->data.Size();
+}
+}  // anonymous namespace
+
+void HistCutMatrix::Init(DMatrix* p_fmat, uint32_t max_num_bins, size_t sketch_sample_rows) {
   monitor_.Start("Init");
   const MetaInfo& info = p_fmat->Info();
 
   // safe factor for better accuracy
   constexpr int kFactor = 8;
+  // entries handled by a thread in each round of the sketch
+  constexpr size_t kBlockEntries = 1 << 16;
   std::vector<WXQSketch> sketchs;
 
-  const size_t nthread = omp_get_max_threads();
-
-  unsigned const nstep =
-      static_cast<unsigned>((info.num_col_ + nthread - 1) / nthread);
-  unsigned const ncol = static_cast<unsigned>(info.num_col_);
-  sketchs.resize(info.num_col_);
-  for (auto& s : sketchs) {
-    s.Init(info.num_row_, 1.0 / (max_num_bins * kFactor));
-  }
-
   const auto& weights = info.weights_.HostVector();
 
   // Data groups, used in ranking.
@@ -68,89 +220,78 @@ void HistCutMatrix::Init(DMatrix* p_fmat, uint32_t max_num_bins) {
   // Use group index for weights?
   bool const use_group_ind = num_groups != 0 && weights.size() != info.num_row_;
 
-  if (use_group_ind) {
-    for (const auto &batch : p_fmat->GetRowBatches()) {
-      size_t group_ind = this->SearchGroupIndFromBaseRow(group_ptr, batch.base_rowid);
-      #pragma omp parallel num_threads(nthread) firstprivate(group_ind, use_group_ind)
+  // sketch a sample of the rows, which carries its own weights
+  SparsePage sample;
+  MetaInfo sample_info;
+  const bool use_sample = sketch_sample_rows != 0 && sketch_sample_rows < info.num_row_;
+  if (use_sample) {
+    monitor_.Start("SampleRows");
+    SampleRows(p_fmat, sketch_sample_rows, use_group_ind, &sample, &sample_info);
+    monitor_.Stop("SampleRows");
+  }
+
+  const int nthread = omp_get_max_threads();
+  const size_t ncol = info.num_col_;
+  sketchs.resize(ncol);
+  for (auto& s : sketchs) {
+    s.Init(use_sample ? sample_info.num_row_ : info.num_row_,
+           1.0 / (max_num_bins * kFactor));
+  }
+
+  // Rows are sketched in rounds. Each thread first collects the entries of its
+  // block of rows by feature, then the blocks are merged into the sketches in
+  // parallel over features. Blocks hold the same number of entries rather than
+  // rows, and are at least as large as the number of features so that the
+  // merge does not dominate on wide data.
+  const size_t block_entries = std::max(kBlockEntries, ncol);
+  const size_t summary_threshold = static_cast<size_t>(max_num_bins) * kFactor;
+  std::vector<SketchBlock> blocks(nthread);
+  std::vector<WXQSketch::SummaryContainer> temps(nthread);
+  std::vector<size_t> bounds(nthread + 1);
+  auto sketch_batch = [&](const SparsePage& batch, const MetaInfo& batch_info,
+                          bool group_weights) {
+    const SparsePageView page(batch);
+    const size_t size = page.Size();
+    if (group_weights) {
+      CHECK_LE(page.base_rowid + size, batch_info.group_ptr_.back())
+          << "Row " << batch_info.group_ptr_.back() << " does not lie in any group!";
+    }
+    const size_t* offset = batch.offset.ConstHostVector().data();
+    size_t rbegin = 0;
+    while (rbegin < size) {
+      size_t rend = std::upper_bound(offset + rbegin + 1, offset + size + 1,
+                                     offset[rbegin] + block_entries * nthread) - offset - 1;
+      rend = std::max(rend, rbegin + 1);
+      const size_t nnz = offset[rend] - offset[rbegin];
+      bounds[0] = rbegin;
+      for (int tid = 1; tid < nthread; ++tid) {
+        bounds[tid] = std::lower_bound(offset + bounds[tid - 1], offset + rend,
+                                       offset[rbegin] + nnz * tid / nthread) - offset;
+      }
+      bounds[nthread] = rend;
+
+      #pragma omp parallel num_threads(nthread)
       {
         CHECK_EQ(nthread, omp_get_num_threads());
-        auto tid = static_cast<unsigned>(omp_get_thread_num());
-        unsigned begin = std::min(nstep * tid, ncol);
-        unsigned end = std::min(nstep * (tid + 1), ncol);
-
-        // do not iterate if no columns are assigned to the thread
-        if (begin < end && end <= ncol) {
-          for (size_t i = 0; i < batch.Size(); ++i) { // NOLINT(*)
-            size_t const ridx = batch.base_rowid + i;
-            SparsePage::Inst const inst = batch[i];
-            if (group_ptr[group_ind] == ridx &&
-                // maximum equals to weights.size() - 1
-                group_ind < num_groups - 1) {
-              // move to next group
-              group_ind++;
-            }
-            for (auto const& entry : inst) {
-              if (entry.index >= begin && entry.index < end) {
-                size_t w_idx = group_ind;
-                sketchs[entry.index].Push(entry.fvalue, info.GetWeight(w_idx));
-              }
-            }
+        const int tid = omp_get_thread_num();
+        blocks[tid].Build(page, bounds[tid], bounds[tid + 1], ncol, batch_info,
+                          group_weights);
+        #pragma omp barrier
+        #pragma omp for schedule(dynamic, 16)
+        for (bst_omp_uint fid = 0; fid < static_cast<bst_omp_uint>(ncol); ++fid) {
+          for (const auto& block : blocks) {
+            block.Push(fid, summary_threshold, &sketchs[fid], &temps[tid]);
           }
         }
       }
+      rbegin = rend;
     }
+  };
+  if (use_sample) {
+    sketch_batch(sample, sample_info, false);
   } else {
     for (const auto &batch : p_fmat->GetRowBatches()) {
-      const size_t size = batch.Size();
-      const size_t block_size = 512;
-      const size_t block_size_iter = block_size * nthread;
-      const size_t n_blocks = size / block_size_iter + !!(size % block_size_iter);
-
-      std::vector<std::vector<std::pair<float, float>>> buff(nthread);
-      for (size_t tid = 0; tid < nthread; ++tid) {
-        buff[tid].resize(block_size * ncol);
-      }
-
-      std::vector<size_t> sizes(nthread * ncol, 0);
-
-      for (size_t iblock = 0; iblock < n_blocks; ++iblock) {
-        #pragma omp parallel num_threads(nthread)
-        {
-          int tid = omp_get_thread_num();
-
-          const size_t ibegin = iblock * block_size_iter + tid * block_size;
-          const size_t iend = std::min(ibegin + block_size, size);
-
-          auto* p_sizes = sizes.data() + ncol * tid;
-          auto* p_buff = buff[tid].data();
-
-          for (size_t i = ibegin; i < iend; ++i) {
-            size_t const ridx = batch.base_rowid + i;
-            bst_float w = info.GetWeight(ridx);
-            SparsePage::Inst const inst = batch[i];
-
-            for (auto const& entry : inst) {
-              const size_t idx = entry.index;
-              p_buff[idx * block_size + p_sizes[idx]] = { entry.fvalue, w };
-              p_sizes[idx]++;
-            }
-          }
-          #pragma omp barrier
-          #pragma omp for schedule(static)
-          for (int32_t icol = 0; icol < static_cast<int32_t>(ncol); ++icol) {
-            for (size_t tid = 0; tid < nthread; ++tid) {
-              auto* p_sizes = sizes.data() + ncol * tid;
-              auto* p_buff = buff[tid].data() + icol * block_size;
-
-              for (size_t i = 0; i < p_sizes[icol]; ++i) {
-                sketchs[icol].Push(p_buff[i].first,  p_buff[i].second);
-              }
-
-              p_sizes[icol] = 0;
-            }
-          }
-        }
-      }
+      sketch_batch(batch, info, use_group_ind);
     }
   }
 
@@ -214,71 +355,191 @@ void HistCutMatrix::Init
   }
 }
 
+void HistCutMatrix::SaveBinary(dmlc::Stream* fo) const {
+  fo->Write(row_ptr);
+  fo->Write(min_val);
+  fo->Write(cut);
+}
+
+void HistCutMatrix::LoadBinary(dmlc::Stream* fi) {
+  CHECK(fi->Read(&row_ptr)) << "Invalid quantized matrix format";
+  CHECK(fi->Read(&min_val)) << "Invalid quantized matrix format";
+  CHECK(fi->Read(&cut)) << "Invalid quantized matrix format";
+  CHECK(!row_ptr.empty() && row_ptr.back() == cut.size() &&
+        min_val.size() + 1 == row_ptr.size()) << "Invalid quantized matrix format";
+}
+
 uint32_t HistCutMatrix::GetBinIdx(const Entry& e) {
-  unsigned fid = e.index;
-  auto cbegin = cut.begin() + row_ptr[fid];
-  auto cend = cut.begin() + row_ptr[fid + 1];
-  CHECK(cbegin != cend);
-  auto it = std::upper_bound(cbegin, cend, e.fvalue);
-  if (it == cend) {
-    it = cend - 1;
-  }
-  uint32_t idx = static_cast<uint32_t>(it - cut.begin());
-  return idx;
+  CHECK_NE(row_ptr[e.index], row_ptr[e.index + 1]);
+  return this->SearchBin(e.fvalue, e.index);
+}
+
+void HistCutMatrix::CheckCuts() const {
+  for (size_t fid = 0; fid + 1 < row_ptr.size(); ++fid) {
+    CHECK_NE(row_ptr[fid], row_ptr[fid + 1]) << "Feature " << fid << " has no cuts";
+  }
+}
+
+template <typename BinIdxType>
+void GHistIndexMatrix::SetDenseIndex(const SparsePage& batch, size_t batch_begin,
+                                     size_t rbegin, size_t nthread) {
+  const uint32_t nbins = cut.row_ptr.back();
+  const uint32_t* offset = index.Offset();
+  BinIdxType* local_index = index.data<BinIdxType>();
+  const SparsePageView page(batch);
+  auto bsize = static_cast<omp_ulong>(page.Size());
+  #pragma omp parallel for num_threads(nthread) schedule(static)
+  for (omp_ulong i = batch_begin; i < bsize; ++i) { // NOLINT(*)
+    const int tid = omp_get_thread_num();
+    size_t ibegin = row_ptr[rbegin + i];
+    size_t iend = row_ptr[rbegin + i + 1];
+    SparsePage::Inst inst = page[i];
+
+    CHECK_EQ(ibegin + inst.size(), iend);
+    for (bst_uint j = 0; j < inst.size(); ++j) {
+      uint32_t idx = cut.SearchBin(inst[j].fvalue, inst[j].index);
+      // position inside the row identifies the feature, so entries need not be sorted
+      local_index[ibegin + inst[j].index] = static_cast<BinIdxType>(idx - offset[inst[j].index]);
+      ++hit_count_tloc_[tid * nbins + idx];
+    }
+  }
+}
+
+void GHistIndexMatrix::SetSparseIndex(const SparsePage& batch, size_t batch_begin,
+                                      size_t rbegin, size_t nthread) {
+  const uint32_t nbins = cut.row_ptr.back();
+  uint32_t* global_index = index.data<uint32_t>();
+  const SparsePageView page(batch);
+  auto bsize = static_cast<omp_ulong>(page.Size());
+  #pragma omp parallel for num_threads(nthread) schedule(static)
+  for (omp_ulong i = batch_begin; i < bsize; ++i) { // NOLINT(*)
+    const int tid = omp_get_thread_num();
+    size_t ibegin = row_ptr[rbegin + i];
+    size_t iend = row_ptr[rbegin + i + 1];
+    SparsePage::Inst inst = page[i];
+
+    CHECK_EQ(ibegin + inst.size(), iend);
+    for (bst_uint j = 0; j < inst.size(); ++j) {
+      uint32_t idx = cut.SearchBin(inst[j].fvalue, inst[j].index);
+
+      global_index[ibegin + j] = idx;
+      ++hit_count_tloc_[tid * nbins + idx];
+    }
+    std::sort(global_index + ibegin, global_index + iend);
+  }
+}
+
+void GHistIndexMatrix::Init(DMatrix* p_fmat, int max_num_bins, size_t sketch_sample_rows) {
+  cut.Init(p_fmat, max_num_bins, sketch_sample_rows);
+  row_ptr.clear();
+  this->AddRows(p_fmat);
 }
 
-void GHistIndexMatrix::Init(DMatrix* p_fmat, int max_num_bins) {
-  cut.Init(p_fmat, max_num_bins);
+void GHistIndexMatrix::Append(DMatrix* p_fmat) {
+  CHECK(!row_ptr.empty()) << "GHistIndexMatrix must be initialized before appending rows";
+  const MetaInfo& info = p_fmat->Info();
+  CHECK_EQ(info.num_col_ + 1, cut.row_ptr.size()) << "Appended rows must keep the features";
+  if (index.IsDense() && info.num_nonzero_ != info.num_row_ * info.num_col_) {
+    // the new rows have missing values, bin everything again in the sparse layout
+    row_ptr.clear();
+  }
+  this->AddRows(p_fmat);
+}
+
+void GHistIndexMatrix::SaveBinary(dmlc::Stream* fo) const {
+  cut.SaveBinary(fo);
+  fo->Write(row_ptr);
+  index.SaveBinary(fo);
+  fo->Write(hit_count);
+}
+
+void GHistIndexMatrix::LoadBinary(dmlc::Stream* fi) {
+  cut.LoadBinary(fi);
+  CHECK(fi->Read(&row_ptr)) << "Invalid quantized matrix format";
+  index.LoadBinary(fi);
+  CHECK(fi->Read(&hit_count)) << "Invalid quantized matrix format";
+  CHECK(!row_ptr.empty() && row_ptr.back() == index.Size() &&
+        hit_count.size() == cut.row_ptr.back()) << "Invalid quantized matrix format";
+}
+
+void GHistIndexMatrix::AddRows(DMatrix* p_fmat) {
   const int32_t nthread = omp_get_max_threads();
   // const int nthread = 1;
   const uint32_t nbins = cut.row_ptr.back();
-  hit_count.resize(nbins, 0);
-  hit_count_tloc_.resize(nthread * nbins, 0);
+  hit_count_tloc_.resize(nthread * nbins);
 
+  // rows already binned by an earlier call are kept
+  const size_t nrow_begin = row_ptr.empty() ? 0 : row_ptr.size() - 1;
+  const MetaInfo& info = p_fmat->Info();
+  const size_t nfeature = cut.row_ptr.size() - 1;
+  // SearchBin does not check the cuts of each entry
+  cut.CheckCuts();
+  const bool is_dense = nfeature > 0 && info.num_nonzero_ == info.num_row_ * info.num_col_;
+  if (nrow_begin == 0) {
+    hit_count.assign(nbins, 0);
+    // dense data (no missing values) stores feature-local bins in a narrow type
+    if (is_dense) {
+      std::vector<uint32_t> offset(cut.row_ptr.begin(), cut.row_ptr.end() - 1);
+      index.Init(GetBinTypeSize(GetMaxBinsPerFeature()), 0, std::move(offset));
+    } else {
+      index.Init(kUint32BinsTypeSize, 0);
+    }
+  }
 
   size_t new_size = 1;
   for (const auto &batch : p_fmat->GetRowBatches()) {
     new_size += batch.Size();
   }
+  CHECK_GE(new_size, nrow_begin + 1) << "Rows of the matrix have been removed";
 
   row_ptr.resize(new_size);
   row_ptr[0] = 0;
 
   size_t rbegin = 0;
-  size_t prev_sum = 0;
 
   for (const auto &batch : p_fmat->GetRowBatches()) {
+    // first row of the batch that is not binned yet
+    const size_t batch_begin =
+        std::min(batch.Size(), nrow_begin - std::min(nrow_begin, rbegin));
+    const size_t nrow = batch.Size() - batch_begin;
+    if (nrow == 0) {
+      rbegin += batch.Size();
+      continue;
+    }
+    const SparsePageView page(batch);
     MemStackAllocator<size_t, 128> partial_sums(nthread);
     size_t* p_part = partial_sums.Get();
 
-    size_t block_size =  batch.Size() / nthread;
+    size_t block_size =  nrow / nthread;
 
     #pragma omp parallel num_threads(nthread)
     {
       #pragma omp for
       for (int32_t tid = 0; tid < nthread; ++tid) {
-        size_t ibegin = block_size * tid;
-        size_t iend = (tid == (nthread-1) ? batch.Size() : (block_size * (tid+1)));
+        size_t ibegin = batch_begin + block_size * tid;
+        size_t iend = (tid == (nthread-1) ? batch.Size() : (ibegin + block_size));
 
         size_t sum = 0;
         for (size_t i = ibegin; i < iend; ++i) {
-          sum += batch[i].size();
+          sum += page[i].size();
           row_ptr[rbegin + 1 + i] = sum;
         }
       }
 
       #pragma omp single
       {
-        p_part[0] = prev_sum;
+        p_part[0] = row_ptr[rbegin + batch_begin];
         for (int32_t i = 1; i < nthread; ++i) {
-          p_part[i] = p_part[i - 1] + row_ptr[rbegin + i*block_size];
+          // empty blocks hold no local sum
+          p_part[i] = p_part[i - 1] +
+              (block_size == 0 ? 0 : row_ptr[rbegin + batch_begin + i*block_size]);
         }
       }
 
       #pragma omp for
       for (int32_t tid = 0; tid < nthread; ++tid) {
-        size_t ibegin = block_size * tid;
-        size_t iend = (tid == (nthread-1) ? batch.Size() : (block_size * (tid+1)));
+        size_t ibegin = batch_begin + block_size * tid;
+        size_t iend = (tid == (nthread-1) ? batch.Size() : (ibegin + block_size));
 
         for (size_t i = ibegin; i < iend; ++i) {
           row_ptr[rbegin + 1 + i] += p_part[tid];
@@ -286,26 +547,24 @@ void GHistIndexMatrix::Init(DMatrix* p_fmat, int max_num_bins) {
       }
     }
 
-    index.resize(row_ptr.back());
+    index.Resize(row_ptr.back());
 
     CHECK_GT(cut.cut.size(), 0U);
 
-    auto bsize = static_cast<omp_ulong>(batch.Size());
-    #pragma omp parallel for num_threads(nthread) schedule(static)
-    for (omp_ulong i = 0; i < bsize; ++i) { // NOLINT(*)
-      const int tid = omp_get_thread_num();
-      size_t ibegin = row_ptr[rbegin + i];
-      size_t iend = row_ptr[rbegin + i + 1];
-      SparsePage::Inst inst = batch[i];
-
-      CHECK_EQ(ibegin + inst.size(), iend);
-      for (bst_uint j = 0; j < inst.size(); ++j) {
-        uint32_t idx = cut.GetBinIdx(inst[j]);
-
-        index[ibegin + j] = idx;
-        ++hit_count_tloc_[tid * nbins + idx];
-      }
-      std::sort(index.begin() + ibegin, index.begin() + iend);
+    std::fill(hit_count_tloc_.begin(), hit_count_tloc_.end(), 0);
+    switch (index.GetBinTypeSize()) {
+      case kUint8BinsTypeSize:
+        SetDenseIndex<uint8_t>(batch, batch_begin, rbegin, nthread);
+        break;
+      case kUint16BinsTypeSize:
+        SetDenseIndex<uint16_t>(batch, batch_begin, rbegin, nthread);
+        break;
+      default:
+        if (index.IsDense()) {
+          SetDenseIndex<uint32_t>(batch, batch_begin, rbegin, nthread);
+        } else {
+          SetSparseIndex(batch, batch_begin, rbegin, nthread);
+        }
     }
 
     #pragma omp parallel for num_threads(nthread) schedule(static)
@@ -315,18 +574,18 @@ void GHistIndexMatrix::Init(DMatrix* p_fmat, int max_num_bins) {
       }
     }
 
-    prev_sum = row_ptr[rbegin + batch.Size()];
     rbegin += batch.Size();
   }
 }
 
+template <typename BinIdxType>
 static size_t GetConflictCount(const std::vector<bool>& mark,
-                               const Column& column,
+                               const Column<BinIdxType>& column,
                                size_t max_cnt) {
   size_t ret = 0;
   if (column.GetType() == xgboost::common::kDenseColumn) {
     for (size_t i = 0; i < column.Size(); ++i) {
-      if (column.GetFeatureBinIdx(i) != std::numeric_limits<uint32_t>::max() && mark[i]) {
+      if (!column.IsMissing(i) && mark[i]) {
         ++ret;
         if (ret > max_cnt) {
           return max_cnt + 1;
@@ -346,12 +605,13 @@ static size_t GetConflictCount(const std::vector<bool>& mark,
   return ret;
 }
 
+template <typename BinIdxType>
 inline void
-MarkUsed(std::vector<bool>* p_mark, const Column& column) {
+MarkUsed(std::vector<bool>* p_mark, const Column<BinIdxType>& column) {
   std::vector<bool>& mark = *p_mark;
   if (column.GetType() == xgboost::common::kDenseColumn) {
     for (size_t i = 0; i < column.Size(); ++i) {
-      if (column.GetFeatureBinIdx(i) != std::numeric_limits<uint32_t>::max()) {
+      if (!column.IsMissing(i)) {
         mark[i] = true;
       }
     }
@@ -362,6 +622,7 @@ MarkUsed(std::vector<bool>* p_mark, const Column& column) {
   }
 }
 
+template <typename BinIdxType>
 inline std::vector<std::vector<unsigned>>
 FindGroups(const std::vector<unsigned>& feature_list,
            const std::vector<size_t>& feature_nnz,
@@ -381,7 +642,7 @@ FindGroups(const std::vector<unsigned>& feature_list,
     = static_cast<size_t>(param.max_conflict_rate * nrow);
 
   for (auto fid : feature_list) {
-    const Column& column = colmat.GetColumn(fid);
+    const Column<BinIdxType> column = colmat.GetColumn<BinIdxType>(fid);
 
     const size_t cur_fid_nnz = feature_nnz[fid];
     bool need_new_group = true;
@@ -445,8 +706,20 @@ FastFeatureGrouping(const GHistIndexMatrix& gmat,
     return feature_nnz[a] > feature_nnz[b];
   });
 
-  auto groups_alt1 = FindGroups(feature_list, feature_nnz, colmat, nrow, param);
-  auto groups_alt2 = FindGroups(features_by_nnz, feature_nnz, colmat, nrow, param);
+  std::vector<std::vector<unsigned>> groups_alt1, groups_alt2;
+  switch (colmat.GetTypeSize()) {
+    case kUint8BinsTypeSize:
+      groups_alt1 = FindGroups<uint8_t>(feature_list, feature_nnz, colmat, nrow, param);
+      groups_alt2 = FindGroups<uint8_t>(features_by_nnz, feature_nnz, colmat, nrow, param);
+      break;
+    case kUint16BinsTypeSize:
+      groups_alt1 = FindGroups<uint16_t>(feature_list, feature_nnz, colmat, nrow, param);
+      groups_alt2 = FindGroups<uint16_t>(features_by_nnz, feature_nnz, colmat, nrow, param);
+      break;
+    default:
+      groups_alt1 = FindGroups<uint32_t>(feature_list, feature_nnz, colmat, nrow, param);
+      groups_alt2 = FindGroups<uint32_t>(features_by_nnz, feature_nnz, colmat, nrow, param);
+  }
   auto& groups = (groups_alt1.size() > groups_alt2.size()) ? groups_alt2 : groups_alt1;
 
   // take apart small, sparse groups, as it won't help speed
@@ -545,47 +818,69 @@ void GHistIndexBlockMatrix::Init(const GHistIndexMatrix& gmat,
   }
 }
 
-void GHistBuilder::BuildHist(const std::vector<GradientPair>& gpair,
-                             const RowSetCollection::Elem row_indices,
-                             const GHistIndexMatrix& gmat,
-                             GHistRow hist) {
-  const size_t nthread = static_cast<size_t>(this->nthread_);
-  data_.resize(nbins_ * nthread_);
-
-  const size_t* rid =  row_indices.begin;
-  const size_t nrows = row_indices.Size();
-  const uint32_t* index = gmat.index.data();
+// accumulate rows [istart, iend) of a node with nrows rows into hist_data
+template <typename GradientSumT, typename BinIdxType, bool is_dense>
+void BuildHistRows(const std::vector<GradientPair>& gpair,
+                   const size_t* rid,
+                   const size_t nrows,
+                   const size_t istart,
+                   const size_t iend,
+                   const GHistIndexMatrix& gmat,
+                   GradientSumT* hist_data) {
+  const BinIdxType* index = gmat.index.data<BinIdxType>();
+  // feature-local bins are shifted back to global bins for dense data
+  const uint32_t* offsets = gmat.index.Offset();
   const size_t* row_ptr =  gmat.row_ptr.data();
   const float* pgh = reinterpret_cast<const float*>(gpair.data());
 
-  double* hist_data = reinterpret_cast<double*>(hist.data());
-  double* data = reinterpret_cast<double*>(data_.data());
-
-  const size_t block_size = 512;
-  size_t n_blocks = nrows/block_size;
-  n_blocks += !!(nrows - n_blocks*block_size);
-
-  const size_t nthread_to_process = std::min(nthread,  n_blocks);
-  memset(thread_init_.data(), '\0', nthread_to_process*sizeof(size_t));
-
   const size_t cache_line_size = 64;
   const size_t prefetch_offset = 10;
   size_t no_prefetch_size = prefetch_offset + cache_line_size/sizeof(*rid);
   no_prefetch_size = no_prefetch_size > nrows ? nrows : no_prefetch_size;
+  const size_t elems_per_cache_line = cache_line_size/sizeof(BinIdxType);
 
-#pragma omp parallel for num_threads(nthread_to_process) schedule(guided)
-  for (bst_omp_uint iblock = 0; iblock < n_blocks; iblock++) {
-    dmlc::omp_uint tid = omp_get_thread_num();
-    double* data_local_hist = ((nthread_to_process == 1) ? hist_data :
-                               reinterpret_cast<double*>(data_.data() + tid * nbins_));
+  // dense data: fixed number of entries per row, inner loop is unrolled
+  constexpr size_t kUnroll = 8;  // loop unrolling factor
+  const size_t n_features = gmat.index.OffsetSize();
+  const size_t n_features_unrolled = n_features - n_features % kUnroll;
 
-    if (!thread_init_[tid]) {
-      memset(data_local_hist, '\0', 2*nbins_*sizeof(double));
-      thread_init_[tid] = true;
-    }
+  if (is_dense) {
+    // every row holds n_features entries, so row offsets are computed
+    // directly instead of being read from row_ptr
+    for (size_t i = istart; i < iend; ++i) {
+      const size_t icol_start = rid[i] * n_features;
+      const BinIdxType* row_index = index + icol_start;
 
-    const size_t istart = iblock*block_size;
-    const size_t iend = (((iblock+1)*block_size > nrows) ? nrows : istart + block_size);
+      if (i < nrows - no_prefetch_size) {
+        const size_t icol_start_prefetch = rid[i + prefetch_offset] * n_features;
+        for (size_t j = icol_start_prefetch; j < icol_start_prefetch + n_features;
+             j += elems_per_cache_line) {
+          PREFETCH_READ_T0(index + j);
+        }
+        PREFETCH_READ_T0(pgh + 2*rid[i + prefetch_offset]);
+      }
+
+      const size_t idx_gh = 2*rid[i];
+      const GradientSumT grad = pgh[idx_gh];
+      const GradientSumT hess = pgh[idx_gh+1];
+      size_t j = 0;
+      for (; j < n_features_unrolled; j += kUnroll) {
+        uint32_t idx_bin[kUnroll];
+        for (size_t k = 0; k < kUnroll; ++k) {
+          idx_bin[k] = 2*(static_cast<uint32_t>(row_index[j + k]) + offsets[j + k]);
+        }
+        for (size_t k = 0; k < kUnroll; ++k) {
+          hist_data[idx_bin[k]] += grad;
+          hist_data[idx_bin[k]+1] += hess;
+        }
+      }
+      for (; j < n_features; ++j) {
+        const uint32_t idx_bin = 2*(static_cast<uint32_t>(row_index[j]) + offsets[j]);
+        hist_data[idx_bin] += grad;
+        hist_data[idx_bin+1] += hess;
+      }
+    }
+  } else {
     for (size_t i = istart; i < iend; ++i) {
       const size_t icol_start = row_ptr[rid[i]];
       const size_t icol_end = row_ptr[rid[i]+1];
@@ -596,14 +891,289 @@ void GHistBuilder::BuildHist(const std::vector<GradientPair>& gpair,
       }
 
       for (size_t j = icol_start; j < icol_end; ++j) {
-        const uint32_t idx_bin = 2*index[j];
+        const uint32_t idx_bin = 2*static_cast<uint32_t>(index[j]);
         const size_t idx_gh = 2*rid[i];
 
-        data_local_hist[idx_bin] += pgh[idx_gh];
-        data_local_hist[idx_bin+1] += pgh[idx_gh+1];
+        hist_data[idx_bin] += pgh[idx_gh];
+        hist_data[idx_bin+1] += pgh[idx_gh+1];
+      }
+    }
+  }
+}
+
+template <typename GradientSumT>
+void GHistBuilder<GradientSumT>::BuildHist(const std::vector<GradientPair>& gpair,
+                                           const RowSetCollection::Elem row_indices,
+                                           const GHistIndexMatrix& gmat,
+                                           GHistRow<GradientSumT> hist) {
+  if (UseColumnBlocks(gmat, row_indices.Size())) {
+    switch (gmat.index.GetBinTypeSize()) {
+      case kUint8BinsTypeSize:
+        BuildHistColumnBlocks<uint8_t>(gpair, row_indices, gmat, hist);
+        break;
+      case kUint16BinsTypeSize:
+        BuildHistColumnBlocks<uint16_t>(gpair, row_indices, gmat, hist);
+        break;
+      default:
+        BuildHistColumnBlocks<uint32_t>(gpair, row_indices, gmat, hist);
+    }
+    return;
+  }
+  switch (gmat.index.GetBinTypeSize()) {
+    case kUint8BinsTypeSize:
+      BuildHistKernel<uint8_t, true>(gpair, row_indices, gmat, hist);
+      break;
+    case kUint16BinsTypeSize:
+      BuildHistKernel<uint16_t, true>(gpair, row_indices, gmat, hist);
+      break;
+    default:
+      if (gmat.index.IsDense()) {
+        BuildHistKernel<uint32_t, true>(gpair, row_indices, gmat, hist);
+      } else {
+        BuildHistKernel<uint32_t, false>(gpair, row_indices, gmat, hist);
+      }
+  }
+}
+
+template <typename GradientSumT>
+void GHistBuilder<GradientSumT>::BuildHists(const std::vector<GradientPair>& gpair,
+                                            const std::vector<RowSetCollection::Elem>& row_indices,
+                                            const GHistIndexMatrix& gmat,
+                                            const std::vector<GHistRow<GradientSumT> >& hists) {
+  CHECK_EQ(row_indices.size(), hists.size());
+  if (hists.size() == 1) {
+    BuildHist(gpair, row_indices[0], gmat, hists[0]);
+    return;
+  }
+  switch (gmat.index.GetBinTypeSize()) {
+    case kUint8BinsTypeSize:
+      BuildHistsKernel<uint8_t, true>(gpair, row_indices, gmat, hists);
+      break;
+    case kUint16BinsTypeSize:
+      BuildHistsKernel<uint16_t, true>(gpair, row_indices, gmat, hists);
+      break;
+    default:
+      if (gmat.index.IsDense()) {
+        BuildHistsKernel<uint32_t, true>(gpair, row_indices, gmat, hists);
+      } else {
+        BuildHistsKernel<uint32_t, false>(gpair, row_indices, gmat, hists);
+      }
+  }
+}
+
+template <typename GradientSumT>
+template <typename BinIdxType, bool is_dense>
+void GHistBuilder<GradientSumT>::BuildHistsKernel(
+    const std::vector<GradientPair>& gpair,
+    const std::vector<RowSetCollection::Elem>& row_indices,
+    const GHistIndexMatrix& gmat,
+    const std::vector<GHistRow<GradientSumT> >& hists) {
+  const size_t nnodes = hists.size();
+  const size_t hist_size = 2*nbins_;
+
+  // enumerate (node, block of rows) pairs
+  struct Task {
+    size_t node;
+    size_t begin;
+    size_t end;
+  };
+  const size_t block_size = 512;
+  std::vector<Task> tasks;
+  for (size_t node = 0; node < nnodes; ++node) {
+    const size_t nrows = row_indices[node].Size();
+    for (size_t begin = 0; begin < nrows; begin += block_size) {
+      tasks.push_back({node, begin, std::min(begin + block_size, nrows)});
+    }
+  }
+  const size_t ntasks = tasks.size();
+  // at least one thread, the nodes may have no rows at all on this worker
+  const size_t nthread = std::max(std::min(nthread_, ntasks), static_cast<size_t>(1));
+
+  // Every thread processes a contiguous range of tasks, so a node is shared by a
+  // contiguous range of threads. The first of them accumulates directly into the
+  // histogram of the node, the others into buffers that are reduced afterwards.
+  constexpr size_t kDirect = std::numeric_limits<size_t>::max();
+  std::vector<size_t> task_ptr(nthread + 1);
+  for (size_t tid = 0; tid <= nthread; ++tid) {
+    task_ptr[tid] = tid * ntasks / nthread;
+  }
+  std::vector<bool> node_owned(nnodes, false);
+  std::vector<std::vector<size_t> > node_buffers(nnodes);
+  std::vector<size_t> task_buffer(ntasks);
+  size_t nbuffers = 0;
+  for (size_t tid = 0; tid < nthread; ++tid) {
+    for (size_t k = task_ptr[tid]; k < task_ptr[tid + 1]; ++k) {
+      const size_t node = tasks[k].node;
+      if (k == task_ptr[tid] || tasks[k - 1].node != node) {
+        if (!node_owned[node]) {
+          node_owned[node] = true;
+          task_buffer[k] = kDirect;
+        } else {
+          task_buffer[k] = nbuffers++;
+          node_buffers[node].push_back(task_buffer[k]);
+        }
+      } else {
+        task_buffer[k] = task_buffer[k - 1];
+      }
+    }
+  }
+  for (size_t node = 0; node < nnodes; ++node) {
+    if (!node_owned[node]) {  // node without any row
+      memset(reinterpret_cast<GradientSumT*>(hists[node].data()), '\0',
+             hist_size*sizeof(GradientSumT));
+    }
+  }
+  data_.resize(nbuffers * nbins_);
+  GradientSumT* data = reinterpret_cast<GradientSumT*>(data_.data());
+
+#pragma omp parallel for num_threads(nthread) schedule(static, 1)
+  for (bst_omp_uint tid = 0; tid < nthread; ++tid) {
+    for (size_t k = task_ptr[tid]; k < task_ptr[tid + 1]; ++k) {
+      const Task& task = tasks[k];
+      GradientSumT* out = (task_buffer[k] == kDirect)
+          ? reinterpret_cast<GradientSumT*>(hists[task.node].data())
+          : data + task_buffer[k] * hist_size;
+      if (k == task_ptr[tid] || tasks[k - 1].node != task.node) {
+        memset(out, '\0', hist_size*sizeof(GradientSumT));
+      }
+      const RowSetCollection::Elem& rows = row_indices[task.node];
+      BuildHistRows<GradientSumT, BinIdxType, is_dense>(gpair, rows.begin, rows.Size(),
+                                                        task.begin, task.end, gmat, out);
+    }
+  }
+
+  // reduce the buffers of shared nodes, in parallel over (node, block of bins)
+  std::vector<size_t> shared_nodes;
+  for (size_t node = 0; node < nnodes; ++node) {
+    if (!node_buffers[node].empty()) {
+      shared_nodes.push_back(node);
+    }
+  }
+  const size_t bin_block_size = 1024;
+  const size_t n_bin_blocks = hist_size / bin_block_size + !!(hist_size % bin_block_size);
+  const size_t nwork = shared_nodes.size() * n_bin_blocks;
+
+#pragma omp parallel for num_threads(nthread_) schedule(static)
+  for (bst_omp_uint iwork = 0; iwork < nwork; ++iwork) {
+    const size_t node = shared_nodes[iwork / n_bin_blocks];
+    const size_t istart = (iwork % n_bin_blocks) * bin_block_size;
+    const size_t iend = std::min(istart + bin_block_size, hist_size);
+    GradientSumT* hist_data = reinterpret_cast<GradientSumT*>(hists[node].data());
+    for (size_t buffer : node_buffers[node]) {
+      const GradientSumT* buffer_data = data + buffer * hist_size;
+      for (size_t i = istart; i < iend; ++i) {
+        hist_data[i] += buffer_data[i];
       }
     }
   }
+}
+
+template <typename GradientSumT>
+bool GHistBuilder<GradientSumT>::UseColumnBlocks(const GHistIndexMatrix& gmat,
+                                                 size_t nrows) const {
+  if (!gmat.index.IsDense()) {
+    return false;
+  }
+  // The row-wise kernel zeroes and reduces one full histogram per thread, i.e.
+  // touches nthread * nbins extra entries. Column blocks need no reduction, but
+  // every block reads the row ids and gradients of all rows again.
+  const size_t block_size = 512;
+  const size_t n_row_blocks = nrows / block_size + !!(nrows % block_size);
+  const size_t nthread_row_wise = std::min(nthread_, n_row_blocks);
+  const size_t n_col_blocks = std::min(nthread_, gmat.index.OffsetSize());
+  return n_col_blocks > 1 && n_col_blocks * nrows < nthread_row_wise * nbins_;
+}
+
+template <typename GradientSumT>
+template <typename BinIdxType>
+void GHistBuilder<GradientSumT>::BuildHistColumnBlocks(const std::vector<GradientPair>& gpair,
+                                                       const RowSetCollection::Elem row_indices,
+                                                       const GHistIndexMatrix& gmat,
+                                                       GHistRow<GradientSumT> hist) {
+  const size_t n_features = gmat.index.OffsetSize();
+  const size_t n_blocks = std::min(nthread_, n_features);
+  const std::vector<uint32_t>& cut_ptr = gmat.cut.row_ptr;
+
+  // split features into blocks holding roughly the same number of bins
+  feature_block_ptr_.resize(n_blocks + 1);
+  feature_block_ptr_[0] = 0;
+  size_t fid = 0;
+  for (size_t block = 1; block < n_blocks; ++block) {
+    const size_t bin_end = static_cast<size_t>(nbins_) * block / n_blocks;
+    while (fid < n_features && cut_ptr[fid + 1] <= bin_end) {
+      ++fid;
+    }
+    feature_block_ptr_[block] = std::max(fid, feature_block_ptr_[block - 1]);
+  }
+  feature_block_ptr_[n_blocks] = n_features;
+
+  const size_t* rid = row_indices.begin;
+  const size_t nrows = row_indices.Size();
+  const BinIdxType* index = gmat.index.data<BinIdxType>();
+  const uint32_t* offsets = gmat.index.Offset();
+  const float* pgh = reinterpret_cast<const float*>(gpair.data());
+  GradientSumT* hist_data = reinterpret_cast<GradientSumT*>(hist.data());
+
+#pragma omp parallel for num_threads(n_blocks) schedule(static)
+  for (bst_omp_uint block = 0; block < n_blocks; ++block) {
+    const size_t fbegin = feature_block_ptr_[block];
+    const size_t fend = feature_block_ptr_[block + 1];
+    const size_t bin_begin = cut_ptr[fbegin];
+    const size_t bin_end = cut_ptr[fend];
+    memset(hist_data + 2*bin_begin, '\0', 2*(bin_end - bin_begin)*sizeof(GradientSumT));
+
+    for (size_t i = 0; i < nrows; ++i) {
+      const BinIdxType* row_index = index + rid[i] * n_features;
+      const size_t idx_gh = 2*rid[i];
+      const GradientSumT grad = pgh[idx_gh];
+      const GradientSumT hess = pgh[idx_gh+1];
+      for (size_t j = fbegin; j < fend; ++j) {
+        const uint32_t idx_bin = 2*(static_cast<uint32_t>(row_index[j]) + offsets[j]);
+        hist_data[idx_bin] += grad;
+        hist_data[idx_bin+1] += hess;
+      }
+    }
+  }
+}
+
+template <typename GradientSumT>
+template <typename BinIdxType, bool is_dense>
+void GHistBuilder<GradientSumT>::BuildHistKernel(const std::vector<GradientPair>& gpair,
+                                                 const RowSetCollection::Elem row_indices,
+                                                 const GHistIndexMatrix& gmat,
+                                                 GHistRow<GradientSumT> hist) {
+  const size_t nthread = static_cast<size_t>(this->nthread_);
+  data_.resize(nbins_ * nthread_);
+
+  const size_t* rid =  row_indices.begin;
+  const size_t nrows = row_indices.Size();
+
+  GradientSumT* hist_data = reinterpret_cast<GradientSumT*>(hist.data());
+  GradientSumT* data = reinterpret_cast<GradientSumT*>(data_.data());
+
+  const size_t block_size = 512;
+  size_t n_blocks = nrows/block_size;
+  n_blocks += !!(nrows - n_blocks*block_size);
+
+  const size_t nthread_to_process = std::min(nthread,  n_blocks);
+  memset(thread_init_.data(), '\0', nthread_to_process*sizeof(size_t));
+
+#pragma omp parallel for num_threads(nthread_to_process) schedule(guided)
+  for (bst_omp_uint iblock = 0; iblock < n_blocks; iblock++) {
+    dmlc::omp_uint tid = omp_get_thread_num();
+    GradientSumT* data_local_hist = ((nthread_to_process == 1) ? hist_data :
+                                     reinterpret_cast<GradientSumT*>(data_.data() + tid * nbins_));
+
+    if (!thread_init_[tid]) {
+      memset(data_local_hist, '\0', 2*nbins_*sizeof(GradientSumT));
+      thread_init_[tid] = true;
+    }
+
+    const size_t istart = iblock*block_size;
+    const size_t iend = (((iblock+1)*block_size > nrows) ? nrows : istart + block_size);
+    BuildHistRows<GradientSumT, BinIdxType, is_dense>(gpair, rid, nrows, istart, iend,
+                                                      gmat, data_local_hist);
+  }
 
   if (nthread_to_process > 1) {
     const size_t size = (2*nbins_);
@@ -624,7 +1194,7 @@ void GHistBuilder::BuildHist(const std::vector<GradientPair>& gpair,
       const size_t iend = (((iblock + 1) * block_size > size) ? size : istart + block_size);
 
       const size_t bin = 2 * thread_init_[0] * nbins_;
-      memcpy(hist_data + istart, (data + bin + istart), sizeof(double) * (iend - istart));
+      memcpy(hist_data + istart, (data + bin + istart), sizeof(GradientSumT) * (iend - istart));
 
       for (size_t i_bin_part = 1; i_bin_part < n_worked_bins; ++i_bin_part) {
         const size_t bin = 2 * thread_init_[i_bin_part] * nbins_;
@@ -636,10 +1206,11 @@ void GHistBuilder::BuildHist(const std::vector<GradientPair>& gpair,
   }
 }
 
-void GHistBuilder::BuildBlockHist(const std::vector<GradientPair>& gpair,
-                                  const RowSetCollection::Elem row_indices,
-                                  const GHistIndexBlockMatrix& gmatb,
-                                  GHistRow hist) {
+template <typename GradientSumT>
+void GHistBuilder<GradientSumT>::BuildBlockHist(const std::vector<GradientPair>& gpair,
+                                                const RowSetCollection::Elem row_indices,
+                                                const GHistIndexBlockMatrix& gmatb,
+                                                GHistRow<GradientSumT> hist) {
   constexpr int kUnroll = 8;  // loop unrolling factor
   const size_t nblock = gmatb.GetNumBlock();
   const size_t nrows = row_indices.end - row_indices.begin;
@@ -648,7 +1219,7 @@ void GHistBuilder::BuildBlockHist(const std::vector<GradientPair>& gpair,
 #if defined(_OPENMP)
   const auto nthread = static_cast<bst_omp_uint>(this->nthread_);  // NOLINT
 #endif  // defined(_OPENMP)
-  tree::GradStats* p_hist = hist.data();
+  GHistEntry<GradientSumT>* p_hist = hist.data();
 
 #pragma omp parallel for num_threads(nthread) schedule(guided)
   for (bst_omp_uint bid = 0; bid < nblock; ++bid) {
@@ -686,7 +1257,10 @@ void GHistBuilder::BuildBlockHist(const std::vector<GradientPair>& gpair,
   }
 }
 
-void GHistBuilder::SubtractionTrick(GHistRow self, GHistRow sibling, GHistRow parent) {
+template <typename GradientSumT>
+void GHistBuilder<GradientSumT>::SubtractionTrick(GHistRow<GradientSumT> self,
+                                                  GHistRow<GradientSumT> sibling,
+                                                  GHistRow<GradientSumT> parent) {
   const uint32_t nbins = static_cast<bst_omp_uint>(nbins_);
   constexpr int kUnroll = 8;  // loop unrolling factor
   const uint32_t rest = nbins % kUnroll;
@@ -694,15 +1268,15 @@ void GHistBuilder::SubtractionTrick(GHistRow self, GHistRow sibling, GHistRow pa
 #if defined(_OPENMP)
   const auto nthread = static_cast<bst_omp_uint>(this->nthread_);  // NOLINT
 #endif  // defined(_OPENMP)
-  tree::GradStats* p_self = self.data();
-  tree::GradStats* p_sibling = sibling.data();
-  tree::GradStats* p_parent = parent.data();
+  GHistEntry<GradientSumT>* p_self = self.data();
+  GHistEntry<GradientSumT>* p_sibling = sibling.data();
+  GHistEntry<GradientSumT>* p_parent = parent.data();
 
 #pragma omp parallel for num_threads(nthread) schedule(static)
   for (bst_omp_uint bin_id = 0;
        bin_id < static_cast<bst_omp_uint>(nbins - rest); bin_id += kUnroll) {
-    tree::GradStats pb[kUnroll];
-    tree::GradStats sb[kUnroll];
+    GHistEntry<GradientSumT> pb[kUnroll];
+    GHistEntry<GradientSumT> sb[kUnroll];
     for (int k = 0; k < kUnroll; ++k) {
       pb[k] = p_parent[bin_id + k];
     }
@@ -718,5 +1292,8 @@ void GHistBuilder::SubtractionTrick(GHistRow self, GHistRow sibling, GHistRow pa
   }
 }
 
+template class GHistBuilder<float>;
+template class GHistBuilder<double>;
+
 }  // namespace common
 }  // namespace xgboost
@@ -8,7 +8,9 @@
 #define XGBOOST_COMMON_HIST_UTIL_H_
 
 #include <xgboost/data.h>
+#include <algorithm>
 #include <limits>
+#include <utility>
 #include <vector>
 #include "row_set.h"
 #include "../tree/param.h"
@@ -84,8 +86,30 @@ struct SimpleArray {
   size_t n_ = 0;
 };
 
-
-
+/*!
+ * \brief Number of the sorted cuts not greater than value, the same as
+ *  std::upper_bound but without data dependent branches. Up to
+ *  kLinearSearchCuts cuts are counted in a loop the compiler vectorises,
+ *  longer ones are bisected with conditional moves. Like std::upper_bound,
+ *  a NaN value is counted past every cut.
+ */
+constexpr uint32_t kLinearSearchCuts = 32;
+inline uint32_t CountCutsNotGreater(const bst_float* cuts, uint32_t size, bst_float value) {
+  if (size <= kLinearSearchCuts) {
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < size; ++i) {
+      count += !(value < cuts[i]);
+    }
+    return count;
+  }
+  const bst_float* base = cuts;
+  while (size > 1) {
+    const uint32_t half = size / 2;
+    base = !(value < base[half]) ? base + half : base;
+    size -= half;
+  }
+  return static_cast<uint32_t>(base - cuts) + !(value < *base);
+}
 
 /*! \brief Cut configuration for all the features. */
 struct HistCutMatrix {
@@ -96,18 +120,35 @@ struct HistCutMatrix {
   /*! \brief the cut field */
   std::vector<bst_float> cut;
   uint32_t GetBinIdx(const Entry &e);
+  /*! \brief check that every feature has at least one cut */
+  void CheckCuts() const;
+  /*!
+   * \brief same as GetBinIdx, without checking that the feature has cuts.
+   *  A feature without cuts gets the first bin of the next feature, so callers
+   *  check CheckCuts() once instead.
+   */
+  inline uint32_t SearchBin(bst_float value, uint32_t fid) const {
+    const uint32_t begin = row_ptr[fid];
+    const uint32_t size = row_ptr[fid + 1] - begin;
+    // values past the last cut fall into the last bin
+    return begin + std::min(CountCutsNotGreater(cut.data() + begin, size, value), size - 1);
+  }
 
   using WXQSketch = common::WXQuantileSketch<bst_float, bst_float>;
 
   // create histogram cut matrix given statistics from data
-  // using approximate quantile sketch approach
-  void Init(DMatrix* p_fmat, uint32_t max_num_bins);
+  // using approximate quantile sketch approach,
+  // on a sample of about sketch_sample_rows rows when it is not 0
+  void Init(DMatrix* p_fmat, uint32_t max_num_bins, size_t sketch_sample_rows = 0);
 
   void Init(std::vector<WXQSketch>* sketchs, uint32_t max_num_bins);
 
   HistCutMatrix();
   size_t NumBins() const { return row_ptr.back(); }
 
+  void SaveBinary(dmlc::Stream* fo) const;
+  void LoadBinary(dmlc::Stream* fi);
+
  protected:
   virtual size_t SearchGroupIndFromBaseRow(
       std::vector<bst_uint> const& group_ptr, size_t const base_rowid) const;
@@ -120,11 +161,106 @@ void DeviceSketch
   (const SparsePage& batch, const MetaInfo& info,
    const tree::TrainParam& param, HistCutMatrix* hmat, int gpu_batch_nrows);
 
+/*! \brief width in bytes of the integer type used to store a bin index */
+enum BinTypeSize : uint32_t {
+  kUint8BinsTypeSize  = 1,
+  kUint16BinsTypeSize = 2,
+  kUint32BinsTypeSize = 4
+};
+
 /*!
- * \brief A single row in global histogram index.
- *  Directly represent the global index in the histogram entry.
+ * \brief choose the narrowest bin type able to hold every feature-local bin id.
+ *  The maximum value of the type is never a valid bin, so that it can be used
+ *  to mark missing values (see ColumnMatrix).
  */
-using GHistIndexRow = Span<uint32_t const>;
+inline BinTypeSize GetBinTypeSize(uint32_t max_bins_per_feature) {
+  if (max_bins_per_feature <= std::numeric_limits<uint8_t>::max()) {
+    return kUint8BinsTypeSize;
+  } else if (max_bins_per_feature <= std::numeric_limits<uint16_t>::max()) {
+    return kUint16BinsTypeSize;
+  } else {
+    return kUint32BinsTypeSize;
+  }
+}
+
+/*!
+ * \brief Storage of bin ids in GHistIndexMatrix.
+ *  For dense data every row holds exactly one entry per feature, so the feature
+ *  of an entry is given by its position inside the row. Only the feature-local
+ *  bin is stored, in the narrowest type from GetBinTypeSize(), and the global
+ *  bin id is recovered by adding the per-feature offset.
+ *  For sparse data global bin ids are stored as uint32_t and there are no offsets.
+ */
+class Index {
+ public:
+  Index() = default;
+
+  // global bin id of the i-th entry; use data<T>() in performance critical code
+  inline uint32_t operator[](size_t i) const {
+    uint32_t bin;
+    switch (bin_type_size_) {
+      case kUint8BinsTypeSize:
+        bin = data<uint8_t>()[i];
+        break;
+      case kUint16BinsTypeSize:
+        bin = data<uint16_t>()[i];
+        break;
+      default:
+        bin = data<uint32_t>()[i];
+    }
+    return offset_.empty() ? bin : bin + offset_[i % offset_.size()];
+  }
+
+  // (re)allocate storage for n bin ids of the given width, with one offset per
+  // feature for dense data or no offsets at all for sparse data
+  inline void Init(BinTypeSize bin_type_size, size_t n,
+                   std::vector<uint32_t> offset = {}) {
+    bin_type_size_ = bin_type_size;
+    offset_ = std::move(offset);
+    data_.resize(n * bin_type_size_);
+  }
+  inline void Resize(size_t n) {
+    data_.resize(n * bin_type_size_);
+  }
+
+  template <typename T>
+  inline T* data() {  // NOLINT
+    return reinterpret_cast<T*>(data_.data());
+  }
+  template <typename T>
+  inline const T* data() const {  // NOLINT
+    return reinterpret_cast<const T*>(data_.data());
+  }
+
+  inline BinTypeSize GetBinTypeSize() const { return bin_type_size_; }
+  // per-feature offsets, only present for dense data
+  inline const uint32_t* Offset() const { return offset_.data(); }
+  inline size_t OffsetSize() const { return offset_.size(); }
+  inline bool IsDense() const { return !offset_.empty(); }
+  inline size_t Size() const { return data_.size() / bin_type_size_; }
+
+  inline void SaveBinary(dmlc::Stream* fo) const {
+    const uint32_t bin_type_size = bin_type_size_;
+    fo->Write(&bin_type_size, sizeof(bin_type_size));
+    fo->Write(offset_);
+    fo->Write(data_);
+  }
+  inline void LoadBinary(dmlc::Stream* fi) {
+    uint32_t bin_type_size;
+    CHECK_EQ(fi->Read(&bin_type_size, sizeof(bin_type_size)), sizeof(bin_type_size))
+        << "Invalid quantized matrix format";
+    CHECK(bin_type_size == kUint8BinsTypeSize || bin_type_size == kUint16BinsTypeSize ||
+          bin_type_size == kUint32BinsTypeSize) << "Invalid quantized matrix format";
+    bin_type_size_ = static_cast<BinTypeSize>(bin_type_size);
+    CHECK(fi->Read(&offset_)) << "Invalid quantized matrix format";
+    CHECK(fi->Read(&data_)) << "Invalid quantized matrix format";
+  }
+
+ private:
+  std::vector<uint8_t> data_;
+  std::vector<uint32_t> offset_;
+  BinTypeSize bin_type_size_{kUint32BinsTypeSize};
+};
 
 /*!
  * \brief preprocessed global index matrix, in CSR format
@@ -135,19 +271,20 @@ struct GHistIndexMatrix {
   /*! \brief row pointer to rows by element position */
   std::vector<size_t> row_ptr;
   /*! \brief The index data */
-  std::vector<uint32_t> index;
+  Index index;
   /*! \brief hit count of each index */
   std::vector<size_t> hit_count;
   /*! \brief The corresponding cuts */
   HistCutMatrix cut;
   // Create a global histogram matrix, given cut
-  void Init(DMatrix* p_fmat, int max_num_bins);
-  // get i-th row
-  inline GHistIndexRow operator[](size_t i) const {
-    return {&index[0] + row_ptr[i],
-            static_cast<GHistIndexRow::index_type>(
-                row_ptr[i + 1] - row_ptr[i])};
-  }
+  void Init(DMatrix* p_fmat, int max_num_bins, size_t sketch_sample_rows = 0);
+  /*!
+   * \brief bin the rows appended to p_fmat since the last Init or Append
+   *  against the existing cuts, without sketching the data again
+   */
+  void Append(DMatrix* p_fmat);
+  void SaveBinary(dmlc::Stream* fo) const;
+  void LoadBinary(dmlc::Stream* fi);
   inline void GetFeatureCounts(size_t* counts) const {
     auto nfeature = cut.row_ptr.size() - 1;
     for (unsigned fid = 0; fid < nfeature; ++fid) {
@@ -158,8 +295,23 @@ struct GHistIndexMatrix {
       }
     }
   }
+  inline uint32_t GetMaxBinsPerFeature() const {
+    uint32_t max_bins = 0;
+    for (size_t fid = 0; fid + 1 < cut.row_ptr.size(); ++fid) {
+      max_bins = std::max(max_bins, cut.row_ptr[fid + 1] - cut.row_ptr[fid]);
+    }
+    return max_bins;
+  }
 
  private:
+  // bin the rows of p_fmat past the end of row_ptr
+  void AddRows(DMatrix* p_fmat);
+  template <typename BinIdxType>
+  void SetDenseIndex(const SparsePage& batch, size_t batch_begin,
+                     size_t rbegin, size_t nthread);
+  void SetSparseIndex(const SparsePage& batch, size_t batch_begin,
+                      size_t rbegin, size_t nthread);
+
   std::vector<size_t> hit_count_tloc_;
 };
 
@@ -200,25 +352,67 @@ class GHistIndexBlockMatrix {
   std::vector<Block> blocks_;
 };
 
+/*!
+ * \brief gradient statistics of a single histogram bin.
+ *  GradientSumT is the type used for accumulation: double by default, float when
+ *  hist_precision=float, which halves the memory footprint of the histograms.
+ *  GHistEntry<double> has the same layout as tree::GradStats.
+ */
+template <typename GradientSumT>
+struct GHistEntry {
+  /*! \brief sum gradient statistics */
+  GradientSumT sum_grad;
+  /*! \brief sum hessian statistics */
+  GradientSumT sum_hess;
+
+  GHistEntry() : sum_grad{0}, sum_hess{0} {
+    static_assert(sizeof(GHistEntry) == 2 * sizeof(GradientSumT),
+                  "GHistEntry must be a plain pair of accumulators.");
+  }
+
+  inline double GetGrad() const { return sum_grad; }
+  inline double GetHess() const { return sum_hess; }
+
+  inline void Add(GradientPair p) {
+    sum_grad += p.GetGrad();
+    sum_hess += p.GetHess();
+  }
+  inline void Add(const GHistEntry& b) {
+    sum_grad += b.sum_grad;
+    sum_hess += b.sum_hess;
+  }
+  /*! \brief same as add, reduce is used in All Reduce */
+  inline static void Reduce(GHistEntry& a, const GHistEntry& b) { // NOLINT(*)
+    a.Add(b);
+  }
+  /*! \brief set current value to a - b */
+  inline void SetSubstract(const GHistEntry& a, const GHistEntry& b) {
+    sum_grad = a.sum_grad - b.sum_grad;
+    sum_hess = a.sum_hess - b.sum_hess;
+  }
+};
+
 /*!
  * \brief histogram of graident statistics for a single node.
- *  Consists of multiple GradStats, each entry showing total graident statistics
+ *  Consists of multiple GHistEntry, each entry showing total graident statistics
  *     for that particular bin
  *  Uses global bin id so as to represent all features simultaneously
  */
-using GHistRow = Span<tree::GradStats>;
+template <typename GradientSumT>
+using GHistRow = Span<GHistEntry<GradientSumT> >;
 
 /*!
  * \brief histogram of gradient statistics for multiple nodes
  */
+template <typename GradientSumT>
 class HistCollection {
  public:
   // access histogram for i-th node
-  GHistRow operator[](bst_uint nid) const {
+  GHistRow<GradientSumT> operator[](bst_uint nid) const {
     constexpr uint32_t kMax = std::numeric_limits<uint32_t>::max();
     CHECK_NE(row_ptr_[nid], kMax);
-    tree::GradStats* ptr =
-        const_cast<tree::GradStats*>(dmlc::BeginPtr(data_) + row_ptr_[nid]);
+    GHistEntry<GradientSumT>* ptr =
+        const_cast<GHistEntry<GradientSumT>*>(dmlc::BeginPtr(data_) + row_ptr_[nid]);
     return {ptr, nbins_};
   }
 
@@ -251,7 +445,7 @@ class HistCollection {
   /*! \brief number of all bins over all features */
   uint32_t nbins_;
 
-  std::vector<tree::GradStats> data_;
+  std::vector<GHistEntry<GradientSumT> > data_;
 
   /*! \brief row_ptr_[nid] locates bin for historgram of node nid */
   std::vector<size_t> row_ptr_;
@@ -260,6 +454,7 @@ class HistCollection {
 /*!
  * \brief builder for histograms of gradient statistics
  */
+template <typename GradientSumT>
 class GHistBuilder {
  public:
   // initialize builder
@@ -273,26 +468,56 @@ class GHistBuilder {
   void BuildHist(const std::vector<GradientPair>& gpair,
                  const RowSetCollection::Elem row_indices,
                  const GHistIndexMatrix& gmat,
-                 GHistRow hist);
+                 GHistRow<GradientSumT> hist);
+  // whether BuildHist partitions the bins among threads instead of the rows
+  bool UseColumnBlocks(const GHistIndexMatrix& gmat, size_t nrows) const;
+  // construct the histograms of several nodes in a single parallel pass, with
+  // work split across (node, block of rows) pairs
+  void BuildHists(const std::vector<GradientPair>& gpair,
+                  const std::vector<RowSetCollection::Elem>& row_indices,
+                  const GHistIndexMatrix& gmat,
+                  const std::vector<GHistRow<GradientSumT> >& hists);
   // same, with feature grouping
   void BuildBlockHist(const std::vector<GradientPair>& gpair,
                       const RowSetCollection::Elem row_indices,
                       const GHistIndexBlockMatrix& gmatb,
-                      GHistRow hist);
+                      GHistRow<GradientSumT> hist);
   // construct a histogram via subtraction trick
-  void SubtractionTrick(GHistRow self, GHistRow sibling, GHistRow parent);
+  void SubtractionTrick(GHistRow<GradientSumT> self,
+                        GHistRow<GradientSumT> sibling,
+                        GHistRow<GradientSumT> parent);
 
   uint32_t GetNumBins() {
       return nbins_;
   }
 
  private:
+  template <typename BinIdxType, bool is_dense>
+  void BuildHistKernel(const std::vector<GradientPair>& gpair,
+                       const RowSetCollection::Elem row_indices,
+                       const GHistIndexMatrix& gmat,
+                       GHistRow<GradientSumT> hist);
+  template <typename BinIdxType, bool is_dense>
+  void BuildHistsKernel(const std::vector<GradientPair>& gpair,
+                        const std::vector<RowSetCollection::Elem>& row_indices,
+                        const GHistIndexMatrix& gmat,
+                        const std::vector<GHistRow<GradientSumT> >& hists);
+  // dense data only: every thread owns the bins of a contiguous block of
+  // features and scans all rows, so no per-thread histograms are needed
+  template <typename BinIdxType>
+  void BuildHistColumnBlocks(const std::vector<GradientPair>& gpair,
+                             const RowSetCollection::Elem row_indices,
+                             const GHistIndexMatrix& gmat,
+                             GHistRow<GradientSumT> hist);
+
   /*! \brief number of threads for parallel computation */
   size_t nthread_;
   /*! \brief number of all bins over all features */
   uint32_t nbins_;
   std::vector<size_t> thread_init_;
-  std::vector<tree::GradStats> data_;
+  std::vector<GHistEntry<GradientSumT> > data_;
+  /*! \brief feature boundaries of the blocks used by BuildHistColumnBlocks */
+  std::vector<size_t> feature_block_ptr_;
 };
 
 
@@ -0,0 +1,101 @@
+/*!
+ * Copyright 2019 by Contributors
+ * \file io.cc
+ * \brief memory mapped input stream and prediction output
+ */
+#include <dmlc/omp.h>
+#include <xgboost/base.h>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // !defined(_WIN32)
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "io.h"
+
+namespace xgboost {
+namespace common {
+
+#if !defined(_WIN32)
+MmapReadStream* MmapReadStream::Create(const std::string& fname) {
+  std::string path = fname;
+  if (path.find("file://") == 0) {
+    path = path.substr(std::strlen("file://"));
+  } else if (path.find("://") != std::string::npos || path == "stdin") {
+    return nullptr;
+  }
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+    close(fd);
+    return nullptr;
+  }
+  const auto size = static_cast<size_t>(st.st_size);
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // the mapping stays valid after the descriptor is closed
+  close(fd);
+  if (data == MAP_FAILED) {
+    return nullptr;
+  }
+  madvise(data, size, MADV_SEQUENTIAL);
+  return new MmapReadStream(static_cast<const char*>(data), size);
+}
+
+MmapReadStream::~MmapReadStream() {
+  munmap(const_cast<char*>(data_), size_);
+}
+#else
+MmapReadStream* MmapReadStream::Create(const std::string& fname) {
+  return nullptr;
+}
+
+MmapReadStream::~MmapReadStream() = default;
+#endif  // !defined(_WIN32)
+
+size_t MmapReadStream::Read(void* dptr, size_t size) {
+  size = std::min(size, size_ - pos_);
+  std::memcpy(dptr, data_ + pos_, size);
+  pos_ += size;
+  return size;
+}
+
+void WritePredictions(const std::vector<bst_float>& preds, bool binary, dmlc::Stream* fo) {
+  if (preds.empty()) return;
+  if (binary) {
+    fo->Write(preds.data(), preds.size() * sizeof(bst_float));
+    return;
+  }
+  // format a slice per thread, then write the slices in order
+  const int nthread = omp_get_max_threads();
+  const size_t n = preds.size();
+  std::vector<std::string> text(nthread);
+#pragma omp parallel for schedule(static, 1) num_threads(nthread)
+  for (int i = 0; i < nthread; ++i) {
+    const size_t begin = n * i / nthread, end = n * (i + 1) / nthread;
+    std::string& out = text[i];
+    out.reserve((end - begin) * 16);
+    char buf[32];
+    for (size_t j = begin; j < end; ++j) {
+      const int len = snprintf(buf, sizeof(buf), "%.*g\n",
+                               std::numeric_limits<bst_float>::max_digits10, preds[j]);
+      out.append(buf, len);
+    }
+  }
+  for (const std::string& out : text) {
+    fo->Write(out.data(), out.size());
+  }
+}
+
+}  // namespace common
+}  // namespace xgboost
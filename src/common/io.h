@@ -10,8 +10,10 @@
 
 #include <dmlc/io.h>
 #include <rabit/rabit.h>
+#include <xgboost/base.h>
 #include <string>
 #include <cstring>
+#include <vector>
 
 namespace xgboost {
 namespace common {
@@ -70,6 +72,45 @@ class PeekableInStream : public dmlc::Stream {
   /*! \brief internal buffer */
   std::string buffer_;
 };
+
+/*!
+ * \brief Read only stream over a memory mapped local file, for callers that
+ *  parse the whole file in place through Data().
+ */
+class MmapReadStream : public dmlc::Stream {
+ public:
+  /*!
+   * \brief map a local file
+   * \return nullptr when fname is not a local file or can not be mapped
+   */
+  static MmapReadStream* Create(const std::string& fname);
+  ~MmapReadStream() override;
+
+  size_t Read(void* dptr, size_t size) override;
+  void Write(const void* dptr, size_t size) override {
+    LOG(FATAL) << "Not implemented";
+  }
+  /*! \brief the whole mapped file */
+  const char* Data() const { return data_; }
+  size_t Size() const { return size_; }
+
+ private:
+  MmapReadStream(const char* data, size_t size) : data_(data), size_(size), pos_(0) {}
+
+  /*! \brief the mapped file */
+  const char* data_;
+  /*! \brief size of the file */
+  size_t size_;
+  /*! \brief read position */
+  size_t pos_;
+};
+
+/*!
+ * \brief write predictions to fo, either as text with one value per line in the
+ *  same digits as an ostream with precision max_digits10, or as raw floats in
+ *  host byte order.  The text is formatted by several threads.
+ */
+void WritePredictions(const std::vector<bst_float>& preds, bool binary, dmlc::Stream* fo);
 }  // namespace common
 }  // namespace xgboost
 #endif  // XGBOOST_COMMON_IO_H_
@@ -0,0 +1,133 @@
+/*!
+ * Copyright 2019 by Contributors
+ * \file quantized_matrix.h
+ * \brief Quantized copy of a DMatrix shared by the boosters training on it
+ */
+#ifndef XGBOOST_COMMON_QUANTIZED_MATRIX_H_
+#define XGBOOST_COMMON_QUANTIZED_MATRIX_H_
+
+#include <dmlc/io.h>
+#include <xgboost/data.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "column_matrix.h"
+#include "hist_util.h"
+
+namespace xgboost {
+namespace common {
+
+/*!
+ * \brief Histogram cuts, bin index and column layout of a DMatrix.
+ *  It is built once per matrix and stored in DMatrix::Quantized(), where every
+ *  hist updater with the same max_bin picks it up instead of sketching the data
+ *  again. The instance is never modified after construction, so a matrix that
+ *  changes gets a new one while boosters still holding the old one keep it.
+ *  The cuts depend on the instance weights and groups as well as on the rows,
+ *  so those are kept to find out when they are set again.
+ */
+struct QuantizedMatrix {
+  /*! \brief magic number of the serialized form, which follows a DMatrix binary */
+  static const int kMagic = 0xffffab03;
+  /*! \brief maximum number of bins per feature the cuts were sketched with */
+  int max_bin;
+  /*! \brief threshold the column matrix was laid out with */
+  double sparse_threshold;
+  /*! \brief number of rows the cuts were sketched on, 0 for all rows */
+  int sketch_sample_rows;
+  /*! \brief cuts and row-wise bin index */
+  GHistIndexMatrix gmat;
+  /*! \brief column-wise bin index */
+  ColumnMatrix column_matrix;
+  /*! \brief instance weights the cuts were sketched with */
+  std::vector<bst_float> weights;
+  /*! \brief group boundaries the cuts were sketched with */
+  std::vector<bst_uint> group_ptr;
+
+  /*!
+   * \brief whether the cuts are still those of a matrix with meta info info,
+   *  rows and groups appended since keep the weights and groups sketched with
+   */
+  bool SketchedWith(const MetaInfo& info) const {
+    const std::vector<bst_float>& info_weights = info.weights_.ConstHostVector();
+    // bitwise, a NaN weight does not force sketching again
+    return weights.empty() == info_weights.empty() && weights.size() <= info_weights.size() &&
+        (weights.empty() || std::memcmp(weights.data(), info_weights.data(),
+                                        weights.size() * sizeof(bst_float)) == 0) &&
+        group_ptr.empty() == info.group_ptr_.empty() &&
+        group_ptr.size() <= info.group_ptr_.size() &&
+        std::equal(group_ptr.cbegin(), group_ptr.cend(), info.group_ptr_.cbegin());
+  }
+
+  /*! \brief sketch and bin p_fmat */
+  static std::shared_ptr<QuantizedMatrix> Create(DMatrix* p_fmat, int max_bin,
+                                                 double sparse_threshold,
+                                                 int sketch_sample_rows = 0) {
+    std::shared_ptr<QuantizedMatrix> out(new QuantizedMatrix());
+    out->max_bin = max_bin;
+    out->sparse_threshold = sparse_threshold;
+    out->sketch_sample_rows = sketch_sample_rows;
+    out->SetSketchInfo(p_fmat->Info());
+    out->gmat.Init(p_fmat, max_bin, sketch_sample_rows);
+    out->column_matrix.Init(out->gmat, sparse_threshold);
+    return out;
+  }
+  /*!
+   * \brief quantized matrix of p_fmat with the cuts of this one, binning only
+   *  the rows appended to p_fmat since this one was built
+   */
+  std::shared_ptr<QuantizedMatrix> Derive(DMatrix* p_fmat, double sparse_threshold) const {
+    std::shared_ptr<QuantizedMatrix> out(new QuantizedMatrix());
+    out->max_bin = max_bin;
+    out->sparse_threshold = sparse_threshold;
+    out->sketch_sample_rows = sketch_sample_rows;
+    out->weights = weights;
+    out->group_ptr = group_ptr;
+    out->gmat = gmat;
+    if (out->gmat.row_ptr.size() != p_fmat->Info().num_row_ + 1) {
+      out->gmat.Append(p_fmat);
+    }
+    out->column_matrix.Init(out->gmat, sparse_threshold);
+    return out;
+  }
+
+  void SaveBinary(dmlc::Stream* fo) const {
+    fo->Write(&max_bin, sizeof(max_bin));
+    fo->Write(&sparse_threshold, sizeof(sparse_threshold));
+    fo->Write(&sketch_sample_rows, sizeof(sketch_sample_rows));
+    gmat.SaveBinary(fo);
+  }
+  /*! \brief load the quantized matrix of fmat, the column matrix is laid out again */
+  static std::shared_ptr<QuantizedMatrix> LoadBinary(dmlc::Stream* fi, const DMatrix& fmat) {
+    std::shared_ptr<QuantizedMatrix> out(new QuantizedMatrix());
+    CHECK_EQ(fi->Read(&out->max_bin, sizeof(out->max_bin)), sizeof(out->max_bin))
+        << "Invalid quantized matrix format";
+    CHECK_EQ(fi->Read(&out->sparse_threshold, sizeof(out->sparse_threshold)),
+             sizeof(out->sparse_threshold)) << "Invalid quantized matrix format";
+    CHECK_EQ(fi->Read(&out->sketch_sample_rows, sizeof(out->sketch_sample_rows)),
+             sizeof(out->sketch_sample_rows)) << "Invalid quantized matrix format";
+    out->gmat.LoadBinary(fi);
+    CHECK_EQ(out->gmat.row_ptr.size(), fmat.Info().num_row_ + 1)
+        << "Quantized matrix does not belong to the data";
+    CHECK_EQ(out->gmat.cut.row_ptr.size(), fmat.Info().num_col_ + 1)
+        << "Quantized matrix does not belong to the data";
+    // only saved along with the meta info it was sketched with
+    out->SetSketchInfo(fmat.Info());
+    out->column_matrix.Init(out->gmat, out->sparse_threshold);
+    return out;
+  }
+
+ private:
+  QuantizedMatrix() = default;
+  void SetSketchInfo(const MetaInfo& info) {
+    weights = info.weights_.ConstHostVector();
+    group_ptr = info.group_ptr_;
+  }
+};
+
+}  // namespace common
+}  // namespace xgboost
+#endif  // XGBOOST_COMMON_QUANTIZED_MATRIX_H_
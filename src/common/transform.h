@@ -6,6 +6,8 @@
 
 #include <dmlc/omp.h>
 #include <xgboost/data.h>
+#include <algorithm>
+#include <cstddef>
 #include <utility>
 #include <vector>
 #include <type_traits>  // enable_if
@@ -22,6 +24,8 @@ namespace xgboost {
 namespace common {
 
 constexpr size_t kBlockThreads = 256;
+/*! \brief Number of indices handed to a block functor at once by the CPU launch. */
+constexpr size_t kCpuBlockSize = 2048;
 
 namespace detail {
 
@@ -54,16 +58,17 @@ __global__ void LaunchCUDAKernel(Functor _func, Range _range,
 template <bool CompiledWithCuda = WITH_CUDA()>
 class Transform {
  private:
-  template <typename Functor>
+  template <typename Functor, typename BlockFunctor = std::nullptr_t>
   struct Evaluator {
    public:
-    Evaluator(Functor func, Range range, GPUSet devices, bool shard) :
-        func_(func), range_{std::move(range)},
+    Evaluator(Functor func, Range range, GPUSet devices, bool shard,
+              BlockFunctor block_func = BlockFunctor()) :
+        func_(func), block_func_(block_func), range_{std::move(range)},
         shard_{shard},
         distribution_{std::move(GPUDistribution::Block(devices))} {}
     Evaluator(Functor func, Range range, GPUDistribution dist,
-              bool shard) :
-        func_(func), range_{std::move(range)}, shard_{shard},
+              bool shard, BlockFunctor block_func = BlockFunctor()) :
+        func_(func), block_func_(block_func), range_{std::move(range)}, shard_{shard},
         distribution_{std::move(dist)} {}
 
     /*!
@@ -79,7 +84,7 @@ class Transform {
       if (on_device) {
         LaunchCUDA(func_, vectors...);
       } else {
-        LaunchCPU(func_, vectors...);
+        LaunchCPU(block_func_, vectors...);
       }
     }
 
@@ -156,18 +161,35 @@ class Transform {
     }
 #endif  // defined(__CUDACC__)
 
+    // Element-wise CPU launch, used when no block functor is given.
     template <typename... HDV>
-    void LaunchCPU(Functor func, HDV*... vectors) const {
+    void LaunchCPU(std::nullptr_t, HDV*... vectors) const {
+      Functor func = func_;
       omp_ulong end = static_cast<omp_ulong>(*(range_.end()));
 #pragma omp parallel for schedule(static)
       for (omp_ulong idx = 0; idx < end; ++idx) {
         func(idx, UnpackHDV(vectors)...);
       }
     }
+    // Blocked CPU launch, each call covers kCpuBlockSize contiguous indices.
+    template <typename Block, typename... HDV>
+    void LaunchCPU(Block block_func, HDV*... vectors) const {
+      const size_t end = static_cast<size_t>(*(range_.end()));
+      const omp_ulong nblocks =
+          static_cast<omp_ulong>((end + kCpuBlockSize - 1) / kCpuBlockSize);
+#pragma omp parallel for schedule(static)
+      for (omp_ulong block = 0; block < nblocks; ++block) {
+        const size_t begin = static_cast<size_t>(block) * kCpuBlockSize;
+        block_func(begin, std::min(begin + kCpuBlockSize, end),
+                   UnpackHDV(vectors)...);
+      }
+    }
 
    private:
     /*! \brief Callable object. */
     Functor func_;
+    /*! \brief Callable object for the CPU launch over blocks of indices. */
+    BlockFunctor block_func_;
     /*! \brief Range object specifying parallel threads index range. */
     Range range_;
     /*! \brief Whether sharding for vectors is required. */
@@ -201,6 +223,27 @@ class Transform {
                                  bool const shard = true) {
     return Evaluator<Functor> {func, std::move(range), std::move(dist), shard};
   }
+  /*!
+   * \brief Initialize a Transform object with a block functor for the CPU.
+   *
+   *  On device func is launched as usual.  On CPU block_func is called with
+   *  the half open index range [begin, end) of a block of kCpuBlockSize
+   *  contiguous indices followed by the same Span classes as func, so that
+   *  loop invariant checks can be hoisted out of the loop over the block and
+   *  the loop itself vectorised.  Both functors must compute the same result.
+   *
+   * \param func       A callable object, used on device.
+   * \param block_func A callable object, accepting the begin and end index of a
+   *                     block followed by a set of Span classes.
+   */
+  template <typename Functor, typename BlockFunctor>
+  static Evaluator<Functor, BlockFunctor> InitBlocked(Functor func, BlockFunctor block_func,
+                                                      Range const range,
+                                                      GPUSet const devices,
+                                                      bool const shard = true) {
+    return Evaluator<Functor, BlockFunctor> {
+      func, std::move(range), std::move(devices), shard, block_func};
+  }
 };
 
 }  // namespace common
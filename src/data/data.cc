@@ -11,6 +11,7 @@
 #include "./simple_csr_source.h"
 #include "../common/common.h"
 #include "../common/io.h"
+#include "../common/quantized_matrix.h"
 
 #if DMLC_ENABLE_STD_THREAD
 #include "./sparse_page_source.h"
@@ -207,6 +208,10 @@ DMatrix* DMatrix::Load(const std::string& uri,
         std::unique_ptr<data::SimpleCSRSource> source(new data::SimpleCSRSource());
         source->LoadBinary(&is);
         DMatrix* dmat = DMatrix::Create(std::move(source), cache_file);
+        if (cache_file.empty() && is.Read(&magic, sizeof(magic)) == sizeof(magic) &&
+            magic == common::QuantizedMatrix::kMagic) {
+          dmat->Quantized() = common::QuantizedMatrix::LoadBinary(&is, *dmat);
+        }
         if (!silent) {
           LOG(CONSOLE) << dmat->Info().num_row_ << 'x' << dmat->Info().num_col_ << " matrix with "
                        << dmat->Info().num_nonzero_ << " entries loaded from " << uri;
@@ -216,9 +221,19 @@ DMatrix* DMatrix::Load(const std::string& uri,
     }
   }
 
-  std::unique_ptr<dmlc::Parser<uint32_t> > parser(
-      dmlc::Parser<uint32_t>::Create(fname.c_str(), partid, npart, file_format.c_str()));
-  DMatrix* dmat = DMatrix::Create(parser.get(), cache_file, page_size);
+  DMatrix* dmat = nullptr;
+  if (cache_file.empty() && npart == 1) {
+    // local LIBSVM and CSV files are parsed in parallel straight into the page
+    std::unique_ptr<data::SimpleCSRSource> source(new data::SimpleCSRSource());
+    if (source->LoadText(fname, file_format)) {
+      dmat = DMatrix::Create(std::move(source), cache_file);
+    }
+  }
+  if (dmat == nullptr) {
+    std::unique_ptr<dmlc::Parser<uint32_t> > parser(
+        dmlc::Parser<uint32_t>::Create(fname.c_str(), partid, npart, file_format.c_str()));
+    dmat = DMatrix::Create(parser.get(), cache_file, page_size);
+  }
   if (!silent) {
     LOG(CONSOLE) << dmat->Info().num_row_ << 'x' << dmat->Info().num_col_ << " matrix with "
                  << dmat->Info().num_nonzero_ << " entries loaded from " << uri;
@@ -270,11 +285,24 @@ DMatrix* DMatrix::Create(dmlc::Parser<uint32_t>* parser,
   }
 }
 
+void DMatrix::AppendRows(const SparsePage& page, const MetaInfo& info) {
+  LOG(FATAL) << "Rows can only be appended to an in-memory DMatrix";
+}
+
 void DMatrix::SaveToLocalFile(const std::string& fname) {
   data::SimpleCSRSource source;
   source.CopyFrom(this);
   std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(fname.c_str(), "w"));
   source.SaveBinary(fo.get());
+  // the quantized data follows, readers without it stop at the end of the rows
+  std::lock_guard<std::mutex> guard(quantized_mutex_);
+  if (quantized_ != nullptr &&
+      quantized_->gmat.row_ptr.size() == this->Info().num_row_ + 1 &&
+      quantized_->SketchedWith(this->Info())) {
+    const int magic = common::QuantizedMatrix::kMagic;
+    fo->Write(&magic, sizeof(magic));
+    quantized_->SaveBinary(fo.get());
+  }
 }
 
 DMatrix* DMatrix::Create(std::unique_ptr<DataSource>&& source,
@@ -411,5 +439,6 @@ void SparsePage::PushCSC(const SparsePage &batch) {
 namespace data {
 // List of files that will be force linked in static links.
 DMLC_REGISTRY_LINK_TAG(sparse_page_raw_format);
+DMLC_REGISTRY_LINK_TAG(sparse_page_column_format);
 }  // namespace data
 }  // namespace xgboost
@@ -0,0 +1,57 @@
+/*!
+ * Copyright 2019 by Contributors
+ * \file parser_batches.cc
+ */
+#include <dmlc/logging.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "parser_batches.h"
+#include "simple_csr_source.h"
+
+namespace xgboost {
+namespace data {
+
+ParserBatches::ParserBatches(dmlc::Parser<uint32_t>* parser, size_t batch_rows)
+    : parser_(parser), batch_rows_(batch_rows), block_(), block_pos_(0) {
+  CHECK_GT(batch_rows, 0U);
+  block_.size = 0;
+}
+
+bool ParserBatches::Next() {
+  batch_.reset();
+  std::unique_ptr<SimpleCSRSource> source(new SimpleCSRSource());
+  SparsePage& page = source->page_;
+  MetaInfo& info = source->info;
+  while (page.Size() < batch_rows_) {
+    if (block_pos_ == block_.size) {
+      if (!parser_->Next()) break;
+      block_ = parser_->Value();
+      block_pos_ = 0;
+      continue;
+    }
+    const size_t size = std::min(block_.size - block_pos_, batch_rows_ - page.Size());
+    const dmlc::RowBlock<uint32_t> rows = block_.Slice(block_pos_, block_pos_ + size);
+    if (rows.offset[0] != rows.offset[size]) {
+      page.Push(rows);
+      for (size_t i = rows.offset[0]; i < rows.offset[size]; ++i) {
+        info.num_col_ = std::max(info.num_col_, static_cast<uint64_t>(rows.index[i] + 1));
+      }
+    } else {
+      // rows without any entry, the parser may leave the index empty
+      std::vector<size_t>& offset_vec = page.offset.HostVector();
+      offset_vec.resize(offset_vec.size() + size, offset_vec.back());
+    }
+    block_pos_ += size;
+  }
+  if (page.Size() == 0) return false;
+  info.num_row_ = page.Size();
+  info.num_nonzero_ = page.data.Size();
+  batch_.reset(DMatrix::Create(std::move(source)));
+  return true;
+}
+
+}  // namespace data
+}  // namespace xgboost
@@ -0,0 +1,50 @@
+/*!
+ * Copyright 2019 by Contributors
+ * \file parser_batches.h
+ * \brief Fixed size in-memory batches of the rows read by a parser.
+ */
+#ifndef XGBOOST_DATA_PARSER_BATCHES_H_
+#define XGBOOST_DATA_PARSER_BATCHES_H_
+
+#include <dmlc/data.h>
+#include <xgboost/data.h>
+
+#include <memory>
+
+namespace xgboost {
+namespace data {
+/*!
+ * \brief Groups the row blocks of a parser into in-memory DMatrix batches of
+ *  batch_rows rows, the last batch holding the remaining rows.  Blocks larger
+ *  than a batch are split, so at most one batch and the parser's own buffers
+ *  are held in memory.  Batches carry the features only, for prediction.
+ * \code
+ * ParserBatches batches(parser, 1 << 20);
+ * while (batches.Next()) {
+ *   learner->Predict(batches.Value(), ...);
+ * }
+ * \endcode
+ */
+class ParserBatches {
+ public:
+  ParserBatches(dmlc::Parser<uint32_t>* parser, size_t batch_rows);
+  /*! \brief read the next batch, false when the parser has no more rows */
+  bool Next();
+  /*! \brief the current batch, valid until the next call of Next */
+  DMatrix* Value() const { return batch_.get(); }
+
+ private:
+  /*! \brief parser of the input */
+  dmlc::Parser<uint32_t>* parser_;
+  /*! \brief number of rows in a batch */
+  size_t batch_rows_;
+  /*! \brief current block of the parser */
+  dmlc::RowBlock<uint32_t> block_;
+  /*! \brief first row of block_ not yet put into a batch */
+  size_t block_pos_;
+  /*! \brief current batch */
+  std::unique_ptr<DMatrix> batch_;
+};
+}  // namespace data
+}  // namespace xgboost
+#endif  // XGBOOST_DATA_PARSER_BATCHES_H_
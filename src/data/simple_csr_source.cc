@@ -3,13 +3,210 @@
  * \file simple_csr_source.cc
  */
 #include <dmlc/base.h>
+#include <dmlc/omp.h>
 #include <xgboost/logging.h>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
 #include <limits>
+#include <memory>
 #include "./simple_csr_source.h"
+#include "../common/common.h"
+#include "../common/io.h"
 
 namespace xgboost {
 namespace data {
 
+namespace {
+/*! \brief rows of a text file parsed by one thread */
+struct TextChunk {
+  std::vector<size_t> offset{0};
+  std::vector<Entry> data;
+  std::vector<bst_float> labels;
+  std::vector<bst_float> weights;
+  std::vector<uint64_t> qids;
+  uint64_t num_col{0};
+};
+
+inline bool IsBlank(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline bool IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+/*!
+ * \brief parse an unsigned integer
+ * \return the end of the number, p when there is none
+ */
+inline const char* ParseUInt(const char* p, const char* end, uint64_t* out) {
+  uint64_t v = 0;
+  const char* q = p;
+  for (; q != end && IsDigit(*q); ++q) {
+    v = v * 10 + static_cast<uint64_t>(*q - '0');
+  }
+  *out = v;
+  return q;
+}
+
+/*!
+ * \brief parse a float. Plain decimal numbers with at most 18 significant
+ *  digits and a small exponent are converted with one multiplication or
+ *  division by an exact power of ten; anything else goes through strtod.
+ * \return the end of the number, p when there is none
+ */
+inline const char* ParseFloat(const char* p, const char* end, bst_float* out) {
+  static const double kPow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                  1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                  1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  const char* q = p;
+  bool negative = false;
+  if (q != end && (*q == '-' || *q == '+')) {
+    negative = *q == '-';
+    ++q;
+  }
+  uint64_t mantissa = 0;
+  int ndigits = 0, exp10 = 0;
+  const char* digits = q;
+  for (; q != end && IsDigit(*q); ++q, ++ndigits) {
+    mantissa = mantissa * 10 + static_cast<uint64_t>(*q - '0');
+  }
+  if (q != end && *q == '.') {
+    for (++q; q != end && IsDigit(*q); ++q, ++ndigits, --exp10) {
+      mantissa = mantissa * 10 + static_cast<uint64_t>(*q - '0');
+    }
+  }
+  if (q == digits || (q == digits + 1 && *digits == '.')) {
+    // no digits, maybe nan or inf
+    char buf[32];
+    const size_t len = std::min(static_cast<size_t>(end - p), sizeof(buf) - 1);
+    std::memcpy(buf, p, len);
+    buf[len] = '\0';
+    char* endp;
+    *out = static_cast<bst_float>(std::strtod(buf, &endp));
+    return p + (endp - buf);
+  }
+  if (q != end && (*q == 'e' || *q == 'E')) {
+    const char* e = q + 1;
+    bool exp_negative = false;
+    if (e != end && (*e == '-' || *e == '+')) {
+      exp_negative = *e == '-';
+      ++e;
+    }
+    uint64_t exp = 0;
+    const char* exp_end = ParseUInt(e, end, &exp);
+    if (exp_end != e) {
+      exp = std::min<uint64_t>(exp, 1000);
+      exp10 += exp_negative ? -static_cast<int>(exp) : static_cast<int>(exp);
+      q = exp_end;
+    }
+  }
+  if (ndigits <= 18 && exp10 >= -22 && exp10 <= 22) {
+    double v = static_cast<double>(mantissa);
+    v = exp10 < 0 ? v / kPow10[-exp10] : v * kPow10[exp10];
+    *out = static_cast<bst_float>(negative ? -v : v);
+    return q;
+  }
+  // long mantissa or large exponent, let strtod round it
+  std::string buf(p, q);
+  *out = static_cast<bst_float>(std::strtod(buf.c_str(), nullptr));
+  return q;
+}
+
+// parse the LIBSVM lines in [begin, end): label[:weight] [qid:id] index[:value] ...
+void ParseLibSVM(const char* begin, const char* end, TextChunk* chunk) {
+  const char* line = begin;
+  while (line != end) {
+    const char* line_end = static_cast<const char*>(std::memchr(line, '\n', end - line));
+    if (line_end == nullptr) line_end = end;
+    const char* next = line_end == end ? end : line_end + 1;
+    const char* comment = static_cast<const char*>(std::memchr(line, '#', line_end - line));
+    if (comment != nullptr) line_end = comment;
+    const char* p = line;
+    while (p != line_end && IsBlank(*p)) ++p;
+    if (p == line_end) {
+      line = next;
+      continue;
+    }
+    bst_float label;
+    const char* q = ParseFloat(p, line_end, &label);
+    CHECK(q != p) << "Invalid LIBSVM line: " << std::string(line, line_end);
+    chunk->labels.push_back(label);
+    p = q;
+    if (p != line_end && *p == ':') {
+      bst_float weight;
+      q = ParseFloat(p + 1, line_end, &weight);
+      CHECK(q != p + 1) << "Invalid LIBSVM weight: " << std::string(line, line_end);
+      chunk->weights.push_back(weight);
+      p = q;
+    }
+    while (true) {
+      while (p != line_end && IsBlank(*p)) ++p;
+      if (p == line_end) break;
+      if (line_end - p > 4 && std::strncmp(p, "qid:", 4) == 0) {
+        uint64_t qid;
+        q = ParseUInt(p + 4, line_end, &qid);
+        CHECK(q != p + 4) << "Invalid LIBSVM qid: " << std::string(line, line_end);
+        chunk->qids.push_back(qid);
+        p = q;
+        continue;
+      }
+      uint64_t index;
+      q = ParseUInt(p, line_end, &index);
+      CHECK(q != p) << "Invalid LIBSVM feature: " << std::string(line, line_end);
+      p = q;
+      bst_float value = 1.0f;
+      if (p != line_end && *p == ':') {
+        q = ParseFloat(p + 1, line_end, &value);
+        CHECK(q != p + 1) << "Invalid LIBSVM value: " << std::string(line, line_end);
+        p = q;
+      }
+      chunk->data.emplace_back(static_cast<bst_uint>(index), value);
+      chunk->num_col = std::max(chunk->num_col, index + 1);
+    }
+    chunk->offset.push_back(chunk->data.size());
+    line = next;
+  }
+}
+
+// parse the CSV lines in [begin, end), every column but label_column is a feature
+void ParseCSV(const char* begin, const char* end, int label_column, TextChunk* chunk) {
+  const char* line = begin;
+  while (line != end) {
+    const char* line_end = static_cast<const char*>(std::memchr(line, '\n', end - line));
+    if (line_end == nullptr) line_end = end;
+    const char* next = line_end == end ? end : line_end + 1;
+    const char* p = line;
+    while (p != line_end && IsBlank(*p)) ++p;
+    if (p == line_end) {
+      line = next;
+      continue;
+    }
+    bst_float label = 0.0f;
+    bst_uint index = 0;
+    for (int column = 0; p != line_end; ++column) {
+      bst_float value = 0.0f;
+      const char* q = ParseFloat(p, line_end, &value);
+      // like dmlc's CSV parser, a field that is not a number reads as 0
+      if (q == p) value = 0.0f;
+      if (column == label_column) {
+        label = value;
+      } else {
+        chunk->data.emplace_back(index++, value);
+      }
+      p = static_cast<const char*>(std::memchr(q, ',', line_end - q));
+      p = p == nullptr ? line_end : p + 1;
+    }
+    chunk->num_col = std::max<uint64_t>(chunk->num_col, index);
+    chunk->labels.push_back(label);
+    chunk->offset.push_back(chunk->data.size());
+    line = next;
+  }
+}
+}  // anonymous namespace
+
 void SimpleCSRSource::Clear() {
   page_.Clear();
   this->info.Clear();
@@ -85,6 +282,122 @@ void SimpleCSRSource::CopyFrom(dmlc::Parser<uint32_t>* parser) {
   CHECK(info.qids_.empty() || info.qids_.size() == info.num_row_);
 }
 
+bool SimpleCSRSource::LoadText(const std::string& uri, const std::string& file_format) {
+  // arguments after '?', as dmlc::Parser takes them
+  std::string fname = uri, format = file_format;
+  int label_column = -1;
+  const size_t arg_pos = uri.find('?');
+  if (arg_pos != std::string::npos) {
+    fname = uri.substr(0, arg_pos);
+    for (const std::string& arg : common::Split(uri.substr(arg_pos + 1), '&')) {
+      const size_t eq = arg.find('=');
+      if (eq == std::string::npos) return false;
+      const std::string key = arg.substr(0, eq), value = arg.substr(eq + 1);
+      if (key == "format") {
+        if (format == "auto") format = value;
+      } else if (key == "label_column") {
+        label_column = std::atoi(value.c_str());
+      } else {
+        return false;
+      }
+    }
+  }
+  if (format == "auto") format = "libsvm";
+  if (format != "libsvm" && format != "csv") return false;
+  std::unique_ptr<common::MmapReadStream> fi(common::MmapReadStream::Create(fname));
+  if (fi == nullptr) return false;
+
+  const char* begin = fi->Data();
+  const char* end = begin + fi->Size();
+  if (end - begin >= 3 && std::memcmp(begin, "\xEF\xBB\xBF", 3) == 0) {
+    begin += 3;  // UTF-8 byte order mark
+  }
+  // one byte range per thread, each starting at the beginning of a line
+  const int nthread = omp_get_max_threads();
+  std::vector<const char*> bounds(nthread + 1, end);
+  bounds[0] = begin;
+  for (int i = 1; i < nthread; ++i) {
+    const char* p = std::max(bounds[i - 1], begin + (end - begin) * i / nthread);
+    if (p == begin) {
+      bounds[i] = begin;
+      continue;
+    }
+    // the range starts after the first line break at or past p - 1
+    const char* eol = static_cast<const char*>(std::memchr(p - 1, '\n', end - p + 1));
+    bounds[i] = eol == nullptr ? end : eol + 1;
+  }
+  std::vector<TextChunk> chunks(nthread);
+  // a parse error must not escape the parallel region, rethrow it afterwards
+  std::exception_ptr error;
+#pragma omp parallel for schedule(static, 1) num_threads(nthread)
+  for (int i = 0; i < nthread; ++i) {
+    try {
+      if (format == "libsvm") {
+        ParseLibSVM(bounds[i], bounds[i + 1], &chunks[i]);
+      } else {
+        ParseCSV(bounds[i], bounds[i + 1], label_column, &chunks[i]);
+      }
+    } catch (...) {
+#pragma omp critical
+      if (!error) error = std::current_exception();
+    }
+  }
+  if (error) std::rethrow_exception(error);
+
+  // stitch the chunks together
+  this->Clear();
+  std::vector<size_t> row_begin(nthread + 1, 0), entry_begin(nthread + 1, 0);
+  size_t num_weights = 0, num_qids = 0;
+  for (int i = 0; i < nthread; ++i) {
+    row_begin[i + 1] = row_begin[i] + chunks[i].labels.size();
+    entry_begin[i + 1] = entry_begin[i] + chunks[i].data.size();
+    num_weights += chunks[i].weights.size();
+    num_qids += chunks[i].qids.size();
+    info.num_col_ = std::max(info.num_col_, chunks[i].num_col);
+  }
+  const size_t num_row = row_begin[nthread];
+  CHECK(num_weights == 0 || num_weights == num_row)
+      << "Either every row has a weight or none at all";
+  CHECK(num_qids == 0 || num_qids == num_row)
+      << "Either every row has query ID or none at all";
+  auto& offset_vec = page_.offset.HostVector();
+  auto& data_vec = page_.data.HostVector();
+  auto& labels = info.labels_.HostVector();
+  auto& weights = info.weights_.HostVector();
+  offset_vec.resize(num_row + 1);
+  data_vec.resize(entry_begin[nthread]);
+  labels.resize(num_row);
+  weights.resize(num_weights);
+  info.qids_.resize(num_qids);
+#pragma omp parallel for schedule(static, 1) num_threads(nthread)
+  for (int i = 0; i < nthread; ++i) {
+    const TextChunk& chunk = chunks[i];
+    for (size_t r = 0; r < chunk.labels.size(); ++r) {
+      offset_vec[row_begin[i] + r + 1] = entry_begin[i] + chunk.offset[r + 1];
+    }
+    std::copy(chunk.data.begin(), chunk.data.end(), data_vec.begin() + entry_begin[i]);
+    std::copy(chunk.labels.begin(), chunk.labels.end(), labels.begin() + row_begin[i]);
+    if (num_weights != 0) {
+      std::copy(chunk.weights.begin(), chunk.weights.end(), weights.begin() + row_begin[i]);
+    }
+    if (num_qids != 0) {
+      std::copy(chunk.qids.begin(), chunk.qids.end(), info.qids_.begin() + row_begin[i]);
+    }
+  }
+  info.num_row_ = num_row;
+  info.num_nonzero_ = static_cast<uint64_t>(data_vec.size());
+  // group boundaries where the query ID changes, as CopyFrom(parser)
+  for (size_t i = 0; i < num_qids; ++i) {
+    if (i == 0 || info.qids_[i] != info.qids_[i - 1]) {
+      info.group_ptr_.push_back(static_cast<bst_uint>(i));
+    }
+  }
+  if (num_qids != 0) {
+    info.group_ptr_.push_back(static_cast<bst_uint>(num_qids));
+  }
+  return true;
+}
+
 void SimpleCSRSource::LoadBinary(dmlc::Stream* fi) {
   int tmagic;
   CHECK(fi->Read(&tmagic, sizeof(tmagic)) == sizeof(tmagic)) << "invalid input file format";
@@ -10,6 +10,7 @@
 
 #include <xgboost/base.h>
 #include <xgboost/data.h>
+#include <string>
 #include <vector>
 #include <algorithm>
 
@@ -47,6 +48,15 @@ class SimpleCSRSource : public DataSource {
    * \param info The additional information reflected in the parser.
    */
   void CopyFrom(dmlc::Parser<uint32_t>* src);
+  /*!
+   * \brief parse a local LIBSVM or CSV file in parallel, straight into the page.
+   * \param uri the file name, with optional format and label_column arguments
+   *    after '?' as accepted by dmlc::Parser
+   * \param file_format the format, or "auto" to take it from the uri
+   * \return false when the file or its arguments are not supported, in which
+   *    case the source is left empty and a dmlc::Parser should be used instead
+   */
+  bool LoadText(const std::string& uri, const std::string& file_format);
   /*!
    * \brief Load data from binary stream.
    * \param fi the pointer to load data from.
@@ -5,26 +5,55 @@
  * \author Tianqi Chen
  */
 #include "./simple_dmatrix.h"
+#include <dmlc/omp.h>
 #include <xgboost/data.h>
 #include "../common/random.h"
 
 namespace xgboost {
 namespace data {
+SimpleDMatrix::SimpleDMatrix(std::unique_ptr<DataSource>&& source)
+    : source_(std::move(source)) {
+  auto cast = dynamic_cast<SimpleCSRSource*>(source_.get());
+  if (cast != nullptr) {
+    this->CountColumns(cast->page_);
+  }
+}
+
+void SimpleDMatrix::CountColumns(const SparsePage& page) {
+  const auto& data_vec = page.data.HostVector();
+  const auto nnz = static_cast<omp_ulong>(data_vec.size());
+  bst_uint num_col = 0;
+  for (const auto& e : data_vec) {
+    num_col = std::max(num_col, e.index + 1);
+  }
+  if (num_col == 0) return;
+  if (column_size_.size() < num_col) column_size_.resize(num_col, 0);
+  const int nthread = std::max(std::min(omp_get_max_threads(),
+                                        static_cast<int>(nnz / num_col / 16)), 1);
+  if (nthread == 1) {
+    for (const auto& e : data_vec) ++column_size_[e.index];
+    return;
+  }
+  // count in thread local buffers, then sum them column by column
+  std::vector<size_t> counts(static_cast<size_t>(nthread) * num_col, 0);
+#pragma omp parallel for schedule(static) num_threads(nthread)
+  for (omp_ulong i = 0; i < nnz; ++i) {
+    ++counts[static_cast<size_t>(omp_get_thread_num()) * num_col + data_vec[i].index];
+  }
+#pragma omp parallel for schedule(static) num_threads(nthread)
+  for (omp_ulong fid = 0; fid < num_col; ++fid) {
+    for (int tid = 0; tid < nthread; ++tid) {
+      column_size_[fid] += counts[static_cast<size_t>(tid) * num_col + fid];
+    }
+  }
+}
+
 MetaInfo& SimpleDMatrix::Info() { return source_->info; }
 
 const MetaInfo& SimpleDMatrix::Info() const { return source_->info; }
 
 float SimpleDMatrix::GetColDensity(size_t cidx) {
-  size_t column_size = 0;
-  // Use whatever version of column batches already exists
-  if (sorted_column_page_) {
-    auto batch = this->GetSortedColumnBatches();
-    column_size = (*batch.begin())[cidx].size();
-  } else {
-    auto batch = this->GetColumnBatches();
-    column_size = (*batch.begin())[cidx].size();
-  }
-
+  size_t column_size = cidx < column_size_.size() ? column_size_[cidx] : 0;
   size_t nmiss = this->Info().num_row_ - column_size;
   return 1.0f - (static_cast<float>(nmiss)) / this->Info().num_row_;
 }
@@ -59,7 +88,7 @@ BatchSet SimpleDMatrix::GetRowBatches() {
 BatchSet SimpleDMatrix::GetColumnBatches() {
   // column page doesn't exist, generate it
   if (!column_page_) {
-    auto page = dynamic_cast<SimpleCSRSource*>(source_.get())->page_;
+    const auto& page = dynamic_cast<SimpleCSRSource*>(source_.get())->page_;
     column_page_.reset(
         new SparsePage(page.GetTranspose(source_->info.num_col_)));
   }
@@ -71,9 +100,14 @@ BatchSet SimpleDMatrix::GetColumnBatches() {
 BatchSet SimpleDMatrix::GetSortedColumnBatches() {
   // Sorted column page doesn't exist, generate it
   if (!sorted_column_page_) {
-    auto page = dynamic_cast<SimpleCSRSource*>(source_.get())->page_;
-    sorted_column_page_.reset(
-        new SparsePage(page.GetTranspose(source_->info.num_col_)));
+    if (column_page_) {
+      // reuse the transpose of the unsorted page
+      sorted_column_page_.reset(new SparsePage(*column_page_));
+    } else {
+      const auto& page = dynamic_cast<SimpleCSRSource*>(source_.get())->page_;
+      sorted_column_page_.reset(
+          new SparsePage(page.GetTranspose(source_->info.num_col_)));
+    }
     sorted_column_page_->SortRows();
   }
   auto begin_iter =
@@ -82,5 +116,68 @@ BatchSet SimpleDMatrix::GetSortedColumnBatches() {
 }
 
 bool SimpleDMatrix::SingleColBlock() const { return true; }
+
+// check that the new rows have a meta data field exactly when the matrix has it
+static void CheckAppendedMeta(const char* name, bool empty_matrix,
+                              size_t src_size, size_t dst_size) {
+  CHECK(empty_matrix || (src_size == 0) == (dst_size == 0))
+      << "Appended rows must have " << name << " exactly when the matrix has them";
+}
+
+template <typename T>
+static void AppendMeta(const std::vector<T>& src, std::vector<T>* dst) {
+  dst->insert(dst->end(), src.begin(), src.end());
+}
+
+void SimpleDMatrix::AppendRows(const SparsePage& page, const MetaInfo& info) {
+  auto cast = dynamic_cast<SimpleCSRSource*>(source_.get());
+  MetaInfo& self = source_->info;
+  const bool empty_matrix = self.num_row_ == 0;
+  const size_t num_row = page.Size();
+  uint64_t num_col = info.num_col_;
+  for (const auto& e : page.data.HostVector()) {
+    num_col = std::max(num_col, static_cast<uint64_t>(e.index) + 1);
+  }
+  // validate everything before the matrix is modified
+  if (!empty_matrix) {
+    CHECK_LE(num_col, self.num_col_) << "Appended rows must not add features";
+  }
+  CHECK(info.labels_.Size() == 0 || info.labels_.Size() == num_row)
+      << "Size of appended labels must equal the number of rows";
+  CHECK(info.weights_.Size() == 0 || info.weights_.Size() == num_row)
+      << "Size of appended weights must equal the number of rows";
+  CHECK(info.qids_.empty() || info.qids_.size() == num_row)
+      << "Size of appended query ids must equal the number of rows";
+  CHECK(info.group_ptr_.empty() || info.group_ptr_.back() == num_row)
+      << "Appended groups must cover the appended rows";
+  CHECK(info.root_index_.empty() && self.root_index_.empty())
+      << "Rows with root index can not be appended";
+  CheckAppendedMeta("labels", empty_matrix, info.labels_.Size(), self.labels_.Size());
+  CheckAppendedMeta("weights", empty_matrix, info.weights_.Size(), self.weights_.Size());
+  CheckAppendedMeta("base_margin", empty_matrix,
+                    info.base_margin_.Size(), self.base_margin_.Size());
+  CheckAppendedMeta("query ids", empty_matrix, info.qids_.size(), self.qids_.size());
+  CheckAppendedMeta("groups", empty_matrix, info.group_ptr_.size(), self.group_ptr_.size());
+
+  AppendMeta(info.labels_.ConstHostVector(), &self.labels_.HostVector());
+  AppendMeta(info.weights_.ConstHostVector(), &self.weights_.HostVector());
+  AppendMeta(info.base_margin_.ConstHostVector(), &self.base_margin_.HostVector());
+  AppendMeta(info.qids_, &self.qids_);
+  if (!info.group_ptr_.empty()) {
+    if (self.group_ptr_.empty()) self.group_ptr_.push_back(0);
+    const bst_uint group_begin = self.group_ptr_.back();
+    for (size_t i = 1; i < info.group_ptr_.size(); ++i) {
+      self.group_ptr_.push_back(group_begin + info.group_ptr_[i]);
+    }
+  }
+  cast->page_.Push(page);
+  self.num_row_ += num_row;
+  self.num_col_ = std::max(self.num_col_, num_col);
+  self.num_nonzero_ += page.data.Size();
+  this->CountColumns(page);
+  // column pages are transposed again on demand
+  column_page_.reset();
+  sorted_column_page_.reset();
+}
 }  // namespace data
 }  // namespace xgboost
@@ -23,8 +23,7 @@ namespace data {
 
 class SimpleDMatrix : public DMatrix {
  public:
-  explicit SimpleDMatrix(std::unique_ptr<DataSource>&& source)
-      : source_(std::move(source)) {}
+  explicit SimpleDMatrix(std::unique_ptr<DataSource>&& source);
 
   MetaInfo& Info() override;
 
@@ -40,10 +39,19 @@ class SimpleDMatrix : public DMatrix {
 
   BatchSet GetSortedColumnBatches() override;
 
+  void AppendRows(const SparsePage& page, const MetaInfo& info) override;
+
  private:
+  // count the entries of each column in page
+  void CountColumns(const SparsePage& page);
+
   // source data pointer.
   std::unique_ptr<DataSource> source_;
+  // number of entries in each column that has any
+  std::vector<size_t> column_size_;
 
+  // transposes are built on first request, the sorted one from the
+  // unsorted one when that exists
   std::unique_ptr<SparsePage> sorted_column_page_;
   std::unique_ptr<SparsePage> column_page_;
 };
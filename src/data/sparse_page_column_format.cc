@@ -0,0 +1,166 @@
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file sparse_page_column_format.cc
+ *  Column chunked binary format of sparse row pages.
+ */
+#include <xgboost/data.h>
+#include <dmlc/registry.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "./sparse_page_writer.h"
+
+namespace xgboost {
+namespace data {
+
+DMLC_REGISTRY_FILE_TAG(sparse_page_column_format);
+
+/*!
+ * \brief Row pages stored one column after another.
+ *  A record holds the number of rows, the entry offset of every column, then
+ *  the row indices of all columns followed by their values. The offsets give
+ *  the byte range of each column in both streams, so reading a subset of the
+ *  features seeks over the columns that are not needed.
+ *  Entries of a row are read back sorted by feature index, so the format is
+ *  only used for row pages, column pages of the same cache are stored raw.
+ */
+class SparsePageColumnFormat : public SparsePageFormat {
+ public:
+  bool Read(SparsePage* page, dmlc::SeekStream* fi) override {
+    if (!this->ReadHeader(fi)) return false;
+    const size_t num_col = col_ptr_.size() - 1;
+    CHECK_EQ(fi->Read(dmlc::BeginPtr(row_index_), row_index_.size() * sizeof(uint32_t)),
+             row_index_.size() * sizeof(uint32_t)) << "Invalid SparsePage file";
+    CHECK_EQ(fi->Read(dmlc::BeginPtr(fvalue_), fvalue_.size() * sizeof(bst_float)),
+             fvalue_.size() * sizeof(bst_float)) << "Invalid SparsePage file";
+    std::vector<bst_uint> columns(num_col);
+    for (size_t fid = 0; fid < num_col; ++fid) {
+      columns[fid] = static_cast<bst_uint>(fid);
+    }
+    this->Build(page, columns);
+    return true;
+  }
+
+  /*!
+   * \brief read only the features in sorted_index_set, the rows of the page
+   *  keep their position and lose the other features
+   */
+  bool Read(SparsePage* page,
+            dmlc::SeekStream* fi,
+            const std::vector<bst_uint>& sorted_index_set) override {
+    if (!this->ReadHeader(fi)) return false;
+    const size_t num_col = col_ptr_.size() - 1;
+    const size_t nnz = col_ptr_.back();
+    const size_t begin = fi->Tell();
+    std::vector<bst_uint> columns;
+    for (bst_uint fid : sorted_index_set) {
+      if (fid < num_col) columns.push_back(fid);
+    }
+    // index and value streams, read runs of adjacent columns at once
+    for (size_t i = 0; i < columns.size();) {
+      size_t j = i + 1;
+      while (j < columns.size() && columns[j] == columns[j - 1] + 1) ++j;
+      const size_t first = col_ptr_[columns[i]];
+      const size_t size = col_ptr_[columns[j - 1] + 1] - first;
+      if (size != 0) {
+        fi->Seek(begin + first * sizeof(uint32_t));
+        CHECK_EQ(fi->Read(dmlc::BeginPtr(row_index_) + first, size * sizeof(uint32_t)),
+                 size * sizeof(uint32_t)) << "Invalid SparsePage file";
+        fi->Seek(begin + nnz * sizeof(uint32_t) + first * sizeof(bst_float));
+        CHECK_EQ(fi->Read(dmlc::BeginPtr(fvalue_) + first, size * sizeof(bst_float)),
+                 size * sizeof(bst_float)) << "Invalid SparsePage file";
+      }
+      i = j;
+    }
+    // seek to end of record
+    fi->Seek(begin + nnz * (sizeof(uint32_t) + sizeof(bst_float)));
+    this->Build(page, columns);
+    return true;
+  }
+
+  void Write(const SparsePage& page, dmlc::Stream* fo) override {
+    const auto& offset_vec = page.offset.HostVector();
+    const auto& data_vec = page.data.HostVector();
+    CHECK(page.offset.Size() != 0 && offset_vec[0] == 0);
+    CHECK_EQ(offset_vec.back(), page.data.Size());
+    const uint64_t num_row = page.Size();
+    bst_uint num_col = 0;
+    for (const auto& e : data_vec) {
+      num_col = std::max(num_col, e.index + 1);
+    }
+    col_ptr_.assign(num_col + 1, 0);
+    for (const auto& e : data_vec) {
+      ++col_ptr_[e.index + 1];
+    }
+    for (size_t fid = 0; fid < num_col; ++fid) {
+      col_ptr_[fid + 1] += col_ptr_[fid];
+    }
+    row_index_.resize(data_vec.size());
+    fvalue_.resize(data_vec.size());
+    std::vector<size_t> pos(col_ptr_.begin(), col_ptr_.end() - 1);
+    for (size_t i = 0; i < num_row; ++i) {
+      for (size_t j = offset_vec[i]; j < offset_vec[i + 1]; ++j) {
+        const size_t k = pos[data_vec[j].index]++;
+        row_index_[k] = static_cast<uint32_t>(i);
+        fvalue_[k] = data_vec[j].fvalue;
+      }
+    }
+    fo->Write(&num_row, sizeof(num_row));
+    fo->Write(col_ptr_);
+    if (!data_vec.empty()) {
+      fo->Write(dmlc::BeginPtr(row_index_), row_index_.size() * sizeof(uint32_t));
+      fo->Write(dmlc::BeginPtr(fvalue_), fvalue_.size() * sizeof(bst_float));
+    }
+  }
+
+ private:
+  // read the number of rows and the column offsets of a record
+  bool ReadHeader(dmlc::SeekStream* fi) {
+    if (fi->Read(&num_row_, sizeof(num_row_)) != sizeof(num_row_)) return false;
+    CHECK(fi->Read(&col_ptr_)) << "Invalid SparsePage file";
+    CHECK_NE(col_ptr_.size(), 0U) << "Invalid SparsePage file";
+    row_index_.resize(col_ptr_.back());
+    fvalue_.resize(col_ptr_.back());
+    return true;
+  }
+  // assemble the rows of page from the given columns of row_index_ and fvalue_
+  void Build(SparsePage* page, const std::vector<bst_uint>& columns) const {
+    auto& offset_vec = page->offset.HostVector();
+    auto& data_vec = page->data.HostVector();
+    offset_vec.assign(num_row_ + 1, 0);
+    for (bst_uint fid : columns) {
+      for (size_t k = col_ptr_[fid]; k < col_ptr_[fid + 1]; ++k) {
+        CHECK_LT(row_index_[k], num_row_) << "Invalid SparsePage file";
+        ++offset_vec[row_index_[k] + 1];
+      }
+    }
+    for (size_t i = 0; i < num_row_; ++i) {
+      offset_vec[i + 1] += offset_vec[i];
+    }
+    data_vec.resize(offset_vec.back());
+    std::vector<size_t> pos(offset_vec.begin(), offset_vec.end() - 1);
+    for (bst_uint fid : columns) {
+      for (size_t k = col_ptr_[fid]; k < col_ptr_[fid + 1]; ++k) {
+        data_vec[pos[row_index_[k]]++] = Entry(fid, fvalue_[k]);
+      }
+    }
+  }
+
+  /*! \brief number of rows of the current record */
+  uint64_t num_row_;
+  /*! \brief entry offset of each column of the current record */
+  std::vector<size_t> col_ptr_;
+  /*! \brief row of each entry, column by column */
+  std::vector<uint32_t> row_index_;
+  /*! \brief value of each entry, column by column */
+  std::vector<bst_float> fvalue_;
+};
+
+XGBOOST_REGISTER_SPARSE_PAGE_FORMAT(column)
+.describe("Row pages stored column by column, for reading a subset of the features.")
+.set_body([]() {
+    return new SparsePageColumnFormat();
+  });
+}  // namespace data
+}  // namespace xgboost
@@ -82,8 +82,9 @@ float SparsePageDMatrix::GetColDensity(size_t cidx) {
   if (col_density_.empty()) {
     std::vector<size_t> column_size(this->Info().num_col_);
     for (const auto &batch : this->GetColumnBatches()) {
-      for (auto i = 0u; i < batch.Size(); i++) {
-        column_size[i] += batch[i].size();
+      const SparsePageView page(batch);
+      for (auto i = 0u; i < page.Size(); i++) {
+        column_size[i] += page[i].size();
       }
     }
     col_density_.resize(column_size.size());
@@ -236,7 +236,13 @@ void SparsePageSource::CreatePageFromDMatrix(DMatrix* src,
   std::vector<std::string> name_shards, format_shards;
   for (const std::string& prefix : cache_shards) {
     name_shards.push_back(prefix + page_type);
-    format_shards.push_back(SparsePageFormat::DecideFormat(prefix).first);
+    std::string format = SparsePageFormat::DecideFormat(prefix).first;
+    // the column format rebuilds page rows in Entry::index order, which is
+    // the row id on a column page and would lose the order of sorted columns
+    if (format == "column" && page_type != ".row.page") {
+      format = "raw";
+    }
+    format_shards.push_back(format);
   }
   {
     SparsePageWriter writer(name_shards, format_shards, 6);
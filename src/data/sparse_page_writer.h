@@ -39,6 +39,9 @@ class SparsePageFormat {
   virtual bool Read(SparsePage* page, dmlc::SeekStream* fi) = 0;
   /*!
    * \brief read only the segments we are interested in, advance fi to end of the block.
+   *  The raw format takes the segments to be page rows, i.e. the features of a
+   *  column page.  The column format, which only stores row pages, takes them to
+   *  be features and keeps every row, with the entries of the other features dropped.
    * \param page The page to load the data into.
    * \param fi the input stream of the file
    * \param sorted_index_set sorted index of segments we are interested in
@@ -14,6 +14,7 @@
 #include <string>
 #include <sstream>
 #include <algorithm>
+#include "../common/math.h"
 #include "../common/timer.h"
 
 namespace xgboost {
@@ -118,6 +119,29 @@ class GBLinear : public GradientBooster {
     }
   }
 
+  void PredictDense(const bst_float* data, size_t nrow, size_t ncol,
+                    bst_float missing, bst_float* out_preds,
+                    unsigned ntree_limit) override {
+    CHECK_EQ(ntree_limit, 0U)
+        << "GBLinear::Predict ntrees is only valid for gbtree predictor";
+    model_.LazyInitModel();
+    const int ngroup = model_.param.num_output_group;
+    const size_t num_feature = std::min(ncol, static_cast<size_t>(model_.param.num_feature));
+    const auto nsize = static_cast<omp_ulong>(nrow);
+    #pragma omp parallel for schedule(static)
+    for (omp_ulong i = 0; i < nsize; ++i) {
+      const bst_float* row = data + i * ncol;
+      for (int gid = 0; gid < ngroup; ++gid) {
+        bst_float psum = model_.bias()[gid] + base_margin_;
+        for (size_t j = 0; j < num_feature; ++j) {
+          if (common::CheckNAN(row[j]) || row[j] == missing) continue;
+          psum += row[j] * model_[j][gid];
+        }
+        out_preds[i * ngroup + gid] = psum;
+      }
+    }
+  }
+
   void PredictLeaf(DMatrix *p_fmat,
                    std::vector<bst_float> *out_preds,
                    unsigned ntree_limit) override {
@@ -142,10 +166,11 @@ class GBLinear : public GradientBooster {
     // start collecting the contributions
     for (const auto &batch : p_fmat->GetRowBatches()) {
       // parallel over local batch
-      const auto nsize = static_cast<bst_omp_uint>(batch.Size());
+      const SparsePageView page(batch);
+      const auto nsize = static_cast<bst_omp_uint>(page.Size());
       #pragma omp parallel for schedule(static)
       for (bst_omp_uint i = 0; i < nsize; ++i) {
-         auto inst = batch[i];
+         auto inst = page[i];
         auto row_idx = static_cast<size_t>(batch.base_rowid + i);
         // loop over output groups
         for (int gid = 0; gid < ngroup; ++gid) {
@@ -194,7 +219,8 @@ class GBLinear : public GradientBooster {
       // output convention: nrow * k, where nrow is number of rows
       // k is number of group
       // parallel over local batch
-      const auto nsize = static_cast<omp_ulong>(batch.Size());
+      const SparsePageView page(batch);
+      const auto nsize = static_cast<omp_ulong>(page.Size());
       #pragma omp parallel for schedule(static)
       for (omp_ulong i = 0; i < nsize; ++i) {
         const size_t ridx = batch.base_rowid + i;
@@ -202,7 +228,7 @@ class GBLinear : public GradientBooster {
         for (int gid = 0; gid < ngroup; ++gid) {
           bst_float margin =  (base_margin.size() != 0) ?
               base_margin[ridx * ngroup + gid] : base_margin_;
-          this->Pred(batch[i], &preds[ridx * ngroup], gid, margin);
+          this->Pred(page[i], &preds[ridx * ngroup], gid, margin);
         }
       }
     }
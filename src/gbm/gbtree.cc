@@ -219,6 +219,12 @@ class GBTree : public GradientBooster {
                                ntree_limit, root_index);
   }
 
+  void PredictDense(const bst_float* data, size_t nrow, size_t ncol,
+                    bst_float missing, bst_float* out_preds,
+                    unsigned ntree_limit) override {
+    predictor_->PredictDense(data, nrow, ncol, missing, out_preds, model_, ntree_limit);
+  }
+
   void PredictLeaf(DMatrix* p_fmat,
                    std::vector<bst_float>* out_preds,
                    unsigned ntree_limit) override {
@@ -372,6 +378,12 @@ class Dart : public GBTree {
     }
   }
 
+  void PredictDense(const bst_float* data, size_t nrow, size_t ncol,
+                    bst_float missing, bst_float* out_preds,
+                    unsigned ntree_limit) override {
+    LOG(FATAL) << "dart does not support dense prediction";
+  }
+
  protected:
   friend class GBTree;
   // internal prediction loop
@@ -429,8 +441,9 @@ class Dart : public GBTree {
     // start collecting the prediction
     auto* self = static_cast<Derived*>(this);
     for (const auto &batch : p_fmat->GetRowBatches()) {
+      const SparsePageView page(batch);
       constexpr int kUnroll = 8;
-      const auto nsize = static_cast<bst_omp_uint>(batch.Size());
+      const auto nsize = static_cast<bst_omp_uint>(page.Size());
       const bst_omp_uint rest = nsize % kUnroll;
       #pragma omp parallel for schedule(static)
       for (bst_omp_uint i = 0; i < nsize - rest; i += kUnroll) {
@@ -442,7 +455,7 @@ class Dart : public GBTree {
           ridx[k] = static_cast<int64_t>(batch.base_rowid + i + k);
         }
         for (int k = 0; k < kUnroll; ++k) {
-          inst[k] = batch[i + k];
+          inst[k] = page[i + k];
         }
         for (int k = 0; k < kUnroll; ++k) {
           for (int gid = 0; gid < num_group; ++gid) {
@@ -456,7 +469,7 @@ class Dart : public GBTree {
       for (bst_omp_uint i = nsize - rest; i < nsize; ++i) {
         RegTree::FVec& feats = thread_temp_[0];
         const auto ridx = static_cast<int64_t>(batch.base_rowid + i);
-        const SparsePage::Inst inst = batch[i];
+        const SparsePage::Inst inst = page[i];
         for (int gid = 0; gid < num_group; ++gid) {
           const size_t offset = ridx * num_group + gid;
           preds[offset] +=
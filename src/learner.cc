@@ -5,6 +5,7 @@
  * \author Tianqi Chen
  */
 #include <dmlc/io.h>
+#include <dmlc/thread_local.h>
 #include <dmlc/timer.h>
 #include <xgboost/learner.h>
 #include <xgboost/logging.h>
@@ -162,6 +163,12 @@ struct LearnerTrainParam : public dmlc::Parameter<LearnerTrainParam> {
 DMLC_REGISTER_PARAMETER(LearnerModelParam);
 DMLC_REGISTER_PARAMETER(LearnerTrainParam);
 
+/*! \brief per thread buffer of Learner::PredictDense */
+struct PredictDenseThreadLocalEntry {
+  HostDeviceVector<bst_float> preds;
+};
+using PredictDenseThreadLocalStore = dmlc::ThreadLocalStore<PredictDenseThreadLocalEntry>;
+
 /*!
  * \brief learner that performs gradient boosting for a specific objective
  * function. It does training and prediction.
@@ -523,10 +530,11 @@ class LearnerImpl : public Learner {
       DMatrix * dmat = data_sets[i];
       this->PredictRaw(data_sets[i], &preds_[dmat]);
       obj_->EvalTransform(&preds_[dmat]);
-      for (auto& ev : metrics_) {
-        os << '\t' << data_names[i] << '-' << ev->Name() << ':'
-           << ev->Eval(preds_[dmat], data_sets[i]->Info(),
-                       tparam_.dsplit == DataSplitMode::kRow);
+      std::vector<bst_float> values =
+          Metric::EvalMany(metrics_, preds_[dmat], data_sets[i]->Info(),
+                           tparam_.dsplit == DataSplitMode::kRow);
+      for (size_t j = 0; j < metrics_.size(); ++j) {
+        os << '\t' << data_names[i] << '-' << metrics_[j]->Name() << ':' << values[j];
       }
     }
 
@@ -592,6 +600,24 @@ class LearnerImpl : public Learner {
     }
   }
 
+  void PredictDense(const bst_float* data, size_t nrow, size_t ncol,
+                    bst_float missing, bool output_margin,
+                    bst_float* out_preds, unsigned ntree_limit) const override {
+    gbm_->PredictDense(data, nrow, ncol, missing, out_preds, ntree_limit);
+    if (!output_margin) {
+      // objectives transform a HostDeviceVector, keep one per thread so that
+      // repeated calls reuse its memory
+      HostDeviceVector<bst_float>& preds = PredictDenseThreadLocalStore::Get()->preds;
+      const size_t n = nrow * std::max(mparam_.num_class, 1);
+      preds.Resize(n);
+      std::copy(out_preds, out_preds + n, preds.HostVector().begin());
+      obj_->PredTransform(&preds);
+      // multi:softmax shrinks the predictions to one class index per row
+      const std::vector<bst_float>& transformed = preds.ConstHostVector();
+      std::copy(transformed.begin(), transformed.end(), out_preds);
+    }
+  }
+
   const std::map<std::string, std::string>& GetConfigurationArguments() const override {
     return cfg_;
   }
@@ -33,26 +33,33 @@ class ElementWiseMetricsReduction {
   explicit ElementWiseMetricsReduction(EvalRow policy) :
     policy_(std::move(policy)) {}
 
+  /*! \brief weighted sum of the metric over rows [begin, end) */
+  PackedReduceResult CpuReduceRows(
+      const std::vector<bst_float>& h_weights,
+      const std::vector<bst_float>& h_labels,
+      const std::vector<bst_float>& h_preds,
+      size_t begin, size_t end) const {
+    double residue_sum = 0;
+    double weights_sum = 0;
+    for (size_t i = begin; i < end; ++i) {
+      const bst_float wt = h_weights.size() > 0 ? h_weights[i] : 1.0f;
+      residue_sum += policy_.EvalRow(h_labels[i], h_preds[i]) * wt;
+      weights_sum += wt;
+    }
+    return PackedReduceResult{ residue_sum, weights_sum };
+  }
+
   PackedReduceResult CpuReduceMetrics(
       const HostDeviceVector<bst_float>& weights,
       const HostDeviceVector<bst_float>& labels,
       const HostDeviceVector<bst_float>& preds) const {
-    size_t ndata = labels.Size();
-
     const auto& h_labels = labels.HostVector();
     const auto& h_weights = weights.HostVector();
     const auto& h_preds = preds.HostVector();
-
-    bst_float residue_sum = 0;
-    bst_float weights_sum = 0;
-
-#pragma omp parallel for reduction(+: residue_sum, weights_sum) schedule(static)
-    for (omp_ulong i = 0; i < ndata; ++i) {
-      const bst_float wt = h_weights.size() > 0 ? h_weights[i] : 1.0f;
-      residue_sum += policy_.EvalRow(h_labels[i], h_preds[i]) * wt;
-      weights_sum += wt;
-    }
-    PackedReduceResult res { residue_sum, weights_sum };
+    PackedReduceResult res;
+    ParallelBlockReduce(labels.Size(), 1, [&](size_t begin, size_t end, PackedReduceResult* out) {
+        *out = CpuReduceRows(h_weights, h_labels, h_preds, begin, end);
+      }, &res);
     return res;
   }
 
@@ -309,7 +316,7 @@ struct EvalTweedieNLogLik {
  * \tparam Derived the name of subclass
  */
 template<typename Policy>
-struct EvalEWiseBase : public Metric {
+struct EvalEWiseBase : public ElementWiseMetric {
   EvalEWiseBase() : policy_{}, reducer_{policy_} {}
   explicit EvalEWiseBase(char const* policy_param) :
     policy_{policy_param}, reducer_{policy_} {}
@@ -322,17 +329,28 @@ struct EvalEWiseBase : public Metric {
   bst_float Eval(const HostDeviceVector<bst_float>& preds,
                  const MetaInfo& info,
                  bool distributed) override {
-    CHECK_NE(info.labels_.Size(), 0U) << "label set cannot be empty";
-    CHECK_EQ(preds.Size(), info.labels_.Size())
-        << "label and prediction size not match, "
-        << "hint: use merror or mlogloss for multi-class classification";
+    CheckInput(preds, info);
     const auto ndata = static_cast<omp_ulong>(info.labels_.Size());
     // Dealing with ndata < n_gpus.
     GPUSet devices = GPUSet::All(param_.gpu_id, param_.n_gpus, ndata);
 
     auto result =
         reducer_.Reduce(devices, info.weights_, info.labels_, preds);
+    return this->Finalize(result, distributed);
+  }
+
+  bool ReducesOnCpu(size_t ndata) const override {
+    return GPUSet::All(param_.gpu_id, param_.n_gpus, ndata).IsEmpty();
+  }
+
+  PackedReduceResult ReduceRows(const MetaInfo& info,
+                                const std::vector<bst_float>& preds,
+                                size_t begin, size_t end) const override {
+    return reducer_.CpuReduceRows(info.weights_.HostVector(), info.labels_.HostVector(),
+                                  preds, begin, end);
+  }
 
+  bst_float Finalize(PackedReduceResult result, bool distributed) const override {
     double dat[2] { result.Residue(), result.Weights() };
     if (distributed) {
       rabit::Allreduce<rabit::op::Sum>(dat, 2);
@@ -6,6 +6,9 @@
 #include <xgboost/metric.h>
 #include <dmlc/registry.h>
 
+#include <memory>
+#include <vector>
+
 #include "metric_common.h"
 
 namespace dmlc {
@@ -32,6 +35,64 @@ Metric* Metric::Create(const std::string& name) {
     return (e->body)(buf.substr(pos + 1, buf.length()).c_str());
   }
 }
+
+std::vector<bst_float> Metric::EvalMany(const std::vector<std::unique_ptr<Metric> >& metrics,
+                                        const HostDeviceVector<bst_float>& preds,
+                                        const MetaInfo& info,
+                                        bool distributed) {
+  std::vector<bst_float> out(metrics.size());
+  std::vector<bool> done(metrics.size(), false);
+  // elementwise metrics reduced on the CPU, over each block of rows in turn
+  std::vector<size_t> ewise;
+  for (size_t i = 0; i < metrics.size(); ++i) {
+    auto* ev = dynamic_cast<metric::ElementWiseMetric*>(metrics[i].get());
+    if (ev != nullptr && ev->ReducesOnCpu(preds.Size())) {
+      ewise.push_back(i);
+    }
+  }
+  if (ewise.size() > 1) {
+    metric::ElementWiseMetric::CheckInput(preds, info);
+    const auto& h_preds = preds.HostVector();
+    std::vector<metric::PackedReduceResult> sums(ewise.size());
+    metric::ParallelBlockReduce(
+        info.labels_.Size(), ewise.size(),
+        [&](size_t begin, size_t end, metric::PackedReduceResult* block_sums) {
+          for (size_t k = 0; k < ewise.size(); ++k) {
+            block_sums[k] = static_cast<metric::ElementWiseMetric*>(metrics[ewise[k]].get())
+                                ->ReduceRows(info, h_preds, begin, end);
+          }
+        },
+        sums.data());
+    for (size_t k = 0; k < ewise.size(); ++k) {
+      out[ewise[k]] = static_cast<metric::ElementWiseMetric*>(metrics[ewise[k]].get())
+                          ->Finalize(sums[k], distributed);
+      done[ewise[k]] = true;
+    }
+  }
+  // rank metrics on the same sort of the predictions
+  std::vector<size_t> sorted;
+  for (size_t i = 0; i < metrics.size(); ++i) {
+    auto* ev = dynamic_cast<metric::SortedPredictionMetric*>(metrics[i].get());
+    if (ev != nullptr && ev->UsesOrder(info)) {
+      sorted.push_back(i);
+    }
+  }
+  if (sorted.size() > 1) {
+    metric::PredictionOrder order;
+    order.Init(preds.HostVector(), info);
+    for (size_t i : sorted) {
+      out[i] = static_cast<metric::SortedPredictionMetric*>(metrics[i].get())
+                   ->EvalSorted(preds, info, distributed, &order);
+      done[i] = true;
+    }
+  }
+  for (size_t i = 0; i < metrics.size(); ++i) {
+    if (!done[i]) {
+      out[i] = metrics[i]->Eval(preds, info, distributed);
+    }
+  }
+  return out;
+}
 }  // namespace xgboost
 
 namespace xgboost {
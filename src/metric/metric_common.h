@@ -6,6 +6,13 @@
 #define XGBOOST_METRIC_METRIC_COMMON_H_
 
 #include <dmlc/parameter.h>
+#include <dmlc/omp.h>
+#include <xgboost/metric.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 #include "../common/common.h"
 
 namespace xgboost {
@@ -48,6 +55,97 @@ class PackedReduceResult {
   double Weights() const { return weights_sum_; }
 };
 
+/*! \brief rows per block of the elementwise reductions on the CPU */
+constexpr size_t kReduceBlockSize = 4096;
+
+/*!
+ * \brief reduce ndata rows into nout sums, in parallel over blocks of rows.
+ *  The blocks are added in order, so the result does not depend on the number
+ *  of threads.
+ * \param fn called as fn(begin, end, out) to write the nout sums of rows [begin, end)
+ * \param out the nout sums over all rows
+ */
+template <typename Fn>
+inline void ParallelBlockReduce(size_t ndata, size_t nout, Fn fn, PackedReduceResult* out) {
+  const auto nblock = static_cast<omp_ulong>((ndata + kReduceBlockSize - 1) / kReduceBlockSize);
+  std::vector<PackedReduceResult> block_sums(nblock * nout);
+#pragma omp parallel for schedule(static)
+  for (omp_ulong i = 0; i < nblock; ++i) {
+    fn(i * kReduceBlockSize, std::min<size_t>(ndata, (i + 1) * kReduceBlockSize),
+       block_sums.data() + i * nout);
+  }
+  std::fill(out, out + nout, PackedReduceResult());
+  for (omp_ulong i = 0; i < nblock; ++i) {
+    for (size_t k = 0; k < nout; ++k) {
+      out[k] += block_sums[i * nout + k];
+    }
+  }
+}
+
+/*!
+ * \brief metric that is a weighted sum over the rows. Metric::EvalMany reduces
+ *  all such metrics on the CPU in one pass over the data.
+ */
+class ElementWiseMetric : public Metric {
+ public:
+  /*! \brief whether the rows are reduced on the CPU */
+  virtual bool ReducesOnCpu(size_t ndata) const = 0;
+  /*! \brief weighted sum of the metric over rows [begin, end) */
+  virtual PackedReduceResult ReduceRows(const MetaInfo& info,
+                                        const std::vector<bst_float>& preds,
+                                        size_t begin, size_t end) const = 0;
+  /*! \brief metric from the sums over all rows */
+  virtual bst_float Finalize(PackedReduceResult result, bool distributed) const = 0;
+  /*! \brief check that preds and the labels of info can be evaluated */
+  static void CheckInput(const HostDeviceVector<bst_float>& preds, const MetaInfo& info) {
+    CHECK_NE(info.labels_.Size(), 0U) << "label set cannot be empty";
+    CHECK_EQ(preds.Size(), info.labels_.Size())
+        << "label and prediction size not match, "
+        << "hint: use merror or mlogloss for multi-class classification";
+  }
+};
+
+/*! \brief predictions of every group in decreasing order */
+struct PredictionOrder {
+  /*! \brief group boundaries, a single group when the data has none */
+  std::vector<unsigned> gptr;
+  /*!
+   * \brief prediction and row of every row, sorted by decreasing prediction within
+   *  each group. Rows with the same prediction keep their order.
+   */
+  std::vector<std::pair<bst_float, unsigned> > rec;
+  /*! \brief sort preds, in parallel over groups or within a single long group */
+  void Init(const std::vector<bst_float>& preds, const MetaInfo& info);
+};
+
+/*!
+ * \brief metric computed from the predictions of each group sorted in decreasing
+ *  order. Metric::EvalMany sorts the predictions once for all such metrics.
+ */
+class SortedPredictionMetric : public Metric {
+ public:
+  bst_float Eval(const HostDeviceVector<bst_float>& preds,
+                 const MetaInfo& info,
+                 bool distributed) override {
+    if (!this->UsesOrder(info)) {
+      return this->EvalSorted(preds, info, distributed, nullptr);
+    }
+    PredictionOrder order;
+    order.Init(preds.HostVector(), info);
+    return this->EvalSorted(preds, info, distributed, &order);
+  }
+  /*! \brief whether EvalSorted reads the order */
+  virtual bool UsesOrder(const MetaInfo& info) const { return true; }
+  /*!
+   * \brief evaluate the metric
+   * \param order the sorted predictions, nullptr if UsesOrder is false
+   */
+  virtual bst_float EvalSorted(const HostDeviceVector<bst_float>& preds,
+                               const MetaInfo& info,
+                               bool distributed,
+                               const PredictionOrder* order) = 0;
+};
+
 }  // namespace metric
 }  // namespace xgboost
 
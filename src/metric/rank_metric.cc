@@ -7,10 +7,17 @@
 #include <rabit/rabit.h>
 #include <xgboost/metric.h>
 #include <dmlc/registry.h>
+#include <dmlc/omp.h>
 #include <cmath>
+#include <cstring>
 
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <string>
 #include <vector>
 
+#include "metric_common.h"
 #include "../common/host_device_vector.h"
 #include "../common/math.h"
 
@@ -27,12 +34,11 @@ namespace {
  *   `info.weights`
  * WeightPolicy::GetWeightOfSortedRecord() :
  *   get weight associated with an individual instance, using index into
- *   sorted records `rec` (in ascending order of predicted labels). `rec` is
- *   of type PredIndPairContainer
+ *   sorted records `rec` (in descending order of predicted labels). `rec`
+ *   points to the PredIndPair of a group
  */
 
-using PredIndPairContainer
-  = std::vector<std::pair<xgboost::bst_float, unsigned>>;
+using PredIndPair = std::pair<xgboost::bst_float, unsigned>;
 
 class PerInstanceWeightPolicy {
  public:
@@ -43,7 +49,7 @@ class PerInstanceWeightPolicy {
   }
   inline static xgboost::bst_float
   GetWeightOfSortedRecord(const xgboost::MetaInfo& info,
-                          const PredIndPairContainer& rec,
+                          const PredIndPair* rec,
                           unsigned record_id, unsigned group_id) {
     return info.GetWeight(rec[record_id].second);
   }
@@ -59,12 +65,93 @@ class PerGroupWeightPolicy {
 
   inline static xgboost::bst_float
   GetWeightOfSortedRecord(const xgboost::MetaInfo& info,
-                          const PredIndPairContainer& rec,
+                          const PredIndPair* rec,
                           unsigned record_id, unsigned group_id) {
     return info.GetWeight(group_id);
   }
 };
 
+/*!
+ * \brief write the predictions in [begin, end) and their indices to out, sorted
+ *  by decreasing prediction, keeping the order of equal predictions. Long ranges
+ *  are sorted with a parallel radix sort on the bits of the predictions.
+ */
+void SortByPrediction(const std::vector<xgboost::bst_float>& preds,
+                      unsigned begin, unsigned end, PredIndPair* out) {
+  // below this size the comparison sort is faster than the radix passes
+  const unsigned kMinRadixSortSize = 1 << 16;
+  const unsigned n = end - begin;
+  if (n < kMinRadixSortSize) {
+    for (unsigned i = 0; i < n; ++i) {
+      out[i] = std::make_pair(preds[begin + i], begin + i);
+    }
+    std::sort(out, out + n, [](const PredIndPair& a, const PredIndPair& b) {
+      return a.first > b.first || (a.first == b.first && a.second < b.second);
+    });
+    return;
+  }
+  // unsigned key increasing as the prediction decreases
+  auto key = [](xgboost::bst_float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return ~(bits ^ ((bits >> 31) != 0 ? 0xffffffffU : 0x80000000U));
+  };
+  const int nthread = omp_get_max_threads();
+  const unsigned kRadix = 256;
+  const unsigned chunk = (n + nthread - 1) / nthread;
+  std::vector<size_t> count(static_cast<size_t>(nthread) * kRadix);
+  std::vector<PredIndPair> buffer(n);
+  PredIndPair* rec = out;
+  PredIndPair* tmp = buffer.data();
+  #pragma omp parallel for schedule(static) num_threads(nthread)
+  for (int tid = 0; tid < nthread; ++tid) {
+    for (unsigned i = tid * chunk; i < std::min(n, (tid + 1) * chunk); ++i) {
+      rec[i] = std::make_pair(preds[begin + i], begin + i);
+    }
+  }
+  for (unsigned shift = 0; shift < 32; shift += 8) {
+    std::fill(count.begin(), count.end(), 0);
+    #pragma omp parallel for schedule(static) num_threads(nthread)
+    for (int tid = 0; tid < nthread; ++tid) {
+      size_t* tcount = count.data() + tid * kRadix;
+      for (unsigned i = tid * chunk; i < std::min(n, (tid + 1) * chunk); ++i) {
+        ++tcount[(key(rec[i].first) >> shift) & (kRadix - 1)];
+      }
+    }
+    // the digit is the same for all predictions, e.g. the sign and exponent of
+    // probabilities, the pass would not move anything
+    size_t ndigit = 0;
+    for (unsigned d = 0; d < kRadix; ++d) {
+      size_t total = 0;
+      for (int tid = 0; tid < nthread; ++tid) {
+        total += count[tid * kRadix + d];
+      }
+      ndigit += total != 0;
+    }
+    if (ndigit == 1) continue;
+    // start of each digit of each thread, digits major so the sort is stable
+    size_t start = 0;
+    for (unsigned d = 0; d < kRadix; ++d) {
+      for (int tid = 0; tid < nthread; ++tid) {
+        const size_t c = count[tid * kRadix + d];
+        count[tid * kRadix + d] = start;
+        start += c;
+      }
+    }
+    #pragma omp parallel for schedule(static) num_threads(nthread)
+    for (int tid = 0; tid < nthread; ++tid) {
+      size_t* tpos = count.data() + tid * kRadix;
+      for (unsigned i = tid * chunk; i < std::min(n, (tid + 1) * chunk); ++i) {
+        tmp[tpos[(key(rec[i].first) >> shift) & (kRadix - 1)]++] = rec[i];
+      }
+    }
+    std::swap(rec, tmp);
+  }
+  if (rec != out) {
+    std::copy(rec, rec + n, out);
+  }
+}
+
 }  // anonymous namespace
 
 namespace xgboost {
@@ -72,6 +159,27 @@ namespace metric {
 // tag the this file, used by force static link later.
 DMLC_REGISTRY_FILE_TAG(rank_metric);
 
+void PredictionOrder::Init(const std::vector<bst_float>& preds, const MetaInfo& info) {
+  if (info.group_ptr_.empty()) {
+    gptr = {0, static_cast<unsigned>(preds.size())};
+  } else {
+    gptr = info.group_ptr_;
+  }
+  CHECK_EQ(gptr.back(), preds.size())
+      << "group structure must match number of prediction";
+  const auto ngroup = static_cast<bst_omp_uint>(gptr.size() - 1);
+  rec.resize(preds.size());
+  if (ngroup == 1) {
+    // a single list is sorted by all threads
+    SortByPrediction(preds, gptr[0], gptr[1], rec.data());
+  } else {
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (bst_omp_uint k = 0; k < ngroup; ++k) {
+      SortByPrediction(preds, gptr[k], gptr[k + 1], rec.data() + gptr[k]);
+    }
+  }
+}
+
 /*! \brief AMS: also records best threshold */
 struct EvalAMS : public Metric {
  public:
@@ -140,12 +248,138 @@ struct EvalAMS : public Metric {
 };
 
 /*! \brief Area Under Curve, for both classification and rank */
-struct EvalAuc : public Metric {
+struct EvalAuc : public SortedPredictionMetric {
+ public:
+  /*!
+   * \param param number of histogram bins of the approximate AUC, the AUC is
+   *  exact when it is nullptr
+   */
+  explicit EvalAuc(const char* param) : nbins_(0) {
+    if (param != nullptr) {
+      std::istringstream is(param);
+      int nbins = 0;
+      CHECK(is >> nbins && nbins > 0 && is.eof())
+          << "auc@n requires a positive number of bins n";
+      nbins_ = static_cast<unsigned>(nbins);
+      std::ostringstream os;
+      os << "auc@" << nbins_;
+      name_ = os.str();
+    } else {
+      name_ = "auc";
+    }
+  }
+
  private:
+  /*!
+   * \brief AUC of the n records of one group, sorted by decreasing prediction
+   * \return the AUC, or a negative value when the group lacks positive or negative samples
+   */
   template <typename WeightPolicy>
-  bst_float Eval(const HostDeviceVector<bst_float> &preds,
-                 const MetaInfo &info,
-                 bool distributed) {
+  static double GroupAuc(const PredIndPair* rec, size_t n, const MetaInfo& info,
+                         const std::vector<bst_float>& labels, unsigned group_id) {
+    double sum_pospair = 0.0;
+    double sum_npos = 0.0, sum_nneg = 0.0, buf_pos = 0.0, buf_neg = 0.0;
+    for (size_t j = 0; j < n; ++j) {
+      const bst_float wt
+        = WeightPolicy::GetWeightOfSortedRecord(info, rec, j, group_id);
+      const bst_float ctr = labels[rec[j].second];
+      // keep bucketing predictions in same bucket
+      if (j != 0 && rec[j].first != rec[j - 1].first) {
+        sum_pospair += buf_neg * (sum_npos + buf_pos *0.5);
+        sum_npos += buf_pos;
+        sum_nneg += buf_neg;
+        buf_neg = buf_pos = 0.0f;
+      }
+      buf_pos += ctr * wt;
+      buf_neg += (1.0f - ctr) * wt;
+    }
+    sum_pospair += buf_neg * (sum_npos + buf_pos * 0.5);
+    sum_npos += buf_pos;
+    sum_nneg += buf_neg;
+    // check weird conditions
+    if (sum_npos <= 0.0 || sum_nneg <= 0.0) {
+      return -1.0;
+    }
+    // this is the AUC
+    return sum_pospair / (sum_npos * sum_nneg);
+  }
+  /*!
+   * \brief AUC of the rows [begin, end) of group group_id, from the weights of
+   *  positive and negative samples in nbins_ equal-width bins of the predictions.
+   *  The samples of a bin count as tied, which moves the AUC by at most half the
+   *  fraction of positive-negative pairs in the same bin.
+   * \param nthread number of threads filling the histogram
+   * \return the AUC, a negative value when the group lacks positive or negative
+   *  samples, or NaN when a prediction is NaN
+   */
+  template <typename WeightPolicy>
+  double ApproxAuc(const std::vector<bst_float>& preds, const MetaInfo& info,
+                   const std::vector<bst_float>& labels, bst_omp_uint begin,
+                   bst_omp_uint end, unsigned group_id, int nthread) const {
+    std::vector<bst_float> tmin(nthread, std::numeric_limits<bst_float>::max());
+    std::vector<bst_float> tmax(nthread, std::numeric_limits<bst_float>::lowest());
+    int nan_error = 0;
+    #pragma omp parallel num_threads(nthread) reduction(+:nan_error)
+    {
+      const int tid = omp_get_thread_num();
+      #pragma omp for schedule(static)
+      for (bst_omp_uint i = begin; i < end; ++i) {
+        // the bin width is taken from the finite predictions only
+        if (std::isfinite(preds[i])) {
+          tmin[tid] = std::min(tmin[tid], preds[i]);
+          tmax[tid] = std::max(tmax[tid], preds[i]);
+        } else if (std::isnan(preds[i])) {
+          nan_error = 1;
+        }
+      }
+    }
+    if (nan_error) {
+      return std::numeric_limits<double>::quiet_NaN();
+    }
+    const bst_float lo = *std::min_element(tmin.begin(), tmin.end());
+    const bst_float hi = *std::max_element(tmax.begin(), tmax.end());
+    const double scale = hi > lo ? nbins_ / (static_cast<double>(hi) - lo) : 0.0;
+    // weight of positive and negative samples in each bin, per thread
+    std::vector<double> hist(static_cast<size_t>(nthread) * nbins_ * 2, 0.0);
+    #pragma omp parallel num_threads(nthread)
+    {
+      double* thist = hist.data() + static_cast<size_t>(omp_get_thread_num()) * nbins_ * 2;
+      #pragma omp for schedule(static)
+      for (bst_omp_uint i = begin; i < end; ++i) {
+        // infinite predictions fall into the first or the last bin
+        const unsigned bin = preds[i] <= lo ? 0
+            : preds[i] >= hi ? nbins_ - 1
+            : std::min(static_cast<unsigned>((preds[i] - lo) * scale), nbins_ - 1);
+        const bst_float wt = WeightPolicy::GetWeightOfInstance(info, i, group_id);
+        thist[bin * 2] += labels[i] * wt;
+        thist[bin * 2 + 1] += (1.0f - labels[i]) * wt;
+      }
+    }
+    double sum_pospair = 0.0, sum_tiedpair = 0.0, sum_npos = 0.0, sum_nneg = 0.0;
+    for (unsigned bin = nbins_; bin-- != 0;) {
+      double buf_pos = 0.0, buf_neg = 0.0;
+      for (int tid = 0; tid < nthread; ++tid) {
+        buf_pos += hist[(static_cast<size_t>(tid) * nbins_ + bin) * 2];
+        buf_neg += hist[(static_cast<size_t>(tid) * nbins_ + bin) * 2 + 1];
+      }
+      sum_pospair += buf_neg * (sum_npos + buf_pos * 0.5);
+      sum_tiedpair += buf_neg * buf_pos;
+      sum_npos += buf_pos;
+      sum_nneg += buf_neg;
+    }
+    if (sum_npos <= 0.0 || sum_nneg <= 0.0) {
+      return -1.0;
+    }
+    LOG(DEBUG) << name_ << ": error bound of group " << group_id << " "
+               << 0.5 * sum_tiedpair / (sum_npos * sum_nneg);
+    return sum_pospair / (sum_npos * sum_nneg);
+  }
+
+  template <typename WeightPolicy>
+  bst_float EvalGroups(const HostDeviceVector<bst_float> &preds,
+                       const MetaInfo &info,
+                       bool distributed,
+                       const PredictionOrder* order) {
     CHECK_NE(info.labels_.Size(), 0U) << "label set cannot be empty";
     CHECK_EQ(preds.Size(), info.labels_.Size())
         << "label size predict size not match";
@@ -159,43 +393,29 @@ struct EvalAuc : public Metric {
     // sum of all AUC's across all query groups
     double sum_auc = 0.0;
     int auc_error = 0;
-    // each thread takes a local rec
-    std::vector<std::pair<bst_float, unsigned>> rec;
+    const auto& h_preds = preds.HostVector();
     const auto& labels = info.labels_.HostVector();
-    const std::vector<bst_float>& h_preds = preds.HostVector();
-    for (bst_omp_uint group_id = 0; group_id < ngroup; ++group_id) {
-      rec.clear();
-      for (unsigned j = gptr[group_id]; j < gptr[group_id + 1]; ++j) {
-        rec.emplace_back(h_preds[j], j);
-      }
-      XGBOOST_PARALLEL_SORT(rec.begin(), rec.end(), common::CmpFirst);
-      // calculate AUC
-      double sum_pospair = 0.0;
-      double sum_npos = 0.0, sum_nneg = 0.0, buf_pos = 0.0, buf_neg = 0.0;
-      for (size_t j = 0; j < rec.size(); ++j) {
-        const bst_float wt
-          = WeightPolicy::GetWeightOfSortedRecord(info, rec, j, group_id);
-        const bst_float ctr = labels[rec[j].second];
-        // keep bucketing predictions in same bucket
-        if (j != 0 && rec[j].first != rec[j - 1].first) {
-          sum_pospair += buf_neg * (sum_npos + buf_pos *0.5);
-          sum_npos += buf_pos;
-          sum_nneg += buf_neg;
-          buf_neg = buf_pos = 0.0f;
+    if (order == nullptr && ngroup == 1) {
+      // the histogram of a single group is filled by all threads
+      const double auc = ApproxAuc<WeightPolicy>(h_preds, info, labels, 0, gptr[1], 0,
+                                                 omp_get_max_threads());
+      auc_error = auc < 0.0;
+      sum_auc = auc_error ? 0.0 : auc;
+    } else {
+      #pragma omp parallel for schedule(dynamic, 16) reduction(+:sum_auc, auc_error)
+      for (bst_omp_uint group_id = 0; group_id < ngroup; ++group_id) {
+        const double auc = order == nullptr
+            ? ApproxAuc<WeightPolicy>(h_preds, info, labels, gptr[group_id],
+                                      gptr[group_id + 1], group_id, 1)
+            : GroupAuc<WeightPolicy>(order->rec.data() + gptr[group_id],
+                                     gptr[group_id + 1] - gptr[group_id],
+                                     info, labels, group_id);
+        if (auc < 0.0) {
+          auc_error = 1;
+        } else {
+          sum_auc += auc;
         }
-        buf_pos += ctr * wt;
-        buf_neg += (1.0f - ctr) * wt;
-      }
-      sum_pospair += buf_neg * (sum_npos + buf_pos * 0.5);
-      sum_npos += buf_pos;
-      sum_nneg += buf_neg;
-      // check weird conditions
-      if (sum_npos <= 0.0 || sum_nneg <= 0.0) {
-        auc_error = 1;
-        continue;
       }
-      // this is the AUC
-      sum_auc += sum_pospair / (sum_npos * sum_nneg);
     }
     CHECK(!auc_error)
       << "AUC: the dataset only contains pos or neg samples";
@@ -212,30 +432,41 @@ struct EvalAuc : public Metric {
   }
 
  public:
-  bst_float Eval(const HostDeviceVector<bst_float> &preds,
-                 const MetaInfo &info,
-                 bool distributed) override {
+  bst_float EvalSorted(const HostDeviceVector<bst_float> &preds,
+                       const MetaInfo &info,
+                       bool distributed,
+                       const PredictionOrder* order) override {
     // For ranking task, weights are per-group
     // For binary classification task, weights are per-instance
     const bool is_ranking_task =
       !info.group_ptr_.empty() && info.weights_.Size() != info.num_row_;
     if (is_ranking_task) {
-      return Eval<PerGroupWeightPolicy>(preds, info, distributed);
+      return EvalGroups<PerGroupWeightPolicy>(preds, info, distributed, order);
     } else {
-      return Eval<PerInstanceWeightPolicy>(preds, info, distributed);
+      return EvalGroups<PerInstanceWeightPolicy>(preds, info, distributed, order);
     }
   }
+  // the approximate AUC is computed without sorting
+  bool UsesOrder(const MetaInfo& info) const override {
+    return nbins_ == 0;
+  }
   const char* Name() const override {
-    return "auc";
+    return name_.c_str();
   }
+
+ private:
+  /*! \brief number of bins of the approximate AUC, 0 for the exact AUC */
+  unsigned nbins_;
+  std::string name_;
 };
 
 /*! \brief Evaluate rank list */
-struct EvalRankList : public Metric {
+struct EvalRankList : public SortedPredictionMetric {
  public:
-  bst_float Eval(const HostDeviceVector<bst_float> &preds,
-                 const MetaInfo &info,
-                 bool distributed) override {
+  bst_float EvalSorted(const HostDeviceVector<bst_float> &preds,
+                       const MetaInfo &info,
+                       bool distributed,
+                       const PredictionOrder* order) override {
     CHECK_EQ(preds.Size(), info.labels_.Size())
         << "label size predict size not match";
     // quick consistency when group is not available
@@ -250,7 +481,6 @@ struct EvalRankList : public Metric {
     double sum_metric = 0.0f;
     const auto& labels = info.labels_.HostVector();
 
-    const std::vector<bst_float>& h_preds = preds.HostVector();
 #pragma omp parallel reduction(+:sum_metric)
     {
       // each thread takes a local rec
@@ -259,7 +489,8 @@ struct EvalRankList : public Metric {
       for (bst_omp_uint k = 0; k < ngroup; ++k) {
         rec.clear();
         for (unsigned j = gptr[k]; j < gptr[k + 1]; ++j) {
-          rec.emplace_back(h_preds[j], static_cast<int>(labels[j]));
+          const PredIndPair& sorted = order->rec[j];
+          rec.emplace_back(sorted.first, static_cast<int>(labels[sorted.second]));
         }
         sum_metric += this->EvalMetric(rec);
       }
@@ -298,7 +529,7 @@ struct EvalRankList : public Metric {
       topn_ = std::numeric_limits<unsigned>::max();
     }
   }
-  /*! \return evaluation metric, given the pair_sort record, (pred,label) */
+  /*! \return evaluation metric, given the pair_sort record, (pred,label) sorted by decreasing pred */
   virtual bst_float EvalMetric(std::vector<std::pair<bst_float, unsigned> > &pair_sort) const = 0; // NOLINT(*)
 
  protected:
@@ -315,7 +546,6 @@ struct EvalPrecision : public EvalRankList{
  protected:
   bst_float EvalMetric(std::vector< std::pair<bst_float, unsigned> > &rec) const override {
     // calculate Precision
-    std::sort(rec.begin(), rec.end(), common::CmpFirst);
     unsigned nhit = 0;
     for (size_t j = 0; j < rec.size() && j < this->topn_; ++j) {
       nhit += (rec[j].second != 0);
@@ -341,7 +571,6 @@ struct EvalNDCG : public EvalRankList{
     return sumdcg;
   }
   virtual bst_float EvalMetric(std::vector<std::pair<bst_float, unsigned> > &rec) const { // NOLINT(*)
-    XGBOOST_PARALLEL_STABLE_SORT(rec.begin(), rec.end(), common::CmpFirst);
     bst_float dcg = this->CalcDCG(rec);
     XGBOOST_PARALLEL_STABLE_SORT(rec.begin(), rec.end(), common::CmpSecond);
     bst_float idcg = this->CalcDCG(rec);
@@ -363,7 +592,6 @@ struct EvalMAP : public EvalRankList {
 
  protected:
   bst_float EvalMetric(std::vector< std::pair<bst_float, unsigned> > &rec) const override {
-    std::sort(rec.begin(), rec.end(), common::CmpFirst);
     unsigned nhits = 0;
     double sumap = 0.0;
     for (size_t i = 0; i < rec.size(); ++i) {
@@ -437,15 +665,67 @@ struct EvalCox : public Metric {
 };
 
 /*! \brief Area Under PR Curve, for both classification and rank */
-struct EvalAucPR : public Metric {
+struct EvalAucPR : public SortedPredictionMetric {
   // implementation of AUC-PR for weighted data
   // translated from PRROC R Package
   // see https://doi.org/10.1371/journal.pone.0092209
  private:
+  /*!
+   * \brief AUC-PR of the n records of one group, sorted by decreasing prediction
+   * \param p_error set when the group lacks positive or negative samples
+   */
   template <typename WeightPolicy>
-  bst_float Eval(const HostDeviceVector<bst_float> &preds,
-                 const MetaInfo &info,
-                 bool distributed) {
+  static double GroupAucPR(const PredIndPair* rec, size_t n, const MetaInfo& info,
+                           const std::vector<bst_float>& h_labels, unsigned group_id,
+                           int* p_error) {
+    double total_pos = 0.0;
+    double total_neg = 0.0;
+    for (size_t j = 0; j < n; ++j) {
+      const bst_float wt
+        = WeightPolicy::GetWeightOfInstance(info, rec[j].second, group_id);
+      total_pos += wt * h_labels[rec[j].second];
+      total_neg += wt * (1.0f - h_labels[rec[j].second]);
+    }
+    // we need pos > 0 && neg > 0
+    if (0.0 == total_pos || 0.0 == total_neg) {
+      *p_error = 1;
+    }
+    // calculate AUC
+    double sum_auc = 0.0;
+    double tp = 0.0, prevtp = 0.0, fp = 0.0, prevfp = 0.0, h = 0.0, a = 0.0, b = 0.0;
+    for (size_t j = 0; j < n; ++j) {
+      const bst_float wt
+        = WeightPolicy::GetWeightOfSortedRecord(info, rec, j, group_id);
+      tp += wt * h_labels[rec[j].second];
+      fp += wt * (1.0f - h_labels[rec[j].second]);
+      if ((j < n - 1 && rec[j].first != rec[j + 1].first) || j  == n - 1) {
+        if (tp == prevtp) {
+          a = 1.0;
+          b = 0.0;
+        } else {
+          h = (fp - prevfp) / (tp - prevtp);
+          a = 1.0 + h;
+          b = (prevfp - h * prevtp) / total_pos;
+        }
+        if (0.0 != b) {
+          sum_auc += (tp / total_pos - prevtp / total_pos -
+                      b / a * (std::log(a * tp / total_pos + b) -
+                               std::log(a * prevtp / total_pos + b))) / a;
+        } else {
+          sum_auc += (tp / total_pos - prevtp / total_pos) / a;
+        }
+        prevtp = tp;
+        prevfp = fp;
+      }
+    }
+    return sum_auc;
+  }
+
+  template <typename WeightPolicy>
+  bst_float EvalGroups(const HostDeviceVector<bst_float> &preds,
+                       const MetaInfo &info,
+                       bool distributed,
+                       const PredictionOrder* order) {
     CHECK_NE(info.labels_.Size(), 0U) << "label set cannot be empty";
     CHECK_EQ(preds.Size(), info.labels_.Size())
         << "label size predict size not match";
@@ -459,58 +739,12 @@ struct EvalAucPR : public Metric {
     // sum of all AUC's across all query groups
     double sum_auc = 0.0;
     int auc_error = 0;
-    // each thread takes a local rec
-    std::vector<std::pair<bst_float, unsigned>> rec;
     const auto& h_labels = info.labels_.HostVector();
-    const std::vector<bst_float>& h_preds = preds.HostVector();
-
+    #pragma omp parallel for schedule(dynamic, 16) reduction(+:sum_auc, auc_error)
     for (bst_omp_uint group_id = 0; group_id < ngroup; ++group_id) {
-      double total_pos = 0.0;
-      double total_neg = 0.0;
-      rec.clear();
-      for (unsigned j = gptr[group_id]; j < gptr[group_id + 1]; ++j) {
-        const bst_float wt
-          = WeightPolicy::GetWeightOfInstance(info, j, group_id);
-        total_pos += wt * h_labels[j];
-        total_neg += wt * (1.0f - h_labels[j]);
-        rec.emplace_back(h_preds[j], j);
-      }
-      XGBOOST_PARALLEL_SORT(rec.begin(), rec.end(), common::CmpFirst);
-      // we need pos > 0 && neg > 0
-      if (0.0 == total_pos || 0.0 == total_neg) {
-        auc_error = 1;
-      }
-      // calculate AUC
-      double tp = 0.0, prevtp = 0.0, fp = 0.0, prevfp = 0.0, h = 0.0, a = 0.0, b = 0.0;
-      for (size_t j = 0; j < rec.size(); ++j) {
-        const bst_float wt
-          = WeightPolicy::GetWeightOfSortedRecord(info, rec, j, group_id);
-        tp += wt * h_labels[rec[j].second];
-        fp += wt * (1.0f - h_labels[rec[j].second]);
-        if ((j < rec.size() - 1 && rec[j].first != rec[j + 1].first) || j  == rec.size() - 1) {
-          if (tp == prevtp) {
-            a = 1.0;
-            b = 0.0;
-          } else {
-            h = (fp - prevfp) / (tp - prevtp);
-            a = 1.0 + h;
-            b = (prevfp - h * prevtp) / total_pos;
-          }
-          if (0.0 != b) {
-            sum_auc += (tp / total_pos - prevtp / total_pos -
-                        b / a * (std::log(a * tp / total_pos + b) -
-                                 std::log(a * prevtp / total_pos + b))) / a;
-          } else {
-            sum_auc += (tp / total_pos - prevtp / total_pos) / a;
-          }
-          prevtp = tp;
-          prevfp = fp;
-        }
-      }
-      // sanity check
-      if (tp < 0 || prevtp < 0 || fp < 0 || prevfp < 0) {
-        CHECK(!auc_error) << "AUC-PR: error in calculation";
-      }
+      sum_auc += GroupAucPR<WeightPolicy>(
+          order->rec.data() + gptr[group_id], gptr[group_id + 1] - gptr[group_id],
+          info, h_labels, group_id, &auc_error);
     }
     CHECK(!auc_error) << "AUC-PR: the dataset only contains pos or neg samples";
     /* Report average AUC across all groups */
@@ -528,17 +762,18 @@ struct EvalAucPR : public Metric {
   }
 
  public:
-  bst_float Eval(const HostDeviceVector<bst_float> &preds,
-                 const MetaInfo &info,
-                 bool distributed) override {
+  bst_float EvalSorted(const HostDeviceVector<bst_float> &preds,
+                       const MetaInfo &info,
+                       bool distributed,
+                       const PredictionOrder* order) override {
     // For ranking task, weights are per-group
     // For binary classification task, weights are per-instance
     const bool is_ranking_task =
       !info.group_ptr_.empty() && info.weights_.Size() != info.num_row_;
     if (is_ranking_task) {
-      return Eval<PerGroupWeightPolicy>(preds, info, distributed);
+      return EvalGroups<PerGroupWeightPolicy>(preds, info, distributed, order);
     } else {
-      return Eval<PerInstanceWeightPolicy>(preds, info, distributed);
+      return EvalGroups<PerInstanceWeightPolicy>(preds, info, distributed, order);
     }
   }
   const char *Name() const override { return "aucpr"; }
@@ -551,7 +786,7 @@ XGBOOST_REGISTER_METRIC(AMS, "ams")
 
 XGBOOST_REGISTER_METRIC(Auc, "auc")
 .describe("Area under curve for both classification and rank.")
-.set_body([](const char* param) { return new EvalAuc(); });
+.set_body([](const char* param) { return new EvalAuc(param); });
 
 XGBOOST_REGISTER_METRIC(AucPR, "aucpr")
 .describe("Area under PR curve for both classification and rank.")
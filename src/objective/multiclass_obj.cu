@@ -73,7 +73,7 @@ class SoftmaxMultiClassObj : public ObjFunction {
     label_correct_.Fill(1);
 
     const bool is_null_weight = info.weights_.Size() == 0;
-    common::Transform<>::Init(
+    common::Transform<>::InitBlocked(
         [=] XGBOOST_DEVICE(size_t idx,
                            common::Span<GradientPair> gpair,
                            common::Span<bst_float const> labels,
@@ -101,7 +101,46 @@ class SoftmaxMultiClassObj : public ObjFunction {
             p = label == k ? p - 1.0f : p;
             gpair[idx * nclass + k] = GradientPair(p * wt, h);
           }
-        }, common::Range{0, ndata}, devices_, false)
+        },
+        [=](size_t begin, size_t end,
+            common::Span<GradientPair> gpair,
+            common::Span<bst_float const> labels,
+            common::Span<bst_float const> preds,
+            common::Span<bst_float const> weights,
+            common::Span<int> _label_correct) {
+          // exponentials of the current row, computed once per class
+          std::vector<bst_float> exps(nclass);
+          const bst_float* weights_ptr = is_null_weight ? nullptr : weights.data();
+          int label_correct = 1;
+          for (size_t idx = begin; idx < end; ++idx) {
+            const bst_float* point = preds.data() + idx * nclass;
+            GradientPair* out = gpair.data() + idx * nclass;
+            bst_float wmax = std::numeric_limits<bst_float>::min();
+            for (int k = 0; k < nclass; ++k) { wmax = fmaxf(point[k], wmax); }
+            double wsum = 0.0f;
+            for (int k = 0; k < nclass; ++k) {
+              exps[k] = expf(point[k] - wmax);
+              wsum += exps[k];
+            }
+            auto label = labels[idx];
+            const bool valid = !(label < 0 || label >= nclass);
+            label_correct &= static_cast<int>(valid);
+            label = valid ? label : 0;
+            const bst_float wt = weights_ptr == nullptr ? 1.0f : weights_ptr[idx];
+            const auto norm = static_cast<float>(wsum);
+            for (int k = 0; k < nclass; ++k) {
+              bst_float p = exps[k] / norm;
+              const float eps = 1e-16f;
+              const bst_float h = fmax(2.0f * p * (1.0f - p) * wt, eps);
+              p = label == k ? p - 1.0f : p;
+              out[k] = GradientPair(p * wt, h);
+            }
+          }
+          if (!label_correct) {
+            _label_correct[0] = 0;
+          }
+        },
+        common::Range{0, ndata}, devices_, false)
         .Eval(out_gpair, &info.labels_, &preds, &info.weights_, &label_correct_);
 
     std::vector<int>& label_correct_h = label_correct_.HostVector();
@@ -124,7 +163,6 @@ class SoftmaxMultiClassObj : public ObjFunction {
   inline void Transform(HostDeviceVector<bst_float> *io_preds, bool prob) {
     const int nclass = param_.num_class;
     const auto ndata = static_cast<int64_t>(io_preds->Size() / nclass);
-    max_preds_.Resize(ndata);
 
     if (prob) {
       common::Transform<>::Init(
@@ -136,8 +174,11 @@ class SoftmaxMultiClassObj : public ObjFunction {
           common::Range{0, ndata}, GPUDistribution::Granular(devices_, nclass))
         .Eval(io_preds);
     } else {
+      // a buffer per call, several threads may predict with the same objective
+      HostDeviceVector<bst_float> max_preds;
+      max_preds.Resize(ndata);
       io_preds->Shard(GPUDistribution::Granular(devices_, nclass));
-      max_preds_.Shard(GPUDistribution::Block(devices_));
+      max_preds.Shard(GPUDistribution::Block(devices_));
       common::Transform<>::Init(
           [=] XGBOOST_DEVICE(size_t _idx,
                              common::Span<const bst_float> _preds,
@@ -149,11 +190,9 @@ class SoftmaxMultiClassObj : public ObjFunction {
                                      point.cend()) - point.cbegin();
           },
           common::Range{0, ndata}, devices_, false)
-        .Eval(io_preds, &max_preds_);
-    }
-    if (!prob) {
-      io_preds->Resize(max_preds_.Size());
-      io_preds->Copy(max_preds_);
+        .Eval(io_preds, &max_preds);
+      io_preds->Resize(max_preds.Size());
+      io_preds->Copy(max_preds);
     }
   }
 
@@ -163,8 +202,6 @@ class SoftmaxMultiClassObj : public ObjFunction {
   // parameter
   SoftmaxMultiClassParam param_;
   GPUSet devices_;
-  // Cache for max_preds
-  HostDeviceVector<bst_float> max_preds_;
   HostDeviceVector<int> label_correct_;
 };
 
@@ -9,9 +9,10 @@
 #include <xgboost/objective.h>
 #include <vector>
 #include <algorithm>
+#include <memory>
+#include <random>
 #include <utility>
 #include "../common/math.h"
-#include "../common/random.h"
 
 namespace xgboost {
 namespace obj {
@@ -51,77 +52,54 @@ class LambdaRankObj : public ObjFunction {
     const std::vector<unsigned> &gptr = info.group_ptr_.size() == 0 ? tgptr : info.group_ptr_;
     CHECK(gptr.size() != 0 && gptr.back() == info.labels_.Size())
         << "group structure not consistent with #rows";
+    const auto& labels = info.labels_.HostVector();
+    this->InitGroups(labels, gptr);
 
     const auto ngroup = static_cast<bst_omp_uint>(gptr.size() - 1);
-    #pragma omp parallel
-    {
-      // parall construct, declare random number generator here, so that each
-      // thread use its own random number generator, seed by thread id and current iteration
-      common::RandomEngine rnd(iter * 1111 + omp_get_thread_num());
+    bst_float sum_weights = 0;
+    for (bst_omp_uint k = 0; k < ngroup; ++k) {
+      sum_weights += info.GetWeight(k);
+    }
+    const bst_float weight_normalization_factor = ngroup / sum_weights;
+    const int nthread = omp_get_max_threads();
+    while (arenas_.size() < static_cast<size_t>(nthread)) {
+      arenas_.emplace_back();
+      arenas_.back().stats = this->CreateListStats();
+    }
 
-      std::vector<LambdaPair> pairs;
-      std::vector<ListEntry>  lst;
-      std::vector< std::pair<bst_float, unsigned> > rec;
-      bst_float sum_weights = 0;
-      for (bst_omp_uint k = 0; k < ngroup; ++k) {
-        sum_weights += info.GetWeight(k);
+    // a group larger than the share of a thread is processed by all threads
+    // together, after it the remaining groups are balanced dynamically
+    size_t split_size = gptr.back() / nthread;
+    if (split_size < kMinSplitGroupSize) split_size = kMinSplitGroupSize;
+    for (bst_omp_uint k = 0; k < ngroup; ++k) {
+      if (gptr[k + 1] - gptr[k] >= split_size) {
+        this->GetSplitGroupGradient(k, iter, preds_h, labels,
+                                    info.GetWeight(k) * weight_normalization_factor, &gpair);
       }
-      bst_float weight_normalization_factor = ngroup/sum_weights;
-      const auto& labels = info.labels_.HostVector();
-      #pragma omp for schedule(static)
+    }
+    #pragma omp parallel num_threads(nthread)
+    {
+      Arena& arena = arenas_[omp_get_thread_num()];
+      #pragma omp for schedule(dynamic, 16)
       for (bst_omp_uint k = 0; k < ngroup; ++k) {
-        lst.clear(); pairs.clear();
-        for (unsigned j = gptr[k]; j < gptr[k+1]; ++j) {
-          lst.emplace_back(preds_h[j], labels[j], j);
-          gpair[j] = GradientPair(0.0f, 0.0f);
-        }
-        std::sort(lst.begin(), lst.end(), ListEntry::CmpPred);
-        rec.resize(lst.size());
-        for (unsigned i = 0; i < lst.size(); ++i) {
-          rec[i] = std::make_pair(lst[i].label, i);
-        }
-        std::sort(rec.begin(), rec.end(), common::CmpFirst);
-        // enumerate buckets with same label, for each item in the lst, grab another sample randomly
-        for (unsigned i = 0; i < rec.size(); ) {
-          unsigned j = i + 1;
-          while (j < rec.size() && rec[j].first == rec[i].first) ++j;
-          // bucket in [i,j), get a sample outside bucket
-          unsigned nleft = i, nright = static_cast<unsigned>(rec.size() - j);
-          if (nleft + nright != 0) {
-            int nsample = param_.num_pairsample;
-            while (nsample --) {
-              for (unsigned pid = i; pid < j; ++pid) {
-                unsigned ridx = std::uniform_int_distribution<unsigned>(0, nleft + nright - 1)(rnd);
-                if (ridx < nleft) {
-                  pairs.emplace_back(rec[ridx].second, rec[pid].second,
-                      info.GetWeight(k) * weight_normalization_factor);
-                } else {
-                  pairs.emplace_back(rec[pid].second, rec[ridx+j-i].second,
-                      info.GetWeight(k) * weight_normalization_factor);
-                }
-              }
-            }
-          }
-          i = j;
-        }
+        if (gptr[k + 1] - gptr[k] >= split_size) continue;
+        this->BuildList(k, preds_h, labels, &arena, &gpair);
+        // each group draws from its own stream, so that the pairs do not depend
+        // on which thread processes it
+        std::minstd_rand rnd(Seed(iter, k, 0));
+        arena.pairs.clear();
+        this->SamplePairs(k, 0, gptr_[k + 1] - gptr_[k], arena.position,
+                          info.GetWeight(k) * weight_normalization_factor, &rnd, &arena.pairs);
+        if (arena.pairs.empty()) continue;
+        this->InitListStats(arena.lst, arena.stats.get());
         // get lambda weight for the pairs
-        this->GetLambdaWeight(lst, &pairs);
-        // rescale each gradient and hessian so that the lst have constant weighted
-        float scale = 1.0f / param_.num_pairsample;
-        if (param_.fix_list_weight != 0.0f) {
-          scale *= param_.fix_list_weight / (gptr[k + 1] - gptr[k]);
-        }
-        for (auto & pair : pairs) {
-          const ListEntry &pos = lst[pair.pos_index];
-          const ListEntry &neg = lst[pair.neg_index];
-          const bst_float w = pair.weight * scale;
-          const float eps = 1e-16f;
-          bst_float p = common::Sigmoid(pos.pred - neg.pred);
-          bst_float g = p - 1.0f;
-          bst_float h = std::max(p * (1.0f - p), eps);
-          // accumulate gradient and hessian in both pid, and nid
-          gpair[pos.rindex] += GradientPair(g * w, 2.0f*w*h);
-          gpair[neg.rindex] += GradientPair(-g * w, 2.0f*w*h);
+        this->GetLambdaWeight(arena.lst, k, arena.stats.get(),
+                              arena.pairs.data(), arena.pairs.data() + arena.pairs.size());
+        const float scale = this->ListScale(k);
+        for (const auto& pair : arena.pairs) {
+          const GradientPair c = PairGradient(arena.lst, pair, scale);
+          gpair[arena.lst[pair.pos_index].rindex] += c;
+          gpair[arena.lst[pair.neg_index].rindex] += GradientPair(-c.GetGrad(), c.GetHess());
         }
       }
     }
@@ -166,48 +144,262 @@ class LambdaRankObj : public ObjFunction {
     LambdaPair(unsigned pos_index, unsigned neg_index, bst_float weight)
         : pos_index(pos_index), neg_index(neg_index), weight(weight) {}
   };
+  /*! \brief statistics of a sorted list used by GetLambdaWeight, computed once per list */
+  struct ListStats {
+    virtual ~ListStats() = default;
+  };
+  virtual std::unique_ptr<ListStats> CreateListStats() const {
+    return std::unique_ptr<ListStats>();
+  }
+  virtual void InitListStats(const std::vector<ListEntry> &sorted_list,
+                             ListStats* stats) const {}
+  /*!
+   * \brief called when the labels or groups change
+   * \param gptr group boundaries
+   * \param label_order positions in its group of the rows of each group, by decreasing label
+   * \param labels labels of the rows
+   */
+  virtual void InitGroupLabels(const std::vector<unsigned> &gptr,
+                               const std::vector<unsigned> &label_order,
+                               const std::vector<bst_float> &labels) {}
   /*!
    * \brief get lambda weight for existing pairs
    * \param list a list that is sorted by pred score
-   * \param io_pairs record of pairs, containing the pairs to fill in weights
+   * \param group the group of the list
+   * \param stats statistics of the list from InitListStats
+   * \param begin, end range of pairs to fill in weights
    */
-  virtual void GetLambdaWeight(const std::vector<ListEntry> &sorted_list,
-                               std::vector<LambdaPair> *io_pairs) = 0;
+  virtual void GetLambdaWeight(const std::vector<ListEntry> &sorted_list, unsigned group,
+                               const ListStats* stats,
+                               LambdaPair* begin, LambdaPair* end) const = 0;
 
  private:
+  /*! \brief groups at least this large may be split across threads */
+  static constexpr size_t kMinSplitGroupSize = 1 << 14;
+  /*! \brief items of a split group sampled by one task */
+  static constexpr unsigned kSplitChunkSize = 1 << 12;
+
+  /*! \brief buffers of a thread, reused for every list */
+  struct Arena {
+    std::vector<ListEntry> lst;
+    /*! \brief position of each row of the group in lst */
+    std::vector<unsigned> position;
+    std::vector<LambdaPair> pairs;
+    /*! \brief gradient of each pair, when a group is split */
+    std::vector<GradientPair> contrib;
+    std::unique_ptr<ListStats> stats;
+  };
+
+  static uint32_t Seed(int iter, unsigned group, unsigned chunk) {
+    return (static_cast<uint32_t>(iter) * 1111U + group) * 7919U + chunk;
+  }
+  // rescale each gradient and hessian so that the lst have constant weighted
+  float ListScale(unsigned group) const {
+    float scale = 1.0f / param_.num_pairsample;
+    if (param_.fix_list_weight != 0.0f) {
+      scale *= param_.fix_list_weight / (gptr_[group + 1] - gptr_[group]);
+    }
+    return scale;
+  }
+  // gradient of the positive entry of a pair, the negative one gets its opposite
+  static GradientPair PairGradient(const std::vector<ListEntry>& lst, const LambdaPair& pair,
+                                   float scale) {
+    const ListEntry &pos = lst[pair.pos_index];
+    const ListEntry &neg = lst[pair.neg_index];
+    const bst_float w = pair.weight * scale;
+    const float eps = 1e-16f;
+    bst_float p = common::Sigmoid(pos.pred - neg.pred);
+    bst_float g = p - 1.0f;
+    bst_float h = std::max(p * (1.0f - p), eps);
+    return GradientPair(g * w, 2.0f*w*h);
+  }
+
+  /*!
+   * \brief compute the label order and label buckets of the groups. Labels do not
+   *  change between iterations, so this is only redone when they do.
+   */
+  void InitGroups(const std::vector<bst_float>& labels, const std::vector<unsigned>& gptr) {
+    if (labels == cached_labels_ && gptr == gptr_) return;
+    cached_labels_ = labels;
+    gptr_ = gptr;
+    const auto ngroup = static_cast<bst_omp_uint>(gptr.size() - 1);
+    label_order_.resize(labels.size());
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (bst_omp_uint k = 0; k < ngroup; ++k) {
+      unsigned* order = label_order_.data() + gptr[k];
+      const unsigned n = gptr[k + 1] - gptr[k];
+      for (unsigned i = 0; i < n; ++i) {
+        order[i] = i;
+      }
+      const bst_float* group_labels = labels.data() + gptr[k];
+      std::sort(order, order + n, [group_labels](unsigned a, unsigned b) {
+        return group_labels[a] > group_labels[b];
+      });
+    }
+    // buckets of rows with the same label, in label order
+    bucket_ptr_.clear();
+    group_bucket_.resize(ngroup + 1);
+    for (bst_omp_uint k = 0; k < ngroup; ++k) {
+      group_bucket_[k] = static_cast<unsigned>(bucket_ptr_.size());
+      for (unsigned i = gptr[k]; i < gptr[k + 1]; ++i) {
+        if (i == gptr[k] || labels[gptr[k] + label_order_[i]] !=
+                                labels[gptr[k] + label_order_[i - 1]]) {
+          bucket_ptr_.push_back(i);
+        }
+      }
+    }
+    group_bucket_[ngroup] = static_cast<unsigned>(bucket_ptr_.size());
+    bucket_ptr_.push_back(gptr.back());
+    this->InitGroupLabels(gptr, label_order_, labels);
+  }
+
+  // sort the entries of group k by prediction, and clear their gradient
+  void BuildList(unsigned k, const std::vector<bst_float>& preds,
+                 const std::vector<bst_float>& labels, Arena* arena,
+                 std::vector<GradientPair>* gpair) const {
+    std::vector<ListEntry>& lst = arena->lst;
+    lst.clear();
+    for (unsigned j = gptr_[k]; j < gptr_[k + 1]; ++j) {
+      lst.emplace_back(preds[j], labels[j], j);
+      (*gpair)[j] = GradientPair(0.0f, 0.0f);
+    }
+    std::sort(lst.begin(), lst.end(), ListEntry::CmpPred);
+    arena->position.resize(lst.size());
+    for (unsigned i = 0; i < lst.size(); ++i) {
+      arena->position[lst[i].rindex - gptr_[k]] = i;
+    }
+  }
+
+  /*!
+   * \brief for the items [begin, end) of group k in label order, grab num_pairsample
+   *  other samples randomly outside the bucket of their label
+   */
+  void SamplePairs(unsigned k, unsigned begin, unsigned end,
+                   const std::vector<unsigned>& position, bst_float weight,
+                   std::minstd_rand* rnd, std::vector<LambdaPair>* pairs) const {
+    const unsigned base = gptr_[k];
+    const unsigned n = gptr_[k + 1] - base;
+    const unsigned* order = label_order_.data() + base;
+    size_t b = std::upper_bound(bucket_ptr_.cbegin() + group_bucket_[k],
+                                bucket_ptr_.cbegin() + group_bucket_[k + 1],
+                                base + begin) - bucket_ptr_.cbegin() - 1;
+    for (unsigned first = begin; first < end; ++b) {
+      // bucket in [i,j), get a sample outside bucket
+      const unsigned i = bucket_ptr_[b] - base;
+      const unsigned j = bucket_ptr_[b + 1] - base;
+      const unsigned last = std::min(j, end);
+      unsigned nleft = i, nright = n - j;
+      if (nleft + nright != 0) {
+        int nsample = param_.num_pairsample;
+        while (nsample --) {
+          for (unsigned pid = first; pid < last; ++pid) {
+            unsigned ridx = std::uniform_int_distribution<unsigned>(0, nleft + nright - 1)(*rnd);
+            if (ridx < nleft) {
+              pairs->emplace_back(position[order[ridx]], position[order[pid]], weight);
+            } else {
+              pairs->emplace_back(position[order[pid]], position[order[ridx + j - i]], weight);
+            }
+          }
+        }
+      }
+      first = last;
+    }
+  }
+
+  /*!
+   * \brief gradient of a group too large for one thread. The list is sorted once,
+   *  then chunks of it are sampled and weighted in parallel, and the gradients of
+   *  the pairs are added up in order.
+   */
+  void GetSplitGroupGradient(unsigned k, int iter, const std::vector<bst_float>& preds,
+                             const std::vector<bst_float>& labels, bst_float weight,
+                             std::vector<GradientPair>* out_gpair) {
+    std::vector<GradientPair>& gpair = *out_gpair;
+    Arena& list = arenas_[0];
+    this->BuildList(k, preds, labels, &list, out_gpair);
+    this->InitListStats(list.lst, list.stats.get());
+    const unsigned n = gptr_[k + 1] - gptr_[k];
+    const auto nchunk = static_cast<bst_omp_uint>((n + kSplitChunkSize - 1) / kSplitChunkSize);
+    if (chunk_pairs_.size() < nchunk) {
+      chunk_pairs_.resize(nchunk);
+      chunk_contrib_.resize(nchunk);
+    }
+    const float scale = this->ListScale(k);
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (bst_omp_uint c = 0; c < nchunk; ++c) {
+      std::vector<LambdaPair>& pairs = chunk_pairs_[c];
+      std::vector<GradientPair>& contrib = chunk_contrib_[c];
+      std::minstd_rand rnd(Seed(iter, k, c + 1));
+      pairs.clear();
+      this->SamplePairs(k, c * kSplitChunkSize, std::min(n, (c + 1) * kSplitChunkSize),
+                        list.position, weight, &rnd, &pairs);
+      this->GetLambdaWeight(list.lst, k, list.stats.get(),
+                            pairs.data(), pairs.data() + pairs.size());
+      contrib.resize(pairs.size());
+      for (size_t i = 0; i < pairs.size(); ++i) {
+        contrib[i] = PairGradient(list.lst, pairs[i], scale);
+      }
+    }
+    for (bst_omp_uint c = 0; c < nchunk; ++c) {
+      for (size_t i = 0; i < chunk_pairs_[c].size(); ++i) {
+        const LambdaPair& pair = chunk_pairs_[c][i];
+        const GradientPair& g = chunk_contrib_[c][i];
+        gpair[list.lst[pair.pos_index].rindex] += g;
+        gpair[list.lst[pair.neg_index].rindex] += GradientPair(-g.GetGrad(), g.GetHess());
+      }
+    }
+  }
+
   LambdaRankParam param_;
+  /*! \brief labels and groups the label order was computed for */
+  std::vector<bst_float> cached_labels_;
+  std::vector<unsigned> gptr_;
+  /*! \brief positions in its group of the rows of each group, by decreasing label */
+  std::vector<unsigned> label_order_;
+  /*! \brief first position in label_order_ of each bucket of rows with the same label */
+  std::vector<unsigned> bucket_ptr_;
+  /*! \brief first bucket of each group */
+  std::vector<unsigned> group_bucket_;
+  std::vector<Arena> arenas_;
+  /*! \brief pairs and their gradients of each chunk of a split group */
+  std::vector<std::vector<LambdaPair> > chunk_pairs_;
+  std::vector<std::vector<GradientPair> > chunk_contrib_;
 };
 
 class PairwiseRankObj: public LambdaRankObj{
  protected:
-  void GetLambdaWeight(const std::vector<ListEntry> &sorted_list,
-                       std::vector<LambdaPair> *io_pairs) override {}
+  void GetLambdaWeight(const std::vector<ListEntry> &sorted_list, unsigned group,
+                       const ListStats* stats,
+                       LambdaPair* begin, LambdaPair* end) const override {}
 };
 
 // beta version: NDCG lambda rank
 class LambdaRankObjNDCG : public LambdaRankObj {
  protected:
-  void GetLambdaWeight(const std::vector<ListEntry> &sorted_list,
-                       std::vector<LambdaPair> *io_pairs) override {
-    std::vector<LambdaPair> &pairs = *io_pairs;
-    float IDCG;  // NOLINT
-    {
-      std::vector<bst_float> labels(sorted_list.size());
-      for (size_t i = 0; i < sorted_list.size(); ++i) {
-        labels[i] = sorted_list[i].label;
-      }
-      std::sort(labels.begin(), labels.end(), std::greater<bst_float>());
-      IDCG = CalcDCG(labels);
+  void InitGroupLabels(const std::vector<unsigned> &gptr,
+                       const std::vector<unsigned> &label_order,
+                       const std::vector<bst_float> &labels) override {
+    const auto ngroup = static_cast<bst_omp_uint>(gptr.size() - 1);
+    inv_idcg_.resize(ngroup);
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (bst_omp_uint k = 0; k < ngroup; ++k) {
+      float IDCG = CalcDCG(labels.data() + gptr[k], label_order.data() + gptr[k],  // NOLINT
+                           gptr[k + 1] - gptr[k]);
+      inv_idcg_[k] = IDCG == 0.0f ? 0.0f : 1.0f / IDCG;
     }
-    if (IDCG == 0.0) {
-      for (auto & pair : pairs) {
-        pair.weight = 0.0f;
+  }
+  void GetLambdaWeight(const std::vector<ListEntry> &sorted_list, unsigned group,
+                       const ListStats* stats,
+                       LambdaPair* begin, LambdaPair* end) const override {
+    const bst_float inv_idcg = inv_idcg_[group];
+    if (inv_idcg == 0.0f) {
+      for (LambdaPair* pair = begin; pair != end; ++pair) {
+        pair->weight = 0.0f;
       }
     } else {
-      IDCG = 1.0f / IDCG;
-      for (auto & pair : pairs) {
-        unsigned pos_idx = pair.pos_index;
-        unsigned neg_idx = pair.neg_index;
+      for (LambdaPair* pair = begin; pair != end; ++pair) {
+        unsigned pos_idx = pair->pos_index;
+        unsigned neg_idx = pair->neg_index;
         float pos_loginv = 1.0f / std::log2(pos_idx + 2.0f);
         float neg_loginv = 1.0f / std::log2(neg_idx + 2.0f);
         auto pos_label = static_cast<int>(sorted_list[pos_idx].label);
@@ -216,22 +408,27 @@ class LambdaRankObjNDCG : public LambdaRankObj {
             ((1 << pos_label) - 1) * pos_loginv + ((1 << neg_label) - 1) * neg_loginv;
         float changed  =
             ((1 << neg_label) - 1) * pos_loginv + ((1 << pos_label) - 1) * neg_loginv;
-        bst_float delta = (original - changed) * IDCG;
+        bst_float delta = (original - changed) * inv_idcg;
         if (delta < 0.0f) delta = - delta;
-        pair.weight *= delta;
+        pair->weight *= delta;
       }
     }
   }
-  inline static bst_float CalcDCG(const std::vector<bst_float> &labels) {
+  // DCG of the n labels taken in the given order
+  inline static bst_float CalcDCG(const bst_float* labels, const unsigned* order, unsigned n) {
     double sumdcg = 0.0;
-    for (size_t i = 0; i < labels.size(); ++i) {
-      const auto rel = static_cast<unsigned>(labels[i]);
+    for (unsigned i = 0; i < n; ++i) {
+      const auto rel = static_cast<unsigned>(labels[order[i]]);
       if (rel != 0) {
         sumdcg += ((1 << rel) - 1) / std::log2(static_cast<bst_float>(i + 2));
       }
     }
     return static_cast<bst_float>(sumdcg);
   }
+
+ private:
+  /*! \brief inverse of the ideal DCG of each group, 0 when the ideal DCG is 0 */
+  std::vector<bst_float> inv_idcg_;
 };
 
 class LambdaRankObjMAP : public LambdaRankObj {
@@ -264,8 +461,7 @@ class LambdaRankObjMAP : public LambdaRankObj {
    */
   inline bst_float GetLambdaMAP(const std::vector<ListEntry> &sorted_list,
                                 int index1, int index2,
-                                std::vector<MAPStats> *p_map_stats) {
-    std::vector<MAPStats> &map_stats = *p_map_stats;
+                                const std::vector<MAPStats> &map_stats) const {
     if (index1 == index2 || map_stats[map_stats.size() - 1].hits == 0) {
       return 0.0f;
     }
@@ -294,7 +490,7 @@ class LambdaRankObjMAP : public LambdaRankObj {
    * \param map_stats a vector containing the accumulated precisions for each position in a list
    */
   inline void GetMAPStats(const std::vector<ListEntry> &sorted_list,
-                          std::vector<MAPStats> *p_map_acc) {
+                          std::vector<MAPStats> *p_map_acc) const {
     std::vector<MAPStats> &map_acc = *p_map_acc;
     map_acc.resize(sorted_list.size());
     bst_float hit = 0, acc1 = 0, acc2 = 0, acc3 = 0;
@@ -308,15 +504,25 @@ class LambdaRankObjMAP : public LambdaRankObj {
       map_acc[i - 1] = MAPStats(acc1, acc2, acc3, hit);
     }
   }
-  void GetLambdaWeight(const std::vector<ListEntry> &sorted_list,
-                       std::vector<LambdaPair> *io_pairs) override {
-    std::vector<LambdaPair> &pairs = *io_pairs;
+  struct MAPListStats : public ListStats {
     std::vector<MAPStats> map_stats;
-    GetMAPStats(sorted_list, &map_stats);
-    for (auto & pair : pairs) {
-      pair.weight *=
-          GetLambdaMAP(sorted_list, pair.pos_index,
-                       pair.neg_index, &map_stats);
+  };
+  std::unique_ptr<ListStats> CreateListStats() const override {
+    return std::unique_ptr<ListStats>(new MAPListStats());
+  }
+  void InitListStats(const std::vector<ListEntry> &sorted_list,
+                     ListStats* stats) const override {
+    GetMAPStats(sorted_list, &static_cast<MAPListStats*>(stats)->map_stats);
+  }
+  void GetLambdaWeight(const std::vector<ListEntry> &sorted_list, unsigned group,
+                       const ListStats* stats,
+                       LambdaPair* begin, LambdaPair* end) const override {
+    const std::vector<MAPStats> &map_stats =
+        static_cast<const MAPListStats*>(stats)->map_stats;
+    for (LambdaPair* pair = begin; pair != end; ++pair) {
+      pair->weight *=
+          GetLambdaMAP(sorted_list, pair->pos_index,
+                       pair->neg_index, map_stats);
     }
   }
 };
@@ -43,6 +43,43 @@ struct RegLossParam : public dmlc::Parameter<RegLossParam> {
   }
 };
 
+/*!
+ * \brief CPU block kernel shared by the element-wise objectives.
+ *
+ *  Writes the gradient of rows [begin, end) to out_gpair.  The weight lookup is
+ *  hoisted out of the loop and the positive label scaling is a select, so the
+ *  loop body has no branch.  Returns false if check rejected any label.
+ *
+ * \param weights Row weights, nullptr for unit weights.
+ * \param grad    Gradient pair of a prediction and a label before weighting.
+ * \param check   Whether a label is valid.
+ */
+template <typename Grad, typename Check>
+inline bool BlockGradient(size_t begin, size_t end,
+                          const bst_float* preds, const bst_float* labels,
+                          const bst_float* weights, bst_float scale_pos_weight,
+                          GradientPair* out_gpair, Grad grad, Check check) {
+  int label_correct = 1;
+  if (weights == nullptr) {
+    for (size_t i = begin; i < end; ++i) {
+      const bst_float y = labels[i];
+      const bst_float w = y == 1.0f ? scale_pos_weight : 1.0f;
+      const GradientPair g = grad(preds[i], y);
+      label_correct &= static_cast<int>(check(y));
+      out_gpair[i] = GradientPair(g.GetGrad() * w, g.GetHess() * w);
+    }
+  } else {
+    for (size_t i = begin; i < end; ++i) {
+      const bst_float y = labels[i];
+      const bst_float w = weights[i] * (y == 1.0f ? scale_pos_weight : 1.0f);
+      const GradientPair g = grad(preds[i], y);
+      label_correct &= static_cast<int>(check(y));
+      out_gpair[i] = GradientPair(g.GetGrad() * w, g.GetHess() * w);
+    }
+  }
+  return label_correct != 0;
+}
+
 template<typename Loss>
 class RegLossObj : public ObjFunction {
  protected:
@@ -71,7 +108,7 @@ class RegLossObj : public ObjFunction {
 
     bool is_null_weight = info.weights_.Size() == 0;
     auto scale_pos_weight = param_.scale_pos_weight;
-    common::Transform<>::Init(
+    common::Transform<>::InitBlocked(
         [=] XGBOOST_DEVICE(size_t _idx,
                            common::Span<int> _label_correct,
                            common::Span<GradientPair> _out_gpair,
@@ -91,6 +128,26 @@ class RegLossObj : public ObjFunction {
           _out_gpair[_idx] = GradientPair(Loss::FirstOrderGradient(p, label) * w,
                                           Loss::SecondOrderGradient(p, label) * w);
         },
+        [=](size_t begin, size_t end,
+            common::Span<int> _label_correct,
+            common::Span<GradientPair> _out_gpair,
+            common::Span<const bst_float> _preds,
+            common::Span<const bst_float> _labels,
+            common::Span<const bst_float> _weights) {
+          bool label_correct = BlockGradient(
+              begin, end, _preds.data(), _labels.data(),
+              is_null_weight ? nullptr : _weights.data(), scale_pos_weight,
+              _out_gpair.data(),
+              [](bst_float pred, bst_float label) {
+                bst_float p = Loss::PredTransform(pred);
+                return GradientPair(Loss::FirstOrderGradient(p, label),
+                                    Loss::SecondOrderGradient(p, label));
+              },
+              [](bst_float label) { return Loss::CheckLabel(label); });
+          if (!label_correct) {
+            _label_correct[0] = 0;
+          }
+        },
         common::Range{0, static_cast<int64_t>(ndata)}, devices_).Eval(
             &label_correct_, out_gpair, &preds, &info.labels_, &info.weights_);
 
@@ -218,7 +275,7 @@ class PoissonRegression : public ObjFunction {
 
     bool is_null_weight = info.weights_.Size() == 0;
     bst_float max_delta_step = param_.max_delta_step;
-    common::Transform<>::Init(
+    common::Transform<>::InitBlocked(
         [=] XGBOOST_DEVICE(size_t _idx,
                            common::Span<int> _label_correct,
                            common::Span<GradientPair> _out_gpair,
@@ -234,6 +291,23 @@ class PoissonRegression : public ObjFunction {
           _out_gpair[_idx] = GradientPair{(expf(p) - y) * w,
                                           expf(p + max_delta_step) * w};
         },
+        [=](size_t begin, size_t end,
+            common::Span<int> _label_correct,
+            common::Span<GradientPair> _out_gpair,
+            common::Span<const bst_float> _preds,
+            common::Span<const bst_float> _labels,
+            common::Span<const bst_float> _weights) {
+          bool label_correct = BlockGradient(
+              begin, end, _preds.data(), _labels.data(),
+              is_null_weight ? nullptr : _weights.data(), 1.0f, _out_gpair.data(),
+              [=](bst_float p, bst_float y) {
+                return GradientPair(expf(p) - y, expf(p + max_delta_step));
+              },
+              [](bst_float y) { return !(y < 0.0f); });
+          if (!label_correct) {
+            _label_correct[0] = 0;
+          }
+        },
         common::Range{0, static_cast<int64_t>(ndata)}, devices_).Eval(
             &label_correct_, out_gpair, &preds, &info.labels_, &info.weights_);
     // copy "label correct" flags back to host
@@ -495,7 +569,7 @@ class TweedieRegression : public ObjFunction {
 
     const bool is_null_weight = info.weights_.Size() == 0;
     const float rho = param_.tweedie_variance_power;
-    common::Transform<>::Init(
+    common::Transform<>::InitBlocked(
         [=] XGBOOST_DEVICE(size_t _idx,
                            common::Span<int> _label_correct,
                            common::Span<GradientPair> _out_gpair,
@@ -514,6 +588,26 @@ class TweedieRegression : public ObjFunction {
               std::exp((1 - rho) * p) + (2 - rho) * expf((2 - rho) * p);
           _out_gpair[_idx] = GradientPair(grad * w, hess * w);
         },
+        [=](size_t begin, size_t end,
+            common::Span<int> _label_correct,
+            common::Span<GradientPair> _out_gpair,
+            common::Span<const bst_float> _preds,
+            common::Span<const bst_float> _labels,
+            common::Span<const bst_float> _weights) {
+          bool label_correct = BlockGradient(
+              begin, end, _preds.data(), _labels.data(),
+              is_null_weight ? nullptr : _weights.data(), 1.0f, _out_gpair.data(),
+              [=](bst_float p, bst_float y) {
+                bst_float grad = -y * expf((1 - rho) * p) + expf((2 - rho) * p);
+                bst_float hess =
+                    -y * (1 - rho) * std::exp((1 - rho) * p) + (2 - rho) * expf((2 - rho) * p);
+                return GradientPair(grad, hess);
+              },
+              [](bst_float y) { return !(y < 0.0f); });
+          if (!label_correct) {
+            _label_correct[0] = 0;
+          }
+        },
         common::Range{0, static_cast<int64_t>(ndata), 1}, devices_)
         .Eval(&label_correct_, out_gpair, &preds, &info.labels_, &info.weights_);
 
@@ -1,43 +1,387 @@
 /*!
  * Copyright by Contributors 2017
  */
+#include <dmlc/parameter.h>
 #include <xgboost/predictor.h>
 #include <xgboost/tree_model.h>
 #include <xgboost/tree_updater.h>
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <mutex>
+
 #include "dmlc/logging.h"
+#include "../common/hist_util.h"
 #include "../common/host_device_vector.h"
+#include "../common/math.h"
 
 namespace xgboost {
 namespace predictor {
 
 DMLC_REGISTRY_FILE_TAG(cpu_predictor);
 
-class CPUPredictor : public Predictor {
- protected:
-  static bst_float PredValue(const  SparsePage::Inst& inst,
-                             const std::vector<std::unique_ptr<RegTree>>& trees,
-                             const std::vector<int>& tree_info, int bst_group,
-                             unsigned root_index, RegTree::FVec* p_feats,
-                             unsigned tree_begin, unsigned tree_end) {
-    bst_float psum = 0.0f;
-    p_feats->Fill(inst);
-    for (size_t i = tree_begin; i < tree_end; ++i) {
-      if (tree_info[i] == bst_group) {
-        int tid = trees[i]->GetLeafIndex(*p_feats, root_index);
-        psum += (*trees[i])[tid].LeafValue();
+/*! \brief prediction parameters */
+struct CPUPredictionParam : public dmlc::Parameter<CPUPredictionParam> {
+  bool quantized_prediction;
+  // declare parameters
+  DMLC_DECLARE_PARAMETER(CPUPredictionParam) {
+    DMLC_DECLARE_FIELD(quantized_prediction).set_default(false).describe(
+        "Quantize each row once into bins between the split thresholds of the "
+        "model and traverse the trees with integer comparisons.");
+  }
+};
+DMLC_REGISTER_PARAMETER(CPUPredictionParam);
+
+/*!
+ * \brief Trees of a model flattened into arrays for fast traversal.
+ *  Nodes are stored as a structure of arrays, packed breadth first per tree so
+ *  that the two children of a node are adjacent and the upper levels of a tree
+ *  share cache lines. Trees are grouped by output group, so no tree_info lookup
+ *  is needed while predicting.
+ *  Optionally the forest is quantized: the distinct split thresholds of every
+ *  feature form its bins, as the cuts of HistCutMatrix do for a model trained
+ *  with the hist method, so that an input value can be replaced by the number
+ *  of thresholds not greater than it. fvalue < threshold then holds exactly when
+ *  the bin of fvalue is not greater than the position of the threshold.
+ */
+class CompiledForest {
+ public:
+  /*!
+   * \brief flatten trees [tree_begin, tree_end) of the model
+   * \param quantize also compute the bins of the quantized forest
+   */
+  void Init(const gbm::GBTreeModel& model, unsigned tree_begin, unsigned tree_end,
+            bool quantize) {
+    const int ngroup = model.param.num_output_group;
+    split_index_.clear();
+    split_cond_.clear();
+    left_child_.clear();
+    tree_ptr_.assign(1, 0);
+    tree_depth_.clear();
+    group_ptr_.assign(1, 0);
+    trees_.clear();
+    for (int gid = 0; gid < ngroup; ++gid) {
+      for (unsigned i = tree_begin; i < tree_end; ++i) {
+        if (model.tree_info[i] == gid) {
+          this->AddTree(*model.trees[i]);
+        }
+      }
+      group_ptr_.push_back(tree_ptr_.size() - 1);
+    }
+    for (unsigned i = tree_begin; i < tree_end; ++i) {
+      trees_.push_back(model.trees[i].get());
+    }
+    model_ = &model;
+    tree_begin_ = tree_begin;
+    quantize_ = quantize;
+    bin_type_size_ = common::kUint32BinsTypeSize;
+    if (quantize) {
+      this->InitBins(model.param.num_feature);
+    }
+  }
+  /*! \brief whether Init() was called with the same arguments and trees */
+  bool Matches(const gbm::GBTreeModel& model, unsigned tree_begin, unsigned tree_end,
+               bool quantize) const {
+    if (model_ != &model || tree_begin_ != tree_begin || quantize_ != quantize ||
+        trees_.size() != tree_end - tree_begin) {
+      return false;
+    }
+    for (unsigned i = tree_begin; i < tree_end; ++i) {
+      if (trees_[i - tree_begin] != model.trees[i].get()) {
+        return false;
       }
     }
-    p_feats->Drop(inst);
+    return true;
+  }
+  /*!
+   * \brief whether the quantized forest is available. Bins are stored as uint8_t
+   *  or uint16_t, with the maximum value marking missing values; features with
+   *  more thresholds than that leave the forest unquantized.
+   */
+  bool IsQuantized() const {
+    return bin_type_size_ != common::kUint32BinsTypeSize;
+  }
+  common::BinTypeSize GetBinTypeSize() const {
+    return bin_type_size_;
+  }
+  /*! \brief bin of a feature value: the number of thresholds not greater than it */
+  template <typename BinT>
+  inline BinT Quantize(uint32_t fid, bst_float fvalue) const {
+    if (fid + 1 >= threshold_ptr_.size()) {  // never used for a split
+      return 0;
+    }
+    return static_cast<BinT>(common::CountCutsNotGreater(
+        thresholds_.data() + threshold_ptr_[fid],
+        static_cast<uint32_t>(threshold_ptr_[fid + 1] - threshold_ptr_[fid]), fvalue));
+  }
+  /*! \brief sum of the leaf values reached by feats in the trees of group gid */
+  inline bst_float PredValue(const RegTree::FVec& feats, int gid,
+                             unsigned root_index) const {
+    bst_float psum = 0.0f;
+    for (size_t t = group_ptr_[gid]; t < group_ptr_[gid + 1]; ++t) {
+      psum += split_cond_[tree_ptr_[t] + this->GetLeafIndex(t, feats, root_index)];
+    }
     return psum;
   }
+  /*!
+   * \brief add the leaf values of the trees of group gid to psum for a block of
+   *  rows. All rows advance through one level of a tree at a time, so that the
+   *  upper levels stay in cache and the inner loop has no data dependent exit.
+   * \param fvalue row-major dense feature values of the block
+   * \param missing same layout as fvalue, non-zero where the feature is missing
+   * \param num_feature number of features of a row in fvalue
+   * \param root_index root of each row
+   * \param nrows number of rows in the block
+   * \param nid scratch space of nrows entries
+   * \param psum output, one sum per row
+   */
+  inline void PredValueBlock(const bst_float* fvalue, const uint8_t* missing,
+                             size_t num_feature, const unsigned* root_index,
+                             size_t nrows, int gid, uint32_t* nid,
+                             bst_float* psum) const {
+    for (size_t t = group_ptr_[gid]; t < group_ptr_[gid + 1]; ++t) {
+      const uint32_t* split_index = split_index_.data() + tree_ptr_[t];
+      const bst_float* split_cond = split_cond_.data() + tree_ptr_[t];
+      const uint32_t* left_child = left_child_.data() + tree_ptr_[t];
+      for (size_t r = 0; r < nrows; ++r) {
+        nid[r] = root_index[r];
+      }
+      for (uint32_t depth = 0; depth < tree_depth_[t]; ++depth) {
+        for (size_t r = 0; r < nrows; ++r) {
+          // rows that already reached a leaf stay there
+          const uint32_t n = nid[r];
+          const size_t pos = r * num_feature + (split_index[n] & kFeatureMask);
+          const bool go_right = missing[pos] ? !(split_index[n] >> 31)
+                                             : !(fvalue[pos] < split_cond[n]);
+          nid[r] = left_child[n] == 0 ? n : left_child[n] + go_right;
+        }
+      }
+      for (size_t r = 0; r < nrows; ++r) {
+        psum[r] += split_cond[nid[r]];
+      }
+    }
+  }
+  /*!
+   * \brief same as PredValueBlock, for a block of rows quantized with Quantize()
+   *  where missing features hold the maximum value of BinT
+   */
+  template <typename BinT>
+  inline void PredValueBlockQuantized(const BinT* bins, size_t num_feature,
+                                      const unsigned* root_index, size_t nrows,
+                                      int gid, uint32_t* nid, bst_float* psum) const {
+    constexpr BinT kMissing = std::numeric_limits<BinT>::max();
+    for (size_t t = group_ptr_[gid]; t < group_ptr_[gid + 1]; ++t) {
+      const uint32_t* split_index = split_index_.data() + tree_ptr_[t];
+      const uint32_t* split_bin = split_bin_.data() + tree_ptr_[t];
+      const bst_float* leaf_value = split_cond_.data() + tree_ptr_[t];
+      const uint32_t* left_child = left_child_.data() + tree_ptr_[t];
+      for (size_t r = 0; r < nrows; ++r) {
+        nid[r] = root_index[r];
+      }
+      for (uint32_t depth = 0; depth < tree_depth_[t]; ++depth) {
+        for (size_t r = 0; r < nrows; ++r) {
+          const uint32_t n = nid[r];
+          const BinT bin = bins[r * num_feature + (split_index[n] & kFeatureMask)];
+          const bool go_right = (bin == kMissing) ? !(split_index[n] >> 31)
+                                                  : (bin > split_bin[n]);
+          nid[r] = left_child[n] == 0 ? n : left_child[n] + go_right;
+        }
+      }
+      for (size_t r = 0; r < nrows; ++r) {
+        psum[r] += leaf_value[nid[r]];
+      }
+    }
+  }
+
+ private:
+  void InitBins(size_t num_feature) {
+    for (size_t i = 0; i < split_index_.size(); ++i) {
+      if (left_child_[i] != 0) {
+        num_feature = std::max(num_feature,
+                               static_cast<size_t>(split_index_[i] & kFeatureMask) + 1);
+      }
+    }
+    // distinct thresholds of each feature, sorted
+    std::vector<std::vector<bst_float> > thresholds(num_feature);
+    for (size_t i = 0; i < split_index_.size(); ++i) {
+      if (left_child_[i] != 0) {
+        thresholds[split_index_[i] & kFeatureMask].push_back(split_cond_[i]);
+      }
+    }
+    threshold_ptr_.assign(1, 0);
+    thresholds_.clear();
+    size_t max_nbins = 0;
+    for (auto& feature_thresholds : thresholds) {
+      std::sort(feature_thresholds.begin(), feature_thresholds.end());
+      feature_thresholds.erase(std::unique(feature_thresholds.begin(), feature_thresholds.end()),
+                               feature_thresholds.end());
+      thresholds_.insert(thresholds_.end(), feature_thresholds.begin(),
+                         feature_thresholds.end());
+      threshold_ptr_.push_back(thresholds_.size());
+      // n thresholds give n + 1 bins
+      max_nbins = std::max(max_nbins, feature_thresholds.size() + 1);
+    }
+    bin_type_size_ = common::GetBinTypeSize(static_cast<uint32_t>(
+        std::min(max_nbins, static_cast<size_t>(std::numeric_limits<uint32_t>::max()))));
+    // position of the threshold of every split node
+    split_bin_.assign(split_index_.size(), 0);
+    for (size_t i = 0; i < split_index_.size(); ++i) {
+      if (left_child_[i] != 0) {
+        const uint32_t fid = split_index_[i] & kFeatureMask;
+        const bst_float* begin = thresholds_.data() + threshold_ptr_[fid];
+        const bst_float* end = thresholds_.data() + threshold_ptr_[fid + 1];
+        split_bin_[i] = static_cast<uint32_t>(std::lower_bound(begin, end, split_cond_[i]) -
+                                              begin);
+      }
+    }
+  }
+
+  // position of the leaf reached by feats, relative to the beginning of tree t
+  inline uint32_t GetLeafIndex(size_t t, const RegTree::FVec& feats,
+                               unsigned root_index) const {
+    const uint32_t* split_index = split_index_.data() + tree_ptr_[t];
+    const bst_float* split_cond = split_cond_.data() + tree_ptr_[t];
+    const uint32_t* left_child = left_child_.data() + tree_ptr_[t];
+    uint32_t nid = root_index;
+    while (left_child[nid] != 0) {
+      const uint32_t fid = split_index[nid] & kFeatureMask;
+      if (feats.IsMissing(fid)) {
+        nid = left_child[nid] + !(split_index[nid] >> 31);
+      } else {
+        nid = left_child[nid] + !(feats.Fvalue(fid) < split_cond[nid]);
+      }
+    }
+    return nid;
+  }
+
+  void AddTree(const RegTree& tree) {
+    const size_t base = split_index_.size();
+    // breadth first, starting from all roots; children are enqueued in pairs
+    std::vector<int> queue;
+    std::vector<uint32_t> depth;
+    for (int root = 0; root < tree.param.num_roots; ++root) {
+      queue.push_back(root);
+      depth.push_back(0);
+    }
+    uint32_t max_depth = 0;
+    for (size_t pos = 0; pos < queue.size(); ++pos) {
+      const RegTree::Node& node = tree[queue[pos]];
+      max_depth = std::max(max_depth, depth[pos]);
+      if (node.IsLeaf()) {
+        split_index_.push_back(0);
+        split_cond_.push_back(node.LeafValue());
+        left_child_.push_back(0);
+      } else {
+        // the high bit keeps the default direction, as in RegTree::Node
+        split_index_.push_back(node.SplitIndex() |
+                               (node.DefaultLeft() ? (1U << 31) : 0U));
+        split_cond_.push_back(node.SplitCond());
+        left_child_.push_back(static_cast<uint32_t>(queue.size()));
+        queue.push_back(node.LeftChild());
+        queue.push_back(node.RightChild());
+        depth.push_back(depth[pos] + 1);
+        depth.push_back(depth[pos] + 1);
+      }
+    }
+    tree_ptr_.push_back(base + queue.size());
+    tree_depth_.push_back(max_depth);
+  }
+
+  static constexpr uint32_t kFeatureMask = (1U << 31) - 1;
+
+  /*! \brief feature of split nodes, with the default-left flag in the high bit */
+  std::vector<uint32_t> split_index_;
+  /*! \brief threshold of split nodes, value of leaves */
+  std::vector<bst_float> split_cond_;
+  /*! \brief offset of the left child within its tree (right is next); 0 for leaves */
+  std::vector<uint32_t> left_child_;
+  /*! \brief node offset of each tree */
+  std::vector<size_t> tree_ptr_;
+  /*! \brief number of levels below the roots of each tree */
+  std::vector<uint32_t> tree_depth_;
+  /*! \brief quantized forest: position of the threshold of split nodes */
+  std::vector<uint32_t> split_bin_;
+  /*! \brief quantized forest: sorted distinct thresholds of each feature */
+  std::vector<size_t> threshold_ptr_;
+  std::vector<bst_float> thresholds_;
+  common::BinTypeSize bin_type_size_{common::kUint32BinsTypeSize};
+  /*! \brief range of trees of each output group */
+  std::vector<size_t> group_ptr_;
+
+  // the trees this forest was built from
+  const gbm::GBTreeModel* model_{nullptr};
+  unsigned tree_begin_{0};
+  bool quantize_{false};
+  std::vector<const RegTree*> trees_;
+};
+
+class CPUPredictor : public Predictor {
+ public:
+  CPUPredictor() {
+    param_.InitAllowUnknown(std::vector<std::pair<std::string, std::string>>{});
+  }
+
+ protected:
+  struct PredictionTemp;
+  /*!
+   * \brief scratch space borrowed from the pool of the predictor for the
+   *  duration of one call, so that concurrent calls never share buffers
+   */
+  class PooledTemp {
+   public:
+    explicit PooledTemp(CPUPredictor* owner) : owner_(owner), temp_(owner->AcquireTemp()) {}
+    ~PooledTemp() {
+      owner_->ReleaseTemp(std::move(temp_));
+    }
+    PredictionTemp* operator->() const { return temp_.get(); }
+    PredictionTemp* get() const { return temp_.get(); }
+
+   private:
+    CPUPredictor* owner_;
+    std::unique_ptr<PredictionTemp> temp_;
+  };
+  std::unique_ptr<PredictionTemp> AcquireTemp() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (temp_pool_.empty()) {
+      return std::unique_ptr<PredictionTemp>(new PredictionTemp());
+    }
+    std::unique_ptr<PredictionTemp> temp = std::move(temp_pool_.back());
+    temp_pool_.pop_back();
+    return temp;
+  }
+  void ReleaseTemp(std::unique_ptr<PredictionTemp> temp) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    temp_pool_.push_back(std::move(temp));
+  }
+
+  /*!
+   * \brief compiled forest for trees [tree_begin, tree_end), rebuilt when they
+   *  change. Callers keep their own reference, so a rebuild for another call
+   *  does not invalidate a forest in use.
+   */
+  std::shared_ptr<const CompiledForest> GetCompiledForest(const gbm::GBTreeModel& model,
+                                                          unsigned tree_begin,
+                                                          unsigned tree_end) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (forest_ == nullptr ||
+        !forest_->Matches(model, tree_begin, tree_end, param_.quantized_prediction)) {
+      std::shared_ptr<CompiledForest> forest(new CompiledForest());
+      forest->Init(model, tree_begin, tree_end, param_.quantized_prediction);
+      forest_ = forest;
+    }
+    return forest_;
+  }
 
   // init thread buffers
-  inline void InitThreadTemp(int nthread, int num_feature) {
-    int prev_thread_temp_size = thread_temp.size();
-    if (prev_thread_temp_size < nthread) {
+  inline void InitThreadTemp(int nthread, int num_feature, PredictionTemp* temp) {
+    std::vector<RegTree::FVec>& thread_temp = temp->thread_temp;
+    if (thread_temp.size() < static_cast<size_t>(nthread)) {
       thread_temp.resize(nthread, RegTree::FVec());
-      for (int i = prev_thread_temp_size; i < nthread; ++i) {
-        thread_temp[i].Init(num_feature);
+    }
+    for (auto& feats : thread_temp) {
+      if (feats.Size() != static_cast<size_t>(num_feature)) {
+        feats.Init(num_feature);
       }
     }
   }
@@ -47,14 +391,40 @@ class CPUPredictor : public Predictor {
                                 unsigned tree_begin, unsigned tree_end) {
     const MetaInfo& info = p_fmat->Info();
     const int nthread = omp_get_max_threads();
-    InitThreadTemp(nthread, model.param.num_feature);
+    PooledTemp temp(this);
+    InitThreadTemp(nthread, model.param.num_feature, temp.get());
+    std::vector<RegTree::FVec>& thread_temp = temp->thread_temp;
     std::vector<bst_float>& preds = *out_preds;
     CHECK_EQ(model.param.size_leaf_vector, 0)
         << "size_leaf_vector is enforced to 0 so far";
     CHECK_EQ(preds.size(), p_fmat->Info().num_row_ * num_group);
+    const std::shared_ptr<const CompiledForest> p_forest =
+        this->GetCompiledForest(model, tree_begin, tree_end);
+    const CompiledForest& forest = *p_forest;
+    const size_t num_feature = model.param.num_feature;
+    const bool by_blocks = num_feature != 0 &&
+        num_feature * kBlockOfRowsSize <= kMaxBlockEntries;
+    if (by_blocks) {
+      InitBlockTemp(nthread, num_feature, forest.IsQuantized(), temp.get());
+    }
     // start collecting the prediction
     for (const auto &batch : p_fmat->GetRowBatches()) {
+      if (by_blocks && forest.IsQuantized()) {
+        if (forest.GetBinTypeSize() == common::kUint8BinsTypeSize) {
+          this->PredBatchQuantized<uint8_t>(batch, info, forest, num_group, num_feature,
+                                            temp.get(), &preds);
+        } else {
+          this->PredBatchQuantized<uint16_t>(batch, info, forest, num_group, num_feature,
+                                             temp.get(), &preds);
+        }
+        continue;
+      } else if (by_blocks) {
+        this->PredBatchByBlocks(batch, info, forest, num_group, num_feature, temp.get(),
+                                &preds);
+        continue;
+      }
       // parallel over local batch
+      const SparsePageView page(batch);
       constexpr int kUnroll = 8;
       const auto nsize = static_cast<bst_omp_uint>(batch.Size());
       const bst_omp_uint rest = nsize % kUnroll;
@@ -68,31 +438,246 @@ class CPUPredictor : public Predictor {
           ridx[k] = static_cast<int64_t>(batch.base_rowid + i + k);
         }
         for (int k = 0; k < kUnroll; ++k) {
-          inst[k] = batch[i + k];
+          inst[k] = page[i + k];
         }
         for (int k = 0; k < kUnroll; ++k) {
+          feats.Fill(inst[k]);
           for (int gid = 0; gid < num_group; ++gid) {
             const size_t offset = ridx[k] * num_group + gid;
-            preds[offset] += this->PredValue(
-                inst[k], model.trees, model.tree_info, gid,
-                info.GetRoot(ridx[k]), &feats, tree_begin, tree_end);
+            preds[offset] += forest.PredValue(feats, gid, info.GetRoot(ridx[k]));
           }
+          feats.Drop(inst[k]);
         }
       }
       for (bst_omp_uint i = nsize - rest; i < nsize; ++i) {
         RegTree::FVec& feats = thread_temp[0];
         const auto ridx = static_cast<int64_t>(batch.base_rowid + i);
-         auto inst = batch[i];
+        auto inst = page[i];
+        feats.Fill(inst);
         for (int gid = 0; gid < num_group; ++gid) {
           const size_t offset = ridx * num_group + gid;
-          preds[offset] +=
-              this->PredValue(inst, model.trees, model.tree_info, gid,
-                              info.GetRoot(ridx), &feats, tree_begin, tree_end);
+          preds[offset] += forest.PredValue(feats, gid, info.GetRoot(ridx));
+        }
+        feats.Drop(inst);
+      }
+    }
+  }
+
+  // dense feature block of kBlockOfRowsSize rows, one per thread
+  struct BlockTemp {
+    std::vector<bst_float> fvalue;
+    std::vector<uint8_t> missing;
+    std::vector<unsigned> root_index;
+    std::vector<uint32_t> nid;
+    std::vector<bst_float> psum;
+    // quantized rows, as uint8_t or uint16_t
+    std::vector<uint8_t> bins;
+    // rows of a dense matrix padded to num_feature columns
+    std::vector<bst_float> dense_fvalue;
+    // missing flags, or bins, of the rows of a dense matrix
+    std::vector<uint8_t> dense_missing;
+  };
+  // scratch space of one prediction call
+  struct PredictionTemp {
+    std::vector<RegTree::FVec> thread_temp;
+    std::vector<BlockTemp> block_temp;
+  };
+  inline void InitBlockTemp(int nthread, size_t num_feature, bool quantized,
+                            PredictionTemp* p_temp) {
+    std::vector<BlockTemp>& block_temp = p_temp->block_temp;
+    if (block_temp.size() < static_cast<size_t>(nthread)) {
+      block_temp.resize(nthread);
+    }
+    for (auto& temp : block_temp) {
+      if (temp.fvalue.size() != kBlockOfRowsSize * num_feature) {
+        temp.fvalue.assign(kBlockOfRowsSize * num_feature, 0.0f);
+        temp.missing.assign(kBlockOfRowsSize * num_feature, 1);
+        temp.root_index.resize(kBlockOfRowsSize);
+        temp.nid.resize(kBlockOfRowsSize);
+        temp.psum.resize(kBlockOfRowsSize);
+        temp.bins.clear();
+      }
+      if (quantized && temp.bins.empty()) {
+        // all bytes set marks every feature as missing for both bin types
+        temp.bins.assign(kBlockOfRowsSize * num_feature * sizeof(uint16_t), 0xFF);
+      }
+    }
+  }
+  // fill a dense block with kBlockOfRowsSize rows and walk the trees level by
+  // level for all of them, see CompiledForest::PredValueBlock
+  inline void PredBatchByBlocks(const SparsePage& batch, const MetaInfo& info,
+                                const CompiledForest& forest, int num_group,
+                                size_t num_feature, PredictionTemp* p_temp,
+                                std::vector<bst_float>* out_preds) {
+    std::vector<bst_float>& preds = *out_preds;
+    const SparsePageView page(batch);
+    const size_t nsize = page.Size();
+    const auto nblocks = static_cast<bst_omp_uint>(
+        nsize / kBlockOfRowsSize + !!(nsize % kBlockOfRowsSize));
+#pragma omp parallel for schedule(static)
+    for (bst_omp_uint block = 0; block < nblocks; ++block) {
+      BlockTemp& temp = p_temp->block_temp[omp_get_thread_num()];
+      const size_t begin = block * kBlockOfRowsSize;
+      const size_t nrows = std::min(nsize - begin, kBlockOfRowsSize);
+      for (size_t r = 0; r < nrows; ++r) {
+        for (const auto& e : page[begin + r]) {
+          if (e.index >= num_feature) continue;
+          temp.fvalue[r * num_feature + e.index] = e.fvalue;
+          temp.missing[r * num_feature + e.index] = 0;
+        }
+        temp.root_index[r] = info.GetRoot(batch.base_rowid + begin + r);
+      }
+      for (int gid = 0; gid < num_group; ++gid) {
+        std::fill(temp.psum.begin(), temp.psum.end(), 0.0f);
+        forest.PredValueBlock(temp.fvalue.data(), temp.missing.data(), num_feature,
+                              temp.root_index.data(), nrows, gid, temp.nid.data(),
+                              temp.psum.data());
+        for (size_t r = 0; r < nrows; ++r) {
+          preds[(batch.base_rowid + begin + r) * num_group + gid] += temp.psum[r];
+        }
+      }
+      // only reset what was filled, the block is reused by the next rows
+      for (size_t r = 0; r < nrows; ++r) {
+        for (const auto& e : page[begin + r]) {
+          if (e.index >= num_feature) continue;
+          temp.missing[r * num_feature + e.index] = 1;
         }
       }
     }
   }
 
+  // same as PredBatchByBlocks, with rows quantized by the compiled forest
+  template <typename BinT>
+  inline void PredBatchQuantized(const SparsePage& batch, const MetaInfo& info,
+                                 const CompiledForest& forest, int num_group,
+                                 size_t num_feature, PredictionTemp* p_temp,
+                                 std::vector<bst_float>* out_preds) {
+    std::vector<bst_float>& preds = *out_preds;
+    const SparsePageView page(batch);
+    const size_t nsize = page.Size();
+    const auto nblocks = static_cast<bst_omp_uint>(
+        nsize / kBlockOfRowsSize + !!(nsize % kBlockOfRowsSize));
+#pragma omp parallel for schedule(static)
+    for (bst_omp_uint block = 0; block < nblocks; ++block) {
+      BlockTemp& temp = p_temp->block_temp[omp_get_thread_num()];
+      BinT* bins = reinterpret_cast<BinT*>(temp.bins.data());
+      const size_t begin = block * kBlockOfRowsSize;
+      const size_t nrows = std::min(nsize - begin, kBlockOfRowsSize);
+      for (size_t r = 0; r < nrows; ++r) {
+        for (const auto& e : page[begin + r]) {
+          if (e.index >= num_feature) continue;
+          bins[r * num_feature + e.index] = forest.Quantize<BinT>(e.index, e.fvalue);
+        }
+        temp.root_index[r] = info.GetRoot(batch.base_rowid + begin + r);
+      }
+      for (int gid = 0; gid < num_group; ++gid) {
+        std::fill(temp.psum.begin(), temp.psum.end(), 0.0f);
+        forest.PredValueBlockQuantized(bins, num_feature, temp.root_index.data(), nrows,
+                                       gid, temp.nid.data(), temp.psum.data());
+        for (size_t r = 0; r < nrows; ++r) {
+          preds[(batch.base_rowid + begin + r) * num_group + gid] += temp.psum[r];
+        }
+      }
+      for (size_t r = 0; r < nrows; ++r) {
+        for (const auto& e : page[begin + r]) {
+          if (e.index >= num_feature) continue;
+          bins[r * num_feature + e.index] = std::numeric_limits<BinT>::max();
+        }
+      }
+    }
+  }
+
+  // scratch of PredictDense, only grows so that repeated calls do not allocate
+  inline void InitDenseTemp(int nthread, size_t block_entries, PredictionTemp* p_temp) {
+    std::vector<BlockTemp>& block_temp = p_temp->block_temp;
+    if (block_temp.size() < static_cast<size_t>(nthread)) {
+      block_temp.resize(nthread);
+    }
+    for (auto& temp : block_temp) {
+      if (temp.root_index.size() < kBlockOfRowsSize) {
+        temp.root_index.resize(kBlockOfRowsSize);
+        temp.nid.resize(kBlockOfRowsSize);
+        temp.psum.resize(kBlockOfRowsSize);
+      }
+      if (temp.dense_fvalue.size() < block_entries) {
+        temp.dense_fvalue.resize(block_entries);
+      }
+      if (temp.dense_missing.size() < block_entries * sizeof(uint16_t)) {
+        temp.dense_missing.resize(block_entries * sizeof(uint16_t));
+      }
+    }
+  }
+  // quantize a block of dense rows, columns without values are missing
+  template <typename BinT>
+  inline void QuantizeDenseBlock(const bst_float* rows, size_t nrows, size_t ncol,
+                                 size_t num_feature, bst_float missing,
+                                 const CompiledForest& forest, BinT* bins) {
+    for (size_t r = 0; r < nrows; ++r) {
+      const bst_float* row = rows + r * ncol;
+      for (size_t c = 0; c < num_feature; ++c) {
+        const bool is_missing = c >= ncol || common::CheckNAN(row[c]) || row[c] == missing;
+        bins[r * num_feature + c] = is_missing ? std::numeric_limits<BinT>::max()
+                                               : forest.Quantize<BinT>(c, row[c]);
+      }
+    }
+  }
+  // predict a block of dense rows, output is written without base margin
+  inline void PredDenseBlock(const bst_float* rows, size_t nrows, size_t ncol,
+                             size_t num_feature, bst_float missing,
+                             const CompiledForest& forest, int num_group,
+                             BlockTemp* p_temp, bst_float* out_preds) {
+    BlockTemp& temp = *p_temp;
+    std::fill(temp.root_index.begin(), temp.root_index.begin() + nrows, 0U);
+    const bst_float* fvalue = rows;
+    size_t stride = ncol;
+    if (forest.IsQuantized()) {
+      stride = num_feature;
+      if (forest.GetBinTypeSize() == common::kUint8BinsTypeSize) {
+        this->QuantizeDenseBlock(rows, nrows, ncol, num_feature, missing, forest,
+                                 temp.dense_missing.data());
+      } else {
+        this->QuantizeDenseBlock(rows, nrows, ncol, num_feature, missing, forest,
+                                 reinterpret_cast<uint16_t*>(temp.dense_missing.data()));
+      }
+    } else {
+      if (ncol < num_feature) {
+        // trees may split on columns the matrix does not have, pad them
+        stride = num_feature;
+        for (size_t r = 0; r < nrows; ++r) {
+          std::copy(rows + r * ncol, rows + (r + 1) * ncol,
+                    temp.dense_fvalue.begin() + r * num_feature);
+        }
+        fvalue = temp.dense_fvalue.data();
+      }
+      for (size_t r = 0; r < nrows; ++r) {
+        for (size_t c = 0; c < num_feature; ++c) {
+          const bst_float v = fvalue[r * stride + c];
+          temp.dense_missing[r * stride + c] =
+              c >= ncol || common::CheckNAN(v) || v == missing;
+        }
+      }
+    }
+    for (int gid = 0; gid < num_group; ++gid) {
+      std::fill(temp.psum.begin(), temp.psum.end(), 0.0f);
+      if (!forest.IsQuantized()) {
+        forest.PredValueBlock(fvalue, temp.dense_missing.data(), stride,
+                              temp.root_index.data(), nrows, gid, temp.nid.data(),
+                              temp.psum.data());
+      } else if (forest.GetBinTypeSize() == common::kUint8BinsTypeSize) {
+        forest.PredValueBlockQuantized(temp.dense_missing.data(), stride,
+                                       temp.root_index.data(), nrows, gid,
+                                       temp.nid.data(), temp.psum.data());
+      } else {
+        forest.PredValueBlockQuantized(
+            reinterpret_cast<const uint16_t*>(temp.dense_missing.data()), stride,
+            temp.root_index.data(), nrows, gid, temp.nid.data(), temp.psum.data());
+      }
+      for (size_t r = 0; r < nrows; ++r) {
+        out_preds[r * num_group + gid] = temp.psum[r];
+      }
+    }
+  }
+
   void PredLoopInternal(DMatrix* dmat, std::vector<bst_float>* out_preds,
                         const gbm::GBTreeModel& model, int tree_begin,
                         unsigned ntree_limit) {
@@ -110,7 +695,9 @@ class CPUPredictor : public Predictor {
       auto it = cache_.find(dmat);
       if (it != cache_.end()) {
         const HostDeviceVector<bst_float>& y = it->second.predictions;
-        if (y.Size() != 0) {
+        // the cache is stale when rows were appended to the matrix
+        if (y.Size() != 0 &&
+            y.Size() == model.param.num_output_group * dmat->Info().num_row_) {
           out_preds->Resize(y.Size());
           std::copy(y.HostVector().begin(), y.HostVector().end(),
                     out_preds->HostVector().begin());
@@ -152,6 +739,12 @@ class CPUPredictor : public Predictor {
   }
 
  public:
+  void Init(const std::vector<std::pair<std::string, std::string>>& cfg,
+            const std::vector<std::shared_ptr<DMatrix>>& cache) override {
+    Predictor::Init(cfg, cache);
+    param_.InitAllowUnknown(cfg);
+  }
+
   void PredictBatch(DMatrix* dmat, HostDeviceVector<bst_float>* out_preds,
                     const gbm::GBTreeModel& model, int tree_begin,
                     unsigned ntree_limit = 0) override {
@@ -175,11 +768,18 @@ class CPUPredictor : public Predictor {
       std::vector<std::unique_ptr<TreeUpdater>>* updaters,
       int num_new_trees) override {
     int old_ntree = model.trees.size() - num_new_trees;
+    // trees may have been modified in place by the updaters
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      forest_.reset();
+    }
     // update cache entry
     for (auto& kv : cache_) {
       PredictionCacheEntry& e = kv.second;
 
-      if (e.predictions.Size() == 0) {
+      if (e.predictions.Size() !=
+          model.param.num_output_group * e.data->Info().num_row_) {
+        // new matrix, or rows appended since the cache was filled
         InitOutPredictions(e.data->Info(), &(e.predictions), model);
         PredLoopInternal(e.data.get(), &(e.predictions.HostVector()), model, 0,
                          model.trees.size());
@@ -199,28 +799,66 @@ class CPUPredictor : public Predictor {
                        std::vector<bst_float>* out_preds,
                        const gbm::GBTreeModel& model, unsigned ntree_limit,
                        unsigned root_index) override {
-    if (thread_temp.size() == 0) {
-      thread_temp.resize(1, RegTree::FVec());
-      thread_temp[0].Init(model.param.num_feature);
-    }
+    PooledTemp temp(this);
+    InitThreadTemp(1, model.param.num_feature, temp.get());
+    RegTree::FVec& feats = temp->thread_temp[0];
     ntree_limit *= model.param.num_output_group;
     if (ntree_limit == 0 || ntree_limit > model.trees.size()) {
       ntree_limit = static_cast<unsigned>(model.trees.size());
     }
     out_preds->resize(model.param.num_output_group *
                       (model.param.size_leaf_vector + 1));
+    const std::shared_ptr<const CompiledForest> forest =
+        this->GetCompiledForest(model, 0, ntree_limit);
     // loop over output groups
+    feats.Fill(inst);
     for (int gid = 0; gid < model.param.num_output_group; ++gid) {
-      (*out_preds)[gid] =
-          PredValue(inst, model.trees, model.tree_info, gid, root_index,
-                    &thread_temp[0], 0, ntree_limit) +
+      (*out_preds)[gid] = forest->PredValue(feats, gid, root_index) +
           model.base_margin;
     }
+    feats.Drop(inst);
+  }
+  void PredictDense(const bst_float* data, size_t nrow, size_t ncol,
+                    bst_float missing, bst_float* out_preds,
+                    const gbm::GBTreeModel& model, unsigned ntree_limit) override {
+    CHECK_EQ(model.param.size_leaf_vector, 0)
+        << "size_leaf_vector is enforced to 0 so far";
+    const int num_group = model.param.num_output_group;
+    ntree_limit *= num_group;
+    if (ntree_limit == 0 || ntree_limit > model.trees.size()) {
+      ntree_limit = static_cast<unsigned>(model.trees.size());
+    }
+    const std::shared_ptr<const CompiledForest> forest =
+        this->GetCompiledForest(model, 0, ntree_limit);
+    const size_t num_feature = model.param.num_feature;
+    // rows are read in place unless they are too short or quantized
+    const size_t stride = std::max<size_t>(std::max(ncol, num_feature), 1);
+    const size_t block_rows = std::max<size_t>(
+        std::min(kBlockOfRowsSize, kMaxBlockEntries / stride), 1);
+    const int nthread = omp_get_max_threads();
+    PooledTemp temp(this);
+    this->InitDenseTemp(nthread, block_rows * stride, temp.get());
+    const auto nblocks = static_cast<bst_omp_uint>(
+        nrow / block_rows + !!(nrow % block_rows));
+#pragma omp parallel for schedule(static)
+    for (bst_omp_uint block = 0; block < nblocks; ++block) {
+      const size_t begin = block * block_rows;
+      const size_t nrows = std::min(nrow - begin, block_rows);
+      bst_float* out = out_preds + begin * num_group;
+      this->PredDenseBlock(data + begin * ncol, nrows, ncol, num_feature, missing,
+                           *forest, num_group, &temp->block_temp[omp_get_thread_num()], out);
+      for (size_t i = 0; i < nrows * num_group; ++i) {
+        out[i] += model.base_margin;
+      }
+    }
   }
+
   void PredictLeaf(DMatrix* p_fmat, std::vector<bst_float>* out_preds,
                    const gbm::GBTreeModel& model, unsigned ntree_limit) override {
     const int nthread = omp_get_max_threads();
-    InitThreadTemp(nthread, model.param.num_feature);
+    PooledTemp temp(this);
+    InitThreadTemp(nthread, model.param.num_feature, temp.get());
+    std::vector<RegTree::FVec>& thread_temp = temp->thread_temp;
     const MetaInfo& info = p_fmat->Info();
     // number of valid trees
     ntree_limit *= model.param.num_output_group;
@@ -232,18 +870,19 @@ class CPUPredictor : public Predictor {
     // start collecting the prediction
     for (const auto &batch : p_fmat->GetRowBatches()) {
       // parallel over local batch
-      const auto nsize = static_cast<bst_omp_uint>(batch.Size());
+      const SparsePageView page(batch);
+      const auto nsize = static_cast<bst_omp_uint>(page.Size());
 #pragma omp parallel for schedule(static)
       for (bst_omp_uint i = 0; i < nsize; ++i) {
         const int tid = omp_get_thread_num();
         auto ridx = static_cast<size_t>(batch.base_rowid + i);
         RegTree::FVec& feats = thread_temp[tid];
-        feats.Fill(batch[i]);
+        feats.Fill(page[i]);
         for (unsigned j = 0; j < ntree_limit; ++j) {
           int tid = model.trees[j]->GetLeafIndex(feats, info.GetRoot(ridx));
           preds[ridx * ntree_limit + j] = static_cast<bst_float>(tid);
         }
-        feats.Drop(batch[i]);
+        feats.Drop(page[i]);
       }
     }
   }
@@ -254,7 +893,9 @@ class CPUPredictor : public Predictor {
                            int condition,
                            unsigned condition_feature) override {
     const int nthread = omp_get_max_threads();
-    InitThreadTemp(nthread,  model.param.num_feature);
+    PooledTemp temp(this);
+    InitThreadTemp(nthread,  model.param.num_feature, temp.get());
+    std::vector<RegTree::FVec>& thread_temp = temp->thread_temp;
     const MetaInfo& info = p_fmat->Info();
     // number of valid trees
     ntree_limit *= model.param.num_output_group;
@@ -269,16 +910,21 @@ class CPUPredictor : public Predictor {
     // make sure contributions is zeroed, we could be reusing a previously
     // allocated one
     std::fill(contribs.begin(), contribs.end(), 0);
-    // initialize tree node mean values
-    #pragma omp parallel for schedule(static)
-    for (bst_omp_uint i = 0; i < ntree_limit; ++i) {
-      model.trees[i]->FillNodeMeanValues();
+    // initialize tree node mean values, the trees are shared by concurrent
+    // calls, which wait here until the first one has filled them
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      #pragma omp parallel for schedule(static)
+      for (bst_omp_uint i = 0; i < ntree_limit; ++i) {
+        model.trees[i]->FillNodeMeanValues();
+      }
     }
     const std::vector<bst_float>& base_margin = info.base_margin_.HostVector();
     // start collecting the contributions
     for (const auto &batch : p_fmat->GetRowBatches()) {
       // parallel over local batch
-      const auto nsize = static_cast<bst_omp_uint>(batch.Size());
+      const SparsePageView page(batch);
+      const auto nsize = static_cast<bst_omp_uint>(page.Size());
 #pragma omp parallel for schedule(static)
       for (bst_omp_uint i = 0; i < nsize; ++i) {
         auto row_idx = static_cast<size_t>(batch.base_rowid + i);
@@ -288,7 +934,7 @@ class CPUPredictor : public Predictor {
         for (int gid = 0; gid < ngroup; ++gid) {
           bst_float* p_contribs =
               &contribs[(row_idx * ngroup + gid) * ncolumns];
-          feats.Fill(batch[i]);
+          feats.Fill(page[i]);
           // calculate contributions
           for (unsigned j = 0; j < ntree_limit; ++j) {
             if (model.tree_info[j] != gid) {
@@ -301,7 +947,7 @@ class CPUPredictor : public Predictor {
               model.trees[j]->CalculateContributionsApprox(feats, root_id, p_contribs);
             }
           }
-          feats.Drop(batch[i]);
+          feats.Drop(page[i]);
           // add base margin to BIAS
           if (base_margin.size() != 0) {
             p_contribs[ncolumns - 1] += base_margin[row_idx * ngroup + gid];
@@ -356,9 +1002,22 @@ class CPUPredictor : public Predictor {
       }
     }
   }
-  std::vector<RegTree::FVec> thread_temp;
+  // rows predicted together by PredBatchByBlocks
+  static constexpr size_t kBlockOfRowsSize = 64;
+  // beyond this many features per block, rows are predicted one at a time
+  static constexpr size_t kMaxBlockEntries = 1 << 18;
+
+  CPUPredictionParam param_;
+  // guards forest_, temp_pool_ and filling the node means of the trees,
+  // predictions run concurrently otherwise
+  std::mutex mutex_;
+  std::shared_ptr<const CompiledForest> forest_;
+  std::vector<std::unique_ptr<PredictionTemp>> temp_pool_;
 };
 
+constexpr size_t CPUPredictor::kBlockOfRowsSize;
+constexpr size_t CPUPredictor::kMaxBlockEntries;
+
 XGBOOST_REGISTER_PREDICTOR(CPUPredictor, "cpu_predictor")
     .describe("Make predictions using CPU.")
     .set_body([]() { return new CPUPredictor(); });
@@ -15,6 +15,11 @@ void Predictor::Init(
     cache_[d.get()].data = d;
   }
 }
+void Predictor::PredictDense(const bst_float* data, size_t nrow, size_t ncol,
+                             bst_float missing, bst_float* out_preds,
+                             const gbm::GBTreeModel& model, unsigned ntree_limit) {
+  LOG(FATAL) << "Dense prediction is only supported by cpu_predictor";
+}
 Predictor* Predictor::Create(std::string name) {
   auto* e = ::dmlc::Registry<PredictorReg>::Get()->Find(name);
   if (e == nullptr) {
@@ -94,6 +94,11 @@ struct TrainParam : public dmlc::Parameter<TrainParam> {
   // for that feature; to save time, only up to (max_search_group) of existing groups
   // will be considered. If set to zero, ALL existing groups will be examined
   unsigned max_search_group;
+  // floating point type used to accumulate gradient histograms
+  enum HistPrecision { kHistDouble = 0, kHistFloat = 1 };
+  int hist_precision;
+  // number of rows sampled to sketch the histogram cuts, 0 to use all rows
+  int sketch_sample_rows;
 
   // declare the parameters
   DMLC_DECLARE_PARAMETER(TrainParam) {
@@ -219,6 +224,16 @@ struct TrainParam : public dmlc::Parameter<TrainParam> {
                   "groups before creating a new group for that feature; to save time, "
                   "only up to (max_search_group) of existing groups will be "
                   "considered. If set to zero, ALL existing groups will be examined.");
+    DMLC_DECLARE_FIELD(hist_precision)
+        .set_default(kHistDouble)
+        .add_enum("double", kHistDouble)
+        .add_enum("float", kHistFloat)
+        .describe("Floating point type used to accumulate gradient histograms "
+                  "in the hist tree method. float halves histogram memory and "
+                  "bandwidth at the cost of some accuracy.");
+    DMLC_DECLARE_FIELD(sketch_sample_rows).set_lower_bound(0).set_default(0)
+        .describe("if >0, sketch the histogram cuts of the hist tree method on a "
+                  "random sample of about this many rows instead of all rows.");
 
     // add alias of parameters
     DMLC_DECLARE_ALIAS(reg_lambda, lambda);
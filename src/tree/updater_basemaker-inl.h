@@ -46,8 +46,9 @@ class BaseMaker: public TreeUpdater {
                 -std::numeric_limits<bst_float>::max());
       // start accumulating statistics
       for (const auto &batch : p_fmat->GetSortedColumnBatches()) {
-        for (bst_uint fid = 0; fid < batch.Size(); ++fid) {
-          auto c = batch[fid];
+        const SparsePageView page(batch);
+        for (bst_uint fid = 0; fid < page.Size(); ++fid) {
+          auto c = page[fid];
           if (c.size() != 0) {
             CHECK_LT(fid * 2, fminmax_.size());
             fminmax_[fid * 2 + 0] =
@@ -244,8 +245,9 @@ class BaseMaker: public TreeUpdater {
   inline void CorrectNonDefaultPositionByBatch(
       const SparsePage &batch, const std::vector<bst_uint> &sorted_split_set,
       const RegTree &tree) {
-    for (size_t fid = 0; fid < batch.Size(); ++fid) {
-      auto col = batch[fid];
+    const SparsePageView page(batch);
+    for (size_t fid = 0; fid < page.Size(); ++fid) {
+      auto col = page[fid];
       auto it = std::lower_bound(sorted_split_set.begin(), sorted_split_set.end(), fid);
 
       if (it != sorted_split_set.end() && *it == fid) {
@@ -592,6 +592,7 @@ class ColMaker: public TreeUpdater {
                                 const std::vector<GradientPair> &gpair,
                                 DMatrix*p_fmat) {
       const MetaInfo& info = p_fmat->Info();
+      const SparsePageView page(batch);
       // start enumeration
       const auto num_features = static_cast<bst_omp_uint>(feat_set.size());
 #if defined(_OPENMP)
@@ -607,7 +608,7 @@ class ColMaker: public TreeUpdater {
         for (bst_omp_uint i = 0; i < num_features; ++i) {
           int fid = feat_set[i];
           const int tid = omp_get_thread_num();
-          auto c = batch[fid];
+          auto c = page[fid];
           const bool ind = c.size() != 0 && c[0].fvalue == c[c.size() - 1].fvalue;
           if (param_.NeedForwardSearch(p_fmat->GetColDensity(fid), ind)) {
             this->EnumerateSplit(c.data(), c.data() + c.size(), +1,
@@ -620,7 +621,7 @@ class ColMaker: public TreeUpdater {
         }
       } else {
         for (bst_omp_uint fid = 0; fid < num_features; ++fid) {
-          this->ParallelFindSplit(batch[fid], fid,
+          this->ParallelFindSplit(page[fid], fid,
                                   p_fmat, gpair);
         }
       }
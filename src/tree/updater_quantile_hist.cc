@@ -15,6 +15,7 @@
 #include <algorithm>
 #include <queue>
 #include <iomanip>
+#include <mutex>
 #include <numeric>
 #include <string>
 #include <utility>
@@ -39,7 +40,8 @@ void QuantileHistMaker::Init(const std::vector<std::pair<std::string, std::strin
   }
   pruner_->Init(args);
   param_.InitAllowUnknown(args);
-  is_gmat_initialized_ = false;
+  quantized_.reset();
+  quantized_source_.reset();
 
   // initialise the split evaluator
   if (!spliteval_) {
@@ -52,28 +54,66 @@ void QuantileHistMaker::Init(const std::vector<std::pair<std::string, std::strin
 void QuantileHistMaker::Update(HostDeviceVector<GradientPair> *gpair,
                                DMatrix *dmat,
                                const std::vector<RegTree *> &trees) {
-  if (is_gmat_initialized_ == false) {
-    double tstart = dmlc::GetTime();
-    gmat_.Init(dmat, static_cast<uint32_t>(param_.max_bin));
-    column_matrix_.Init(gmat_, param_.sparse_threshold);
+  std::shared_ptr<const QuantizedMatrix> quantized = this->GetQuantized(dmat);
+  if (quantized != quantized_) {
+    quantized_ = quantized;
     if (param_.enable_feature_grouping > 0) {
-      gmatb_.Init(gmat_, column_matrix_, param_);
+      gmatb_.Init(quantized_->gmat, quantized_->column_matrix, param_);
     }
-    is_gmat_initialized_ = true;
+  }
+  if (param_.hist_precision == TrainParam::kHistFloat) {
+    UpdateWith(&float_builder_, gpair, dmat, trees);
+  } else {
+    UpdateWith(&double_builder_, gpair, dmat, trees);
+  }
+}
+
+std::shared_ptr<const QuantizedMatrix> QuantileHistMaker::GetQuantized(DMatrix* dmat) {
+  // boosters training on the same matrix in other threads share the instance
+  std::lock_guard<std::mutex> guard(dmat->QuantizedMutex());
+  std::shared_ptr<QuantizedMatrix>& shared = dmat->Quantized();
+  const size_t num_row = dmat->Info().num_row_;
+  double tstart = dmlc::GetTime();
+  if (shared == nullptr || shared->max_bin != param_.max_bin ||
+      shared->sketch_sample_rows != param_.sketch_sample_rows ||
+      shared->gmat.row_ptr.size() > num_row + 1 || !shared->SketchedWith(dmat->Info())) {
+    shared = QuantizedMatrix::Create(dmat, param_.max_bin, param_.sparse_threshold,
+                                     param_.sketch_sample_rows);
     LOG(INFO) << "Generating gmat: " << dmlc::GetTime() - tstart << " sec";
+  } else if (shared->gmat.row_ptr.size() != num_row + 1) {
+    // rows were appended, bin them with the existing cuts
+    shared = shared->Derive(dmat, shared->sparse_threshold);
+    LOG(INFO) << "Appending to gmat: " << dmlc::GetTime() - tstart << " sec";
   }
+  if (shared->sparse_threshold == param_.sparse_threshold) {
+    return shared;
+  }
+  // the shared bins in the column layout of this updater
+  if (quantized_source_ != shared || quantized_ == nullptr) {
+    quantized_source_ = shared;
+    return shared->Derive(dmat, param_.sparse_threshold);
+  }
+  return quantized_;
+}
+
+template <typename GradientSumT>
+void QuantileHistMaker::UpdateWith(std::unique_ptr<Builder<GradientSumT> >* p_builder,
+                                   HostDeviceVector<GradientPair>* gpair,
+                                   DMatrix* dmat,
+                                   const std::vector<RegTree*>& trees) {
+  std::unique_ptr<Builder<GradientSumT> >& builder = *p_builder;
   // rescale learning rate according to size of trees
   float lr = param_.learning_rate;
   param_.learning_rate = lr / trees.size();
   // build tree
-  if (!builder_) {
-    builder_.reset(new Builder(
+  if (!builder) {
+    builder.reset(new Builder<GradientSumT>(
         param_,
         std::move(pruner_),
         std::unique_ptr<SplitEvaluator>(spliteval_->GetHostClone())));
   }
   for (auto tree : trees) {
-    builder_->Update(gmat_, gmatb_, column_matrix_, gpair, dmat, tree);
+    builder->Update(quantized_->gmat, gmatb_, quantized_->column_matrix, gpair, dmat, tree);
   }
   param_.learning_rate = lr;
 }
@@ -81,14 +121,17 @@ void QuantileHistMaker::Update(HostDeviceVector<GradientPair> *gpair,
 bool QuantileHistMaker::UpdatePredictionCache(
     const DMatrix* data,
     HostDeviceVector<bst_float>* out_preds) {
-  if (!builder_ || param_.subsample < 1.0f) {
+  if (param_.subsample < 1.0f) {
     return false;
+  } else if (param_.hist_precision == TrainParam::kHistFloat) {
+    return float_builder_ && float_builder_->UpdatePredictionCache(data, out_preds);
   } else {
-    return builder_->UpdatePredictionCache(data, out_preds);
+    return double_builder_ && double_builder_->UpdatePredictionCache(data, out_preds);
   }
 }
 
-void QuantileHistMaker::Builder::SyncHistograms(
+template <typename GradientSumT>
+void QuantileHistMaker::Builder<GradientSumT>::SyncHistograms(
     int starting_index,
     int sync_count,
     RegTree *p_tree) {
@@ -103,7 +146,8 @@ void QuantileHistMaker::Builder::SyncHistograms(
   builder_monitor_.Stop("SyncHistograms");
 }
 
-void QuantileHistMaker::Builder::BuildLocalHistograms(
+template <typename GradientSumT>
+void QuantileHistMaker::Builder<GradientSumT>::BuildLocalHistograms(
     int *starting_index,
     int *sync_count,
     const GHistIndexMatrix &gmat,
@@ -111,49 +155,62 @@ void QuantileHistMaker::Builder::BuildLocalHistograms(
     RegTree *p_tree,
     const std::vector<GradientPair> &gpair_h) {
   builder_monitor_.Start("BuildLocalHistograms");
+  std::vector<int> nodes_to_build;
   for (auto const& entry : qexpand_depth_wise_) {
     int nid = entry.nid;
     RegTree::Node &node = (*p_tree)[nid];
     if (rabit::IsDistributed()) {
       if (node.IsRoot() || node.IsLeftChild()) {
-        hist_.AddHistRow(nid);
         // in distributed setting, we always calculate from left child or root node
-        BuildHist(gpair_h, row_set_collection_[nid], gmat, gmatb, hist_[nid], false);
+        nodes_to_build.push_back(nid);
         if (!node.IsRoot()) {
           nodes_for_subtraction_trick_[(*p_tree)[node.Parent()].RightChild()] = nid;
         }
-        (*sync_count)++;
-        (*starting_index) = std::min((*starting_index), nid);
       }
     } else {
       if (!node.IsRoot() && node.IsLeftChild() &&
           (row_set_collection_[nid].Size() <
            row_set_collection_[(*p_tree)[node.Parent()].RightChild()].Size())) {
-        hist_.AddHistRow(nid);
-        BuildHist(gpair_h, row_set_collection_[nid], gmat, gmatb, hist_[nid], false);
+        nodes_to_build.push_back(nid);
         nodes_for_subtraction_trick_[(*p_tree)[node.Parent()].RightChild()] = nid;
-        (*sync_count)++;
-        (*starting_index) = std::min((*starting_index), nid);
       } else if (!node.IsRoot() && !node.IsLeftChild() &&
                  (row_set_collection_[nid].Size() <=
                   row_set_collection_[(*p_tree)[node.Parent()].LeftChild()].Size())) {
-        hist_.AddHistRow(nid);
-        BuildHist(gpair_h, row_set_collection_[nid], gmat, gmatb, hist_[nid], false);
+        nodes_to_build.push_back(nid);
         nodes_for_subtraction_trick_[(*p_tree)[node.Parent()].LeftChild()] = nid;
-        (*sync_count)++;
-        (*starting_index) = std::min((*starting_index), nid);
       } else if (node.IsRoot()) {
-        hist_.AddHistRow(nid);
-        BuildHist(gpair_h, row_set_collection_[nid], gmat, gmatb, hist_[nid], false);
-        (*sync_count)++;
-        (*starting_index) = std::min((*starting_index), nid);
+        nodes_to_build.push_back(nid);
       }
     }
   }
+
+  // allocate all rows first, as adding a row may move the others
+  for (int nid : nodes_to_build) {
+    hist_.AddHistRow(nid);
+    (*sync_count)++;
+    (*starting_index) = std::min((*starting_index), nid);
+  }
+  if (param_.enable_feature_grouping > 0) {
+    for (int nid : nodes_to_build) {
+      BuildHist(gpair_h, row_set_collection_[nid], gmat, gmatb, hist_[nid], false);
+    }
+  } else if (!nodes_to_build.empty()) {
+    // all nodes of the level are built in a single parallel pass
+    std::vector<RowSetCollection::Elem> row_indices;
+    std::vector<GHistRowT> hists;
+    for (int nid : nodes_to_build) {
+      row_indices.push_back(row_set_collection_[nid]);
+      hists.push_back(hist_[nid]);
+    }
+    builder_monitor_.Start("BuildHist");
+    hist_builder_.BuildHists(gpair_h, row_indices, gmat, hists);
+    builder_monitor_.Stop("BuildHist");
+  }
   builder_monitor_.Stop("BuildLocalHistograms");
 }
 
-void QuantileHistMaker::Builder::BuildNodeStats(
+template <typename GradientSumT>
+void QuantileHistMaker::Builder<GradientSumT>::BuildNodeStats(
     const GHistIndexMatrix &gmat,
     DMatrix *p_fmat,
     RegTree *p_tree,
@@ -175,7 +232,8 @@ void QuantileHistMaker::Builder::BuildNodeStats(
   builder_monitor_.Stop("BuildNodeStats");
 }
 
-void QuantileHistMaker::Builder::EvaluateSplits(
+template <typename GradientSumT>
+void QuantileHistMaker::Builder<GradientSumT>::EvaluateSplits(
     const GHistIndexMatrix &gmat,
     const ColumnMatrix &column_matrix,
     DMatrix *p_fmat,
@@ -205,7 +263,8 @@ void QuantileHistMaker::Builder::EvaluateSplits(
   }
 }
 
-void QuantileHistMaker::Builder::ExpandWithDepthWidth(
+template <typename GradientSumT>
+void QuantileHistMaker::Builder<GradientSumT>::ExpandWithDepthWidth(
   const GHistIndexMatrix &gmat,
   const GHistIndexBlockMatrix &gmatb,
   const ColumnMatrix &column_matrix,
@@ -239,7 +298,8 @@ void QuantileHistMaker::Builder::ExpandWithDepthWidth(
   }
 }
 
-void QuantileHistMaker::Builder::ExpandWithLossGuide(
+template <typename GradientSumT>
+void QuantileHistMaker::Builder<GradientSumT>::ExpandWithLossGuide(
     const GHistIndexMatrix& gmat,
     const GHistIndexBlockMatrix& gmatb,
     const ColumnMatrix& column_matrix,
@@ -314,12 +374,13 @@ void QuantileHistMaker::Builder::ExpandWithLossGuide(
   }
 }
 
-void QuantileHistMaker::Builder::Update(const GHistIndexMatrix& gmat,
-                                        const GHistIndexBlockMatrix& gmatb,
-                                        const ColumnMatrix& column_matrix,
-                                        HostDeviceVector<GradientPair>* gpair,
-                                        DMatrix* p_fmat,
-                                        RegTree* p_tree) {
+template <typename GradientSumT>
+void QuantileHistMaker::Builder<GradientSumT>::Update(const GHistIndexMatrix& gmat,
+                                                      const GHistIndexBlockMatrix& gmatb,
+                                                      const ColumnMatrix& column_matrix,
+                                                      HostDeviceVector<GradientPair>* gpair,
+                                                      DMatrix* p_fmat,
+                                                      RegTree* p_tree) {
   builder_monitor_.Start("Update");
 
   const std::vector<GradientPair>& gpair_h = gpair->ConstHostVector();
@@ -345,7 +406,8 @@ void QuantileHistMaker::Builder::Update(const GHistIndexMatrix& gmat,
   builder_monitor_.Stop("Update");
 }
 
-bool QuantileHistMaker::Builder::UpdatePredictionCache(
+template <typename GradientSumT>
+bool QuantileHistMaker::Builder<GradientSumT>::UpdatePredictionCache(
     const DMatrix* data,
     HostDeviceVector<bst_float>* p_out_preds) {
   std::vector<bst_float>& out_preds = p_out_preds->HostVector();
@@ -386,10 +448,11 @@ bool QuantileHistMaker::Builder::UpdatePredictionCache(
   return true;
 }
 
-void QuantileHistMaker::Builder::InitData(const GHistIndexMatrix& gmat,
-                                          const std::vector<GradientPair>& gpair,
-                                          const DMatrix& fmat,
-                                          const RegTree& tree) {
+template <typename GradientSumT>
+void QuantileHistMaker::Builder<GradientSumT>::InitData(const GHistIndexMatrix& gmat,
+                                                        const std::vector<GradientPair>& gpair,
+                                                        const DMatrix& fmat,
+                                                        const RegTree& tree) {
   CHECK_EQ(tree.param.num_nodes, tree.param.num_roots)
       << "ColMakerHist: can only grow new tree";
   CHECK((param_.max_depth > 0 || param_.max_leaves > 0))
@@ -552,11 +615,12 @@ void QuantileHistMaker::Builder::InitData(const GHistIndexMatrix& gmat,
   builder_monitor_.Stop("InitData");
 }
 
-void QuantileHistMaker::Builder::EvaluateSplit(const int nid,
-                                               const GHistIndexMatrix& gmat,
-                                               const HistCollection& hist,
-                                               const DMatrix& fmat,
-                                               const RegTree& tree) {
+template <typename GradientSumT>
+void QuantileHistMaker::Builder<GradientSumT>::EvaluateSplit(const int nid,
+                                                             const GHistIndexMatrix& gmat,
+                                                             const HistCollectionT& hist,
+                                                             const DMatrix& fmat,
+                                                             const RegTree& tree) {
   builder_monitor_.Start("EvaluateSplit");
   // start enumeration
   const MetaInfo& info = fmat.Info();
@@ -569,7 +633,7 @@ void QuantileHistMaker::Builder::EvaluateSplit(const int nid,
   for (bst_omp_uint tid = 0; tid < nthread; ++tid) {
     best_split_tloc_[tid] = snode_[nid].best;
   }
-  GHistRow node_hist = hist[nid];
+  GHistRowT node_hist = hist[nid];
 
 #pragma omp parallel for schedule(dynamic) num_threads(nthread)
   for (bst_omp_uint i = 0; i < nfeature; ++i) {  // NOLINT(*)
@@ -591,12 +655,13 @@ void QuantileHistMaker::Builder::EvaluateSplit(const int nid,
   builder_monitor_.Stop("EvaluateSplit");
 }
 
-void QuantileHistMaker::Builder::ApplySplit(int nid,
-                                            const GHistIndexMatrix& gmat,
-                                            const ColumnMatrix& column_matrix,
-                                            const HistCollection& hist,
-                                            const DMatrix& fmat,
-                                            RegTree* p_tree) {
+template <typename GradientSumT>
+void QuantileHistMaker::Builder<GradientSumT>::ApplySplit(int nid,
+                                                          const GHistIndexMatrix& gmat,
+                                                          const ColumnMatrix& column_matrix,
+                                                          const HistCollectionT& hist,
+                                                          const DMatrix& fmat,
+                                                          RegTree* p_tree) {
   builder_monitor_.Start("ApplySplit");
   // TODO(hcho3): support feature sampling by levels
 
@@ -633,9 +698,38 @@ void QuantileHistMaker::Builder::ApplySplit(int nid,
     }
   }
 
+  switch (column_matrix.GetTypeSize()) {
+    case common::kUint8BinsTypeSize:
+      ApplySplitColumn<uint8_t>(nid, gmat, column_matrix, fid, lower_bound, upper_bound,
+                                split_cond, default_left);
+      break;
+    case common::kUint16BinsTypeSize:
+      ApplySplitColumn<uint16_t>(nid, gmat, column_matrix, fid, lower_bound, upper_bound,
+                                 split_cond, default_left);
+      break;
+    default:
+      ApplySplitColumn<uint32_t>(nid, gmat, column_matrix, fid, lower_bound, upper_bound,
+                                 split_cond, default_left);
+  }
+
+  row_set_collection_.AddSplit(
+      nid, row_split_tloc_, (*p_tree)[nid].LeftChild(), (*p_tree)[nid].RightChild());
+  builder_monitor_.Stop("ApplySplit");
+}
+
+template <typename GradientSumT>
+template <typename BinIdxType>
+void QuantileHistMaker::Builder<GradientSumT>::ApplySplitColumn(int nid,
+                                                                const GHistIndexMatrix& gmat,
+                                                                const ColumnMatrix& column_matrix,
+                                                                bst_uint fid,
+                                                                bst_uint lower_bound,
+                                                                bst_uint upper_bound,
+                                                                bst_int split_cond,
+                                                                bool default_left) {
   const auto& rowset = row_set_collection_[nid];
 
-  Column column = column_matrix.GetColumn(fid);
+  Column<BinIdxType> column = column_matrix.GetColumn<BinIdxType>(fid);
   if (column.GetType() == xgboost::common::kDenseColumn) {
     ApplySplitDenseData(rowset, gmat, &row_split_tloc_, column, split_cond,
                         default_left);
@@ -643,17 +737,15 @@ void QuantileHistMaker::Builder::ApplySplit(int nid,
     ApplySplitSparseData(rowset, gmat, &row_split_tloc_, column, lower_bound,
                          upper_bound, split_cond, default_left);
   }
-
-  row_set_collection_.AddSplit(
-      nid, row_split_tloc_, (*p_tree)[nid].LeftChild(), (*p_tree)[nid].RightChild());
-  builder_monitor_.Stop("ApplySplit");
 }
 
-void QuantileHistMaker::Builder::ApplySplitDenseData(
+template <typename GradientSumT>
+template <typename BinIdxType>
+void QuantileHistMaker::Builder<GradientSumT>::ApplySplitDenseData(
     const RowSetCollection::Elem rowset,
     const GHistIndexMatrix& gmat,
     std::vector<RowSetCollection::Split>* p_row_split_tloc,
-    const Column& column,
+    const Column<BinIdxType>& column,
     bst_int split_cond,
     bool default_left) {
   std::vector<RowSetCollection::Split>& row_split_tloc = *p_row_split_tloc;
@@ -667,15 +759,15 @@ void QuantileHistMaker::Builder::ApplySplitDenseData(
     auto& left = row_split_tloc[tid].left;
     auto& right = row_split_tloc[tid].right;
     size_t rid[kUnroll];
-    uint32_t rbin[kUnroll];
+    BinIdxType rbin[kUnroll];
     for (int k = 0; k < kUnroll; ++k) {
       rid[k] = rowset.begin[i + k];
     }
     for (int k = 0; k < kUnroll; ++k) {
       rbin[k] = column.GetFeatureBinIdx(rid[k]);
     }
-    for (int k = 0; k < kUnroll; ++k) {                      // NOLINT
-      if (rbin[k] == std::numeric_limits<uint32_t>::max()) {  // missing value
+    for (int k = 0; k < kUnroll; ++k) {                        // NOLINT
+      if (rbin[k] == std::numeric_limits<BinIdxType>::max()) {  // missing value
         if (default_left) {
           left.push_back(rid[k]);
         } else {
@@ -695,7 +787,7 @@ void QuantileHistMaker::Builder::ApplySplitDenseData(
     auto& right = row_split_tloc[nthread_-1].right;
     const size_t rid = rowset.begin[i];
     const uint32_t rbin = column.GetFeatureBinIdx(rid);
-    if (rbin == std::numeric_limits<uint32_t>::max()) {  // missing value
+    if (column.IsMissing(rid)) {  // missing value
       if (default_left) {
         left.push_back(rid);
       } else {
@@ -711,11 +803,13 @@ void QuantileHistMaker::Builder::ApplySplitDenseData(
   }
 }
 
-void QuantileHistMaker::Builder::ApplySplitSparseData(
+template <typename GradientSumT>
+template <typename BinIdxType>
+void QuantileHistMaker::Builder<GradientSumT>::ApplySplitSparseData(
     const RowSetCollection::Elem rowset,
     const GHistIndexMatrix& gmat,
     std::vector<RowSetCollection::Split>* p_row_split_tloc,
-    const Column& column,
+    const Column<BinIdxType>& column,
     bst_uint lower_bound,
     bst_uint upper_bound,
     bst_int split_cond,
@@ -780,11 +874,12 @@ void QuantileHistMaker::Builder::ApplySplitSparseData(
   }
 }
 
-void QuantileHistMaker::Builder::InitNewNode(int nid,
-                                             const GHistIndexMatrix& gmat,
-                                             const std::vector<GradientPair>& gpair,
-                                             const DMatrix& fmat,
-                                             const RegTree& tree) {
+template <typename GradientSumT>
+void QuantileHistMaker::Builder<GradientSumT>::InitNewNode(int nid,
+                                                           const GHistIndexMatrix& gmat,
+                                                           const std::vector<GradientPair>& gpair,
+                                                           const DMatrix& fmat,
+                                                           const RegTree& tree) {
   builder_monitor_.Start("InitNewNode");
   {
     snode_.resize(tree.param.num_nodes, NodeEntry(param_));
@@ -792,7 +887,7 @@ void QuantileHistMaker::Builder::InitNewNode(int nid,
 
   {
     auto& stats = snode_[nid].stats;
-    GHistRow hist = hist_[nid];
+    GHistRowT hist = hist_[nid];
     if (tree[nid].IsRoot()) {
       if (data_layout_ == kDenseDataZeroBased || data_layout_ == kDenseDataOneBased) {
         const std::vector<uint32_t>& row_ptr = gmat.cut.row_ptr;
@@ -800,7 +895,7 @@ void QuantileHistMaker::Builder::InitNewNode(int nid,
         const uint32_t iend = row_ptr[fid_least_bins_ + 1];
         auto begin = hist.data();
         for (uint32_t i = ibegin; i < iend; ++i) {
-          const GradStats et = begin[i];
+          const GHistEntry<GradientSumT> et = begin[i];
           stats.Add(et.sum_grad, et.sum_hess);
         }
       } else {
@@ -809,7 +904,12 @@ void QuantileHistMaker::Builder::InitNewNode(int nid,
           stats.Add(gpair[*it]);
         }
       }
-      histred_.Allreduce(&snode_[nid].stats, 1);
+      statred_.Allreduce(&snode_[nid].stats, 1);
+      // the histogram is summed over all workers by now, so the local sums
+      // only match it in single-process training
+      if (!rabit::IsDistributed() && ConsoleLogger::ShouldLog(ConsoleLogger::LV::kDebug)) {
+        this->ReportHistDrift(nid, gmat, gpair);
+      }
     } else {
       int parent_id = tree[nid].Parent();
       if (tree[nid].IsLeftChild()) {
@@ -832,14 +932,15 @@ void QuantileHistMaker::Builder::InitNewNode(int nid,
 }
 
 // enumerate the split values of specific feature
-void QuantileHistMaker::Builder::EnumerateSplit(int d_step,
-                                                const GHistIndexMatrix& gmat,
-                                                const GHistRow& hist,
-                                                const NodeEntry& snode,
-                                                const MetaInfo& info,
-                                                SplitEntry* p_best,
-                                                bst_uint fid,
-                                                bst_uint nodeID) {
+template <typename GradientSumT>
+void QuantileHistMaker::Builder<GradientSumT>::EnumerateSplit(int d_step,
+                                                              const GHistIndexMatrix& gmat,
+                                                              const GHistRowT& hist,
+                                                              const NodeEntry& snode,
+                                                              const MetaInfo& info,
+                                                              SplitEntry* p_best,
+                                                              bst_uint fid,
+                                                              bst_uint nodeID) {
   CHECK(d_step == +1 || d_step == -1);
 
   // aliases
@@ -906,6 +1007,39 @@ void QuantileHistMaker::Builder::EnumerateSplit(int d_step,
   p_best->Update(best);
 }
 
+template <typename GradientSumT>
+void QuantileHistMaker::Builder<GradientSumT>::ReportHistDrift(
+    int nid,
+    const GHistIndexMatrix& gmat,
+    const std::vector<GradientPair>& gpair) {
+  // every entry of a row adds the gradient pair of the row to one bin, so the
+  // total over all bins must equal the per-entry sum of gradients
+  double exact[2] = {0, 0};
+  const RowSetCollection::Elem e = row_set_collection_[nid];
+  for (const size_t* it = e.begin; it < e.end; ++it) {
+    const double nentry = static_cast<double>(gmat.row_ptr[*it + 1] - gmat.row_ptr[*it]);
+    exact[0] += nentry * gpair[*it].GetGrad();
+    exact[1] += nentry * gpair[*it].GetHess();
+  }
+
+  double accumulated[2] = {0, 0};
+  GHistRowT hist = hist_[nid];
+  for (const auto& bin : hist) {
+    accumulated[0] += bin.GetGrad();
+    accumulated[1] += bin.GetHess();
+  }
+  const double grad_drift =
+      std::abs(accumulated[0] - exact[0]) / std::max(std::abs(exact[0]), 1.0);
+  const double hess_drift =
+      std::abs(accumulated[1] - exact[1]) / std::max(std::abs(exact[1]), 1.0);
+  LOG(DEBUG) << "Histogram drift of node " << nid << " with "
+             << sizeof(GradientSumT) * 8 << "-bit accumulation: gradient "
+             << grad_drift << ", hessian " << hess_drift;
+}
+
+template struct QuantileHistMaker::Builder<float>;
+template struct QuantileHistMaker::Builder<double>;
+
 XGBOOST_REGISTER_TREE_UPDATER(FastHistMaker, "grow_fast_histmaker")
 .describe("(Deprecated, use grow_quantile_histmaker instead.)"
           " Grow tree using quantized histogram.")
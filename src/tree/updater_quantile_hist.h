@@ -26,6 +26,7 @@
 #include "../common/hist_util.h"
 #include "../common/row_set.h"
 #include "../common/column_matrix.h"
+#include "../common/quantized_matrix.h"
 
 namespace xgboost {
 
@@ -68,13 +69,14 @@ namespace tree {
 using xgboost::common::HistCutMatrix;
 using xgboost::common::GHistIndexMatrix;
 using xgboost::common::GHistIndexBlockMatrix;
-using xgboost::common::GHistIndexRow;
+using xgboost::common::GHistEntry;
 using xgboost::common::HistCollection;
 using xgboost::common::RowSetCollection;
 using xgboost::common::GHistRow;
 using xgboost::common::GHistBuilder;
 using xgboost::common::ColumnMatrix;
 using xgboost::common::Column;
+using xgboost::common::QuantizedMatrix;
 
 /*! \brief construct a tree using quantized feature values */
 class QuantileHistMaker: public TreeUpdater {
@@ -89,15 +91,17 @@ class QuantileHistMaker: public TreeUpdater {
                              HostDeviceVector<bst_float>* out_preds) override;
 
  protected:
+  // quantized matrix of dmat for the current parameters, shared through the DMatrix
+  std::shared_ptr<const QuantizedMatrix> GetQuantized(DMatrix* dmat);
+
   // training parameter
   TrainParam param_;
-  // quantized data matrix
-  GHistIndexMatrix gmat_;
+  // quantized data matrix with its column accessor
+  std::shared_ptr<const QuantizedMatrix> quantized_;
+  // shared matrix quantized_ was laid out from when sparse_threshold differs
+  std::shared_ptr<const QuantizedMatrix> quantized_source_;
   // (optional) data matrix with feature grouping
   GHistIndexBlockMatrix gmatb_;
-  // column accessor
-  ColumnMatrix column_matrix_;
-  bool is_gmat_initialized_;
 
   // data structure
   struct NodeEntry {
@@ -113,10 +117,14 @@ class QuantileHistMaker: public TreeUpdater {
     explicit NodeEntry(const TrainParam& param)
         : root_gain(0.0f), weight(0.0f) {}
   };
-  // actual builder that runs the algorithm
-
+  // actual builder that runs the algorithm; GradientSumT is the type used to
+  // accumulate histograms (see TrainParam::hist_precision)
+  template <typename GradientSumT>
   struct Builder {
    public:
+    using GHistRowT = GHistRow<GradientSumT>;
+    using HistCollectionT = HistCollection<GradientSumT>;
+
     // constructor
     explicit Builder(const TrainParam& param,
                      std::unique_ptr<TreeUpdater> pruner,
@@ -138,7 +146,7 @@ class QuantileHistMaker: public TreeUpdater {
                           const RowSetCollection::Elem row_indices,
                           const GHistIndexMatrix& gmat,
                           const GHistIndexBlockMatrix& gmatb,
-                          GHistRow hist,
+                          GHistRowT hist,
                           bool sync_hist) {
       builder_monitor_.Start("BuildHist");
       if (param_.enable_feature_grouping > 0) {
@@ -152,7 +160,7 @@ class QuantileHistMaker: public TreeUpdater {
       builder_monitor_.Stop("BuildHist");
     }
 
-    inline void SubtractionTrick(GHistRow self, GHistRow sibling, GHistRow parent) {
+    inline void SubtractionTrick(GHistRowT self, GHistRowT sibling, GHistRowT parent) {
       builder_monitor_.Start("SubtractionTrick");
       hist_builder_.SubtractionTrick(self, sibling, parent);
       builder_monitor_.Stop("SubtractionTrick");
@@ -180,28 +188,40 @@ class QuantileHistMaker: public TreeUpdater {
 
     void EvaluateSplit(const int nid,
                        const GHistIndexMatrix& gmat,
-                       const HistCollection& hist,
+                       const HistCollectionT& hist,
                        const DMatrix& fmat,
                        const RegTree& tree);
 
     void ApplySplit(int nid,
                     const GHistIndexMatrix& gmat,
                     const ColumnMatrix& column_matrix,
-                    const HistCollection& hist,
+                    const HistCollectionT& hist,
                     const DMatrix& fmat,
                     RegTree* p_tree);
 
+    template <typename BinIdxType>
+    void ApplySplitColumn(int nid,
+                          const GHistIndexMatrix& gmat,
+                          const ColumnMatrix& column_matrix,
+                          bst_uint fid,
+                          bst_uint lower_bound,
+                          bst_uint upper_bound,
+                          bst_int split_cond,
+                          bool default_left);
+
+    template <typename BinIdxType>
     void ApplySplitDenseData(const RowSetCollection::Elem rowset,
                              const GHistIndexMatrix& gmat,
                              std::vector<RowSetCollection::Split>* p_row_split_tloc,
-                             const Column& column,
+                             const Column<BinIdxType>& column,
                              bst_int split_cond,
                              bool default_left);
 
+    template <typename BinIdxType>
     void ApplySplitSparseData(const RowSetCollection::Elem rowset,
                               const GHistIndexMatrix& gmat,
                               std::vector<RowSetCollection::Split>* p_row_split_tloc,
-                              const Column& column,
+                              const Column<BinIdxType>& column,
                               bst_uint lower_bound,
                               bst_uint upper_bound,
                               bst_int split_cond,
@@ -213,10 +233,17 @@ class QuantileHistMaker: public TreeUpdater {
                      const DMatrix& fmat,
                      const RegTree& tree);
 
+    // debug check: log how far the root histogram has drifted from the
+    // gradient sums computed in double precision, single process only as it
+    // makes no collective calls
+    void ReportHistDrift(int nid,
+                         const GHistIndexMatrix& gmat,
+                         const std::vector<GradientPair>& gpair);
+
     // enumerate the split values of specific feature
     void EnumerateSplit(int d_step,
                         const GHistIndexMatrix& gmat,
-                        const GHistRow& hist,
+                        const GHistRowT& hist,
                         const NodeEntry& snode,
                         const MetaInfo& info,
                         SplitEntry* p_best,
@@ -283,14 +310,14 @@ class QuantileHistMaker: public TreeUpdater {
     /*! \brief TreeNode Data: statistics for each constructed node */
     std::vector<NodeEntry> snode_;
     /*! \brief culmulative histogram of gradients. */
-    HistCollection hist_;
+    HistCollectionT hist_;
     /*! \brief feature with least # of bins. to be used for dense specialization
                of InitNewNode() */
     uint32_t fid_least_bins_;
     /*! \brief local prediction cache; maps node id to leaf value */
     std::vector<float> leaf_value_cache_;
 
-    GHistBuilder hist_builder_;
+    GHistBuilder<GradientSumT> hist_builder_;
     std::unique_ptr<TreeUpdater> pruner_;
     std::unique_ptr<SplitEvaluator> spliteval_;
 
@@ -312,10 +339,18 @@ class QuantileHistMaker: public TreeUpdater {
     DataLayout data_layout_;
 
     common::Monitor builder_monitor_;
-    rabit::Reducer<GradStats, GradStats::Reduce> histred_;
+    rabit::Reducer<GradStats, GradStats::Reduce> statred_;
+    rabit::Reducer<GHistEntry<GradientSumT>, GHistEntry<GradientSumT>::Reduce> histred_;
   };
 
-  std::unique_ptr<Builder> builder_;
+  template <typename GradientSumT>
+  void UpdateWith(std::unique_ptr<Builder<GradientSumT> >* p_builder,
+                  HostDeviceVector<GradientPair>* gpair,
+                  DMatrix* dmat,
+                  const std::vector<RegTree*>& trees);
+
+  std::unique_ptr<Builder<double> > double_builder_;
+  std::unique_ptr<Builder<float> > float_builder_;
   std::unique_ptr<TreeUpdater> pruner_;
   std::unique_ptr<SplitEvaluator> spliteval_;
 };
@@ -55,10 +55,11 @@ class TreeRefresher: public TreeUpdater {
       // start accumulating statistics
       for (const auto &batch : p_fmat->GetRowBatches()) {
         CHECK_LT(batch.Size(), std::numeric_limits<unsigned>::max());
-        const auto nbatch = static_cast<bst_omp_uint>(batch.Size());
+        const SparsePageView page(batch);
+        const auto nbatch = static_cast<bst_omp_uint>(page.Size());
         #pragma omp parallel for schedule(static)
         for (bst_omp_uint i = 0; i < nbatch; ++i) {
-          SparsePage::Inst inst = batch[i];
+          SparsePage::Inst inst = page[i];
           const int tid = omp_get_thread_num();
           const auto ridx = static_cast<bst_uint>(batch.base_rowid + i);
           RegTree::FVec &feats = fvec_temp[tid];
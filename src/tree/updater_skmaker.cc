@@ -134,13 +134,14 @@ class SketchMaker: public BaseMaker {
     // start accumulating statistics
     for (const auto &batch : p_fmat->GetSortedColumnBatches()) {
       // start enumeration
-      const auto nsize = static_cast<bst_omp_uint>(batch.Size());
+      const SparsePageView page(batch);
+      const auto nsize = static_cast<bst_omp_uint>(page.Size());
       #pragma omp parallel for schedule(dynamic, 1)
       for (bst_omp_uint fidx = 0; fidx < nsize; ++fidx) {
-        this->UpdateSketchCol(gpair, batch[fidx], tree,
+        this->UpdateSketchCol(gpair, page[fidx], tree,
                               node_stats_,
                               fidx,
-                              static_cast<size_t>(batch[fidx].size()) == nrows,
+                              static_cast<size_t>(page[fidx].size()) == nrows,
                               &thread_sketch_[omp_get_thread_num()]);
       }
     }
@@ -3,6 +3,12 @@
 #include <xgboost/c_api.h>
 #include <xgboost/data.h>
 
+#include <limits>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
 TEST(c_api, XGDMatrixCreateFromMatDT) {
   std::vector<int> col0 = {0, -1, 3};
   std::vector<float> col1 = {-4.0f, 2.0f, 0.0f};
@@ -63,3 +69,206 @@ TEST(c_api, XGDMatrixCreateFromMat_omp) {
     delete dmat;
   }
 }
+
+TEST(c_api, XGBoosterPredictFromDense) {
+  const int kRows = 100, kCols = 10;
+  std::vector<float> data(kRows * kCols), labels(kRows);
+  for (int i = 0; i < kRows; ++i) {
+    for (int j = 0; j < kCols; ++j) {
+      data[i * kCols + j] = (i * 7 + j * 13) % 10 < 2
+          ? std::numeric_limits<float>::quiet_NaN()
+          : static_cast<float>((i * 31 + j * 17) % 23);
+    }
+    labels[i] = static_cast<float>(i % 3);
+  }
+  DMatrixHandle dmat;
+  ASSERT_EQ(XGDMatrixCreateFromMat(data.data(), kRows, kCols,
+                                   std::numeric_limits<float>::quiet_NaN(), &dmat), 0);
+  ASSERT_EQ(XGDMatrixSetFloatInfo(dmat, "label", labels.data(), kRows), 0);
+
+  // objective, number of classes
+  const std::vector<std::pair<std::string, int>> objectives {
+    {"reg:squarederror", 1}, {"multi:softmax", 3}, {"multi:softprob", 3}};
+  for (const auto& objective : objectives) {
+    const int num_class = objective.second;
+    BoosterHandle booster;
+    ASSERT_EQ(XGBoosterCreate(&dmat, 1, &booster), 0);
+    XGBoosterSetParam(booster, "objective", objective.first.c_str());
+    XGBoosterSetParam(booster, "num_class", std::to_string(num_class).c_str());
+    XGBoosterSetParam(booster, "max_depth", "3");
+    for (int iter = 0; iter < 4; ++iter) {
+      ASSERT_EQ(XGBoosterUpdateOneIter(booster, iter, dmat), 0);
+    }
+
+    for (int option_mask : {0, 1}) {
+      bst_ulong out_len;
+      const float* expected;
+      ASSERT_EQ(XGBoosterPredict(booster, dmat, option_mask, 0, &out_len, &expected), 0);
+      const bst_ulong len =
+          objective.first == "multi:softmax" && option_mask == 0 ? kRows : kRows * num_class;
+      ASSERT_EQ(out_len, len) << objective.first;
+      // the buffer always holds nrow * num_class, the rest must stay untouched
+      const float kUnset = -12345.0f;
+      std::vector<float> out(kRows * num_class, kUnset);
+      ASSERT_EQ(XGBoosterPredictFromDense(booster, data.data(), kRows, kCols,
+                                          std::numeric_limits<float>::quiet_NaN(),
+                                          option_mask, 0, out.data()), 0);
+      for (bst_ulong i = 0; i < len; ++i) {
+        ASSERT_NEAR(out[i], expected[i], 1e-6) << objective.first;
+      }
+      for (size_t i = len; i < out.size(); ++i) {
+        ASSERT_EQ(out[i], kUnset) << objective.first;
+      }
+
+      std::vector<float> buffer(len);
+      bst_ulong buffer_len;
+      ASSERT_NE(XGBoosterPredictToBuffer(booster, dmat, option_mask, 0, len - 1,
+                                         buffer.data(), &buffer_len), 0);
+      ASSERT_EQ(buffer_len, len);
+      ASSERT_EQ(XGBoosterPredictToBuffer(booster, dmat, option_mask, 0, len,
+                                         buffer.data(), &buffer_len), 0);
+      for (bst_ulong i = 0; i < len; ++i) {
+        ASSERT_EQ(buffer[i], expected[i]);
+      }
+    }
+    XGBoosterFree(booster);
+  }
+  XGDMatrixFree(dmat);
+}
+
+TEST(c_api, XGBoosterPredictConcurrent) {
+  const int kRows = 64, kCols = 5, kClasses = 3, kThreads = 4;
+  std::vector<float> data(kRows * kCols), labels(kRows);
+  for (int i = 0; i < kRows; ++i) {
+    for (int j = 0; j < kCols; ++j) {
+      data[i * kCols + j] = static_cast<float>((i * 31 + j * 17) % 23);
+    }
+    labels[i] = static_cast<float>(i % kClasses);
+  }
+  DMatrixHandle dtrain, dtest;
+  ASSERT_EQ(XGDMatrixCreateFromMat(data.data(), kRows, kCols,
+                                   std::numeric_limits<float>::quiet_NaN(), &dtrain), 0);
+  ASSERT_EQ(XGDMatrixSetFloatInfo(dtrain, "label", labels.data(), kRows), 0);
+  // not cached by the booster, so every call runs the predictor
+  ASSERT_EQ(XGDMatrixCreateFromMat(data.data(), kRows, kCols,
+                                   std::numeric_limits<float>::quiet_NaN(), &dtest), 0);
+  BoosterHandle booster;
+  ASSERT_EQ(XGBoosterCreate(&dtrain, 1, &booster), 0);
+  XGBoosterSetParam(booster, "objective", "multi:softmax");
+  XGBoosterSetParam(booster, "num_class", std::to_string(kClasses).c_str());
+  XGBoosterSetParam(booster, "max_depth", "3");
+  for (int iter = 0; iter < 3; ++iter) {
+    ASSERT_EQ(XGBoosterUpdateOneIter(booster, iter, dtrain), 0);
+  }
+
+  // class indices, the margins the softmax transformation reads and the
+  // feature contributions
+  const std::vector<int> option_masks {0, 1, 4};
+  std::vector<std::vector<float> > expected;
+  for (int option_mask : option_masks) {
+    bst_ulong out_len;
+    const float* out;
+    ASSERT_EQ(XGBoosterPredict(booster, dtest, option_mask, 0, &out_len, &out), 0);
+    expected.emplace_back(out, out + out_len);
+  }
+  ASSERT_EQ(expected[0].size(), kRows);
+
+  // a loaded copy, whose trees fill their node means in the concurrent calls
+  bst_ulong model_len;
+  const char* model;
+  ASSERT_EQ(XGBoosterGetModelRaw(booster, &model_len, &model), 0);
+  const std::string model_raw(model, model_len);
+  BoosterHandle loaded;
+  ASSERT_EQ(XGBoosterCreate(nullptr, 0, &loaded), 0);
+  ASSERT_EQ(XGBoosterLoadModelFromBuffer(loaded, model_raw.data(), model_raw.size()), 0);
+  {
+    bst_ulong out_len;
+    const float* out;
+    ASSERT_EQ(XGBoosterPredict(loaded, dtest, 0, 0, &out_len, &out), 0);
+  }
+
+  std::vector<int> failures(kThreads, 0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int iter = 0; iter < 50; ++iter) {
+        const size_t k = (t + iter) % option_masks.size();
+        bst_ulong out_len;
+        const float* out;
+        if (XGBoosterPredict(loaded, dtest, option_masks[k], 0, &out_len, &out) != 0) {
+          ++failures[t];
+          continue;
+        }
+        failures[t] += std::vector<float>(out, out + out_len) != expected[k];
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < kThreads; ++t) {
+    ASSERT_EQ(failures[t], 0);
+  }
+
+  XGBoosterFree(loaded);
+  XGBoosterFree(booster);
+  XGDMatrixFree(dtest);
+  XGDMatrixFree(dtrain);
+}
+
+TEST(c_api, XGDMatrixAppendRows) {
+  const int kRows = 60, kAppended = 20, kCols = 4;
+  std::vector<size_t> indptr {0};
+  std::vector<unsigned> indices;
+  std::vector<float> data, labels;
+  for (int i = 0; i < kRows + kAppended; ++i) {
+    for (int j = 0; j < kCols; ++j) {
+      if ((i + j) % 3 != 0) {
+        indices.push_back(j);
+        data.push_back(static_cast<float>((i * 31 + j * 17) % 23));
+      }
+    }
+    indptr.push_back(indices.size());
+    labels.push_back(static_cast<float>(i % 2));
+  }
+  DMatrixHandle dmat, all;
+  ASSERT_EQ(XGDMatrixCreateFromCSREx(indptr.data(), indices.data(), data.data(),
+                                     kRows + 1, indptr[kRows], kCols, &dmat), 0);
+  ASSERT_EQ(XGDMatrixSetFloatInfo(dmat, "label", labels.data(), kRows), 0);
+  ASSERT_EQ(XGDMatrixCreateFromCSREx(indptr.data(), indices.data(), data.data(),
+                                     indptr.size(), data.size(), kCols, &all), 0);
+  BoosterHandle booster;
+  ASSERT_EQ(XGBoosterCreate(&dmat, 1, &booster), 0);
+  XGBoosterSetParam(booster, "tree_method", "hist");
+  XGBoosterSetParam(booster, "max_depth", "3");
+  ASSERT_EQ(XGBoosterUpdateOneIter(booster, 0, dmat), 0);
+
+  // weights are required only when the matrix has them
+  std::vector<float> weights(kAppended, 1.0f);
+  ASSERT_NE(XGDMatrixAppendRows(dmat, indptr.data() + kRows, indices.data(), data.data(),
+                                kAppended + 1, indptr.back() - indptr[kRows],
+                                labels.data() + kRows, weights.data()), 0);
+  ASSERT_EQ(XGDMatrixAppendRows(dmat, indptr.data() + kRows, indices.data(), data.data(),
+                                kAppended + 1, indptr.back() - indptr[kRows],
+                                labels.data() + kRows, nullptr), 0);
+  bst_ulong num_row;
+  ASSERT_EQ(XGDMatrixNumRow(dmat, &num_row), 0);
+  ASSERT_EQ(num_row, kRows + kAppended);
+  ASSERT_EQ(XGBoosterUpdateOneIter(booster, 1, dmat), 0);
+
+  // cached predictions of the extended matrix match a matrix built at once
+  bst_ulong out_len;
+  const float* out;
+  ASSERT_EQ(XGBoosterPredict(booster, dmat, 0, 0, &out_len, &out), 0);
+  ASSERT_EQ(out_len, kRows + kAppended);
+  std::vector<float> preds(out, out + out_len);
+  ASSERT_EQ(XGBoosterPredict(booster, all, 0, 0, &out_len, &out), 0);
+  ASSERT_EQ(out_len, kRows + kAppended);
+  for (int i = 0; i < kRows + kAppended; ++i) {
+    ASSERT_NEAR(preds[i], out[i], 1e-6);
+  }
+
+  XGBoosterFree(booster);
+  XGDMatrixFree(dmat);
+  XGDMatrixFree(all);
+}
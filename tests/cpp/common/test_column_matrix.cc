@@ -10,10 +10,11 @@ TEST(DenseColumn, Test) {
   gmat.Init((*dmat).get(), 256);
   ColumnMatrix column_matrix;
   column_matrix.Init(gmat, 0.2);
+  ASSERT_EQ(column_matrix.GetTypeSize(), kUint8BinsTypeSize);
 
   for (auto i = 0ull; i < (*dmat)->Info().num_row_; i++) {
     for (auto j = 0ull; j < (*dmat)->Info().num_col_; j++) {
-        auto col = column_matrix.GetColumn(j);
+        auto col = column_matrix.GetColumn<uint8_t>(j);
         EXPECT_EQ(gmat.index[i * (*dmat)->Info().num_col_ + j],
                   col.GetGlobalBinIdx(i));
     }
@@ -27,8 +28,8 @@ TEST(SparseColumn, Test) {
   gmat.Init((*dmat).get(), 256);
   ColumnMatrix column_matrix;
   column_matrix.Init(gmat, 0.5);
-  auto col = column_matrix.GetColumn(0);
-  ASSERT_EQ(col.Size(), gmat.index.size());
+  auto col = column_matrix.GetColumn<uint8_t>(0);
+  ASSERT_EQ(col.Size(), gmat.index.Size());
   for (auto i = 0ull; i < col.Size(); i++) {
     EXPECT_EQ(gmat.index[gmat.row_ptr[col.GetRowIdx(i)]],
               col.GetGlobalBinIdx(i));
@@ -42,7 +43,7 @@ TEST(DenseColumnWithMissing, Test) {
   gmat.Init((*dmat).get(), 256);
   ColumnMatrix column_matrix;
   column_matrix.Init(gmat, 0.2);
-  auto col = column_matrix.GetColumn(0);
+  auto col = column_matrix.GetColumn<uint8_t>(0);
   for (auto i = 0ull; i < col.Size(); i++) {
     if (col.IsMissing(i)) continue;
     EXPECT_EQ(gmat.index[gmat.row_ptr[col.GetRowIdx(i)]],
@@ -50,5 +51,22 @@ TEST(DenseColumnWithMissing, Test) {
   }
   delete dmat;
 }
+
+TEST(DenseColumnUint16, Test) {
+  // more than 255 bins for a single feature
+  auto dmat = CreateDMatrix(1000, 1, 0.0);
+  GHistIndexMatrix gmat;
+  gmat.Init((*dmat).get(), 1024);
+  ASSERT_GT(gmat.GetMaxBinsPerFeature(), 255U);
+  ASSERT_EQ(gmat.index.GetBinTypeSize(), kUint16BinsTypeSize);
+  ColumnMatrix column_matrix;
+  column_matrix.Init(gmat, 0.2);
+  ASSERT_EQ(column_matrix.GetTypeSize(), kUint16BinsTypeSize);
+  auto col = column_matrix.GetColumn<uint16_t>(0);
+  for (auto i = 0ull; i < col.Size(); i++) {
+    EXPECT_EQ(gmat.index[i], col.GetGlobalBinIdx(i));
+  }
+  delete dmat;
+}
 }  // namespace common
 }  // namespace xgboost
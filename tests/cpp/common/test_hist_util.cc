@@ -1,4 +1,7 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <vector>
 #include <string>
 #include <utility>
@@ -47,5 +50,324 @@ TEST(HistCutMatrix, SearchGroupInd) {
   delete pp_mat;
 }
 
+TEST(HistCutMatrix, CountCutsNotGreater) {
+  // both the counting loop (up to kLinearSearchCuts) and the bisection
+  for (uint32_t size : {1U, 32U, 33U, 256U}) {
+    std::vector<bst_float> cuts(size);
+    for (uint32_t i = 0; i < size; ++i) {
+      cuts[i] = 0.5f * i - 3.0f;
+    }
+    std::vector<bst_float> values {cuts.front() - 1.0f, cuts.back() + 1.0f,
+                                   std::numeric_limits<bst_float>::infinity(),
+                                   -std::numeric_limits<bst_float>::infinity(),
+                                   std::numeric_limits<bst_float>::quiet_NaN()};
+    for (bst_float cut : cuts) {
+      values.push_back(cut);
+      values.push_back(cut + 0.25f);
+    }
+    for (bst_float value : values) {
+      const auto expected = static_cast<uint32_t>(
+          std::upper_bound(cuts.cbegin(), cuts.cend(), value) - cuts.cbegin());
+      ASSERT_EQ(CountCutsNotGreater(cuts.data(), size, value), expected)
+          << "size " << size << ", value " << value;
+    }
+  }
+}
+
+TEST(HistCutMatrix, SearchBin) {
+  HistCutMatrix cut;
+  cut.row_ptr = {0, 2, 5};
+  cut.cut = {1.0f, 2.0f, 0.0f, 10.0f, 20.0f};
+  cut.CheckCuts();
+  ASSERT_EQ(cut.SearchBin(0.5f, 0), 0U);
+  ASSERT_EQ(cut.SearchBin(1.0f, 0), 1U);
+  // past the last cut
+  ASSERT_EQ(cut.SearchBin(3.0f, 0), 1U);
+  ASSERT_EQ(cut.SearchBin(-1.0f, 1), 2U);
+  ASSERT_EQ(cut.SearchBin(15.0f, 1), 4U);
+  ASSERT_EQ(cut.SearchBin(std::numeric_limits<bst_float>::quiet_NaN(), 1), 4U);
+  ASSERT_EQ(cut.GetBinIdx(Entry(1, 10.0f)), 4U);
+
+  // a feature without cuts
+  cut.row_ptr = {0, 2, 2, 5};
+  EXPECT_ANY_THROW(cut.CheckCuts());
+  EXPECT_ANY_THROW(cut.GetBinIdx(Entry(1, 0.0f)));
+}
+
+TEST(HistCutMatrix, Sketch) {
+  size_t constexpr kNumRows = 4000;
+  size_t constexpr kNumCols = 4;
+  uint32_t constexpr kMaxBins = 64;
+  auto pp_dmat = CreateDMatrix(kNumRows, kNumCols, 0.5);
+  DMatrix* p_fmat = (*pp_dmat).get();
+  const auto& batch = *p_fmat->GetRowBatches().begin();
+
+  HistCutMatrix cut;
+  cut.Init(p_fmat, kMaxBins);
+  ASSERT_EQ(cut.row_ptr.size(), kNumCols + 1);
+  // bins hold a similar share of the values of each feature
+  std::vector<size_t> hits(cut.row_ptr.back(), 0);
+  std::vector<size_t> column_size(kNumCols, 0);
+  for (size_t i = 0; i < batch.Size(); ++i) {
+    for (const auto& e : batch[i]) {
+      ++hits[cut.GetBinIdx(e)];
+      ++column_size[e.index];
+    }
+  }
+  for (size_t fid = 0; fid < kNumCols; ++fid) {
+    const size_t nbins = cut.row_ptr[fid + 1] - cut.row_ptr[fid];
+    ASSERT_GT(nbins, kMaxBins / 2);
+    ASSERT_LE(nbins, kMaxBins);
+    for (size_t j = cut.row_ptr[fid]; j < cut.row_ptr[fid + 1]; ++j) {
+      if (j != cut.row_ptr[fid]) {
+        ASSERT_GT(cut.cut[j], cut.cut[j - 1]);
+      }
+      ASSERT_LE(hits[j], 2 * column_size[fid] / nbins);
+    }
+  }
+
+  // weights given per group, rows of the second group are ignored
+  std::vector<bst_int> group {kNumRows / 2, kNumRows / 2};
+  std::vector<bst_float> weights {1.0f, 0.0f};
+  p_fmat->Info().SetInfo("group", group.data(), DataType::kUInt32, group.size());
+  p_fmat->Info().SetInfo("weight", weights.data(), DataType::kFloat32, weights.size());
+  bst_float max_value = -std::numeric_limits<bst_float>::max();
+  for (size_t i = 0; i < kNumRows / 2; ++i) {
+    for (const auto& e : batch[i]) {
+      if (e.index == 0) max_value = std::max(max_value, e.fvalue);
+    }
+  }
+  HistCutMatrix group_cut;
+  group_cut.Init(p_fmat, kMaxBins);
+  ASSERT_EQ(group_cut.cut[group_cut.row_ptr[1] - 1],
+            static_cast<bst_float>(max_value + (fabs(max_value) + 1e-5)));
+
+  delete pp_dmat;
+}
+
+TEST(HistCutMatrix, SketchSample) {
+  size_t constexpr kNumRows = 20000;
+  size_t constexpr kNumCols = 2;
+  uint32_t constexpr kMaxBins = 32;
+  auto pp_dmat = CreateDMatrix(kNumRows, kNumCols, 0);
+  DMatrix* p_fmat = (*pp_dmat).get();
+  const auto& batch = *p_fmat->GetRowBatches().begin();
+
+  auto check_bins = [&](HistCutMatrix& cut) {
+    std::vector<size_t> hits(cut.row_ptr.back(), 0);
+    for (size_t i = 0; i < batch.Size(); ++i) {
+      for (const auto& e : batch[i]) {
+        ++hits[cut.GetBinIdx(e)];
+      }
+    }
+    for (size_t fid = 0; fid < kNumCols; ++fid) {
+      const size_t nbins = cut.row_ptr[fid + 1] - cut.row_ptr[fid];
+      ASSERT_GT(nbins, kMaxBins / 2);
+      for (size_t j = cut.row_ptr[fid]; j < cut.row_ptr[fid + 1]; ++j) {
+        ASSERT_LE(hits[j], 2 * kNumRows / nbins);
+      }
+    }
+  };
+
+  HistCutMatrix cut;
+  cut.Init(p_fmat, kMaxBins, kNumRows / 10);
+  check_bins(cut);
+
+  // every group gets a share of the sample, with its weight
+  std::vector<bst_int> group(100, kNumRows / 100);
+  std::vector<bst_float> weights(group.size(), 1.0f);
+  p_fmat->Info().SetInfo("group", group.data(), DataType::kUInt32, group.size());
+  p_fmat->Info().SetInfo("weight", weights.data(), DataType::kFloat32, weights.size());
+  HistCutMatrix group_cut;
+  group_cut.Init(p_fmat, kMaxBins, kNumRows / 10);
+  check_bins(group_cut);
+
+  delete pp_dmat;
+}
+
+TEST(GHistIndexMatrix, BinTypeSize) {
+  size_t constexpr kNumRows = 64;
+  size_t constexpr kNumCols = 8;
+
+  // dense data is stored as feature-local bins in the narrowest type
+  auto pp_dense = CreateDMatrix(kNumRows, kNumCols, 0);
+  GHistIndexMatrix dense;
+  dense.Init((*pp_dense).get(), 256);
+  ASSERT_TRUE(dense.index.IsDense());
+  ASSERT_EQ(dense.index.GetBinTypeSize(), kUint8BinsTypeSize);
+  ASSERT_EQ(dense.index.OffsetSize(), kNumCols);
+  ASSERT_EQ(dense.index.Size(), kNumRows * kNumCols);
+  for (const auto& batch : (*pp_dense)->GetRowBatches()) {
+    for (size_t i = 0; i < batch.Size(); ++i) {
+      SparsePage::Inst inst = batch[i];
+      for (const auto& e : inst) {
+        // operator[] recovers the global bin id
+        ASSERT_EQ(dense.index[dense.row_ptr[batch.base_rowid + i] + e.index],
+                  dense.cut.GetBinIdx(e));
+      }
+    }
+  }
+  delete pp_dense;
+
+  // sparse data keeps global bin ids as uint32_t
+  auto pp_sparse = CreateDMatrix(kNumRows, kNumCols, 0.5);
+  GHistIndexMatrix sparse;
+  sparse.Init((*pp_sparse).get(), 256);
+  ASSERT_FALSE(sparse.index.IsDense());
+  ASSERT_EQ(sparse.index.GetBinTypeSize(), kUint32BinsTypeSize);
+  delete pp_sparse;
+}
+
+TEST(GHistIndexMatrix, Append) {
+  size_t constexpr kNumRows = 64;
+  size_t constexpr kNumCols = 8;
+  auto pp_dmat = CreateDMatrix(kNumRows, kNumCols, 0);
+  DMatrix* p_fmat = (*pp_dmat).get();
+  GHistIndexMatrix gmat;
+  gmat.Init(p_fmat, 256);
+  const std::vector<bst_float> cuts = gmat.cut.cut;
+
+  auto check = [&]() {
+    ASSERT_EQ(gmat.row_ptr.size(), p_fmat->Info().num_row_ + 1);
+    ASSERT_EQ(gmat.cut.cut, cuts);
+    size_t hits = 0;
+    for (size_t count : gmat.hit_count) hits += count;
+    ASSERT_EQ(hits, p_fmat->Info().num_nonzero_);
+    const auto& batch = *p_fmat->GetRowBatches().begin();
+    for (size_t i = 0; i < batch.Size(); ++i) {
+      SparsePage::Inst inst = batch[i];
+      ASSERT_EQ(gmat.row_ptr[i + 1] - gmat.row_ptr[i], inst.size());
+      std::vector<uint32_t> expected, bins;
+      for (const auto& e : inst) expected.push_back(gmat.cut.GetBinIdx(e));
+      for (size_t j = gmat.row_ptr[i]; j < gmat.row_ptr[i + 1]; ++j) {
+        bins.push_back(gmat.index[j]);
+      }
+      std::sort(expected.begin(), expected.end());
+      std::sort(bins.begin(), bins.end());
+      ASSERT_EQ(bins, expected);
+    }
+  };
+
+  // dense rows are binned against the existing cuts in the narrow layout
+  auto pp_dense = CreateDMatrix(3, kNumCols, 0, 1);
+  p_fmat->AppendRows(*(*pp_dense)->GetRowBatches().begin(), MetaInfo());
+  gmat.Append(p_fmat);
+  ASSERT_TRUE(gmat.index.IsDense());
+  check();
+
+  // rows with missing values switch to the sparse layout
+  auto pp_sparse = CreateDMatrix(5, kNumCols, 0.5, 2);
+  p_fmat->AppendRows(*(*pp_sparse)->GetRowBatches().begin(), MetaInfo());
+  gmat.Append(p_fmat);
+  ASSERT_FALSE(gmat.index.IsDense());
+  check();
+
+  delete pp_dense;
+  delete pp_sparse;
+  delete pp_dmat;
+}
+
+TEST(GHistBuilder, ColumnBlocks) {
+  size_t constexpr kNumRows = 64;
+  size_t constexpr kNumCols = 8;
+  size_t constexpr kNumThreads = 4;
+  auto pp_dmat = CreateDMatrix(kNumRows, kNumCols, 0);
+  GHistIndexMatrix gmat;
+  gmat.Init((*pp_dmat).get(), 256);
+  ASSERT_TRUE(gmat.index.IsDense());
+
+  std::vector<GradientPair> gpair(kNumRows);
+  for (size_t i = 0; i < kNumRows; ++i) {
+    gpair[i] = GradientPair(static_cast<float>(i) / kNumRows, 1.0f);
+  }
+  std::vector<size_t> rows(kNumRows);
+  for (size_t i = 0; i < kNumRows; ++i) {
+    rows[i] = i;
+  }
+
+  const uint32_t nbins = gmat.cut.row_ptr.back();
+  GHistBuilder<double> builder;
+  builder.Init(kNumThreads, nbins);
+  // a handful of rows is cheaper to process by column blocks, while the full
+  // data set must be split by rows when there are fewer bins than rows
+  size_t constexpr kSmallNode = 3;
+  ASSERT_LT(kSmallNode * kNumThreads, nbins);
+  ASSERT_TRUE(builder.UseColumnBlocks(gmat, kSmallNode));
+
+  for (size_t nrows : {kSmallNode, kNumRows}) {
+    RowSetCollection::Elem elem(rows.data(), rows.data() + nrows, 0);
+    std::vector<GHistEntry<double> > hist(nbins);
+    // garbage left over from a previous node must be overwritten
+    hist[0].sum_grad = 1e10;
+    builder.BuildHist(gpair, elem, gmat, {hist.data(), nbins});
+
+    std::vector<GradientPairPrecise> expected(nbins);
+    for (size_t rid = 0; rid < nrows; ++rid) {
+      for (size_t i = gmat.row_ptr[rid]; i < gmat.row_ptr[rid + 1]; ++i) {
+        expected[gmat.index[i]] += GradientPairPrecise(gpair[rid]);
+      }
+    }
+    for (size_t i = 0; i < nbins; ++i) {
+      ASSERT_NEAR(hist[i].GetGrad(), expected[i].GetGrad(), 1e-6);
+      ASSERT_NEAR(hist[i].GetHess(), expected[i].GetHess(), 1e-6);
+    }
+  }
+  delete pp_dmat;
+}
+
+TEST(GHistBuilder, BuildHists) {
+  size_t constexpr kNumRows = 1500;
+  size_t constexpr kNumCols = 8;
+  size_t constexpr kNumThreads = 4;
+  std::vector<GradientPair> gpair(kNumRows);
+  for (size_t i = 0; i < kNumRows; ++i) {
+    gpair[i] = GradientPair(static_cast<float>(i % 13) - 6.0f, 1.0f);
+  }
+  std::vector<size_t> rows(kNumRows);
+  for (size_t i = 0; i < kNumRows; ++i) {
+    rows[i] = i;
+  }
+  // nodes spanning several row blocks, no rows at all and a single block, or
+  // only nodes without rows as on a worker holding none of their rows
+  const std::vector<std::vector<size_t> > node_ptrs {{0, 1100, 1100, 1107, kNumRows},
+                                                     {0, 0, 0, 0}};
+
+  for (const auto& node_ptr : node_ptrs) {
+    for (float sparsity : {0.0f, 0.5f}) {
+      auto pp_dmat = CreateDMatrix(kNumRows, kNumCols, sparsity);
+      GHistIndexMatrix gmat;
+      gmat.Init((*pp_dmat).get(), 64);
+      const uint32_t nbins = gmat.cut.row_ptr.back();
+      GHistBuilder<double> builder;
+      builder.Init(kNumThreads, nbins);
+
+      std::vector<RowSetCollection::Elem> row_indices;
+      std::vector<std::vector<GHistEntry<double> > > hists(node_ptr.size() - 1);
+      std::vector<GHistRow<double> > hist_rows;
+      for (size_t node = 0; node + 1 < node_ptr.size(); ++node) {
+        row_indices.emplace_back(rows.data() + node_ptr[node],
+                                 rows.data() + node_ptr[node + 1], node);
+        // stale values, which must be overwritten
+        hists[node].resize(nbins);
+        hists[node][0].Add(GradientPair(1.0f, 1.0f));
+        hist_rows.emplace_back(hists[node].data(), nbins);
+      }
+      builder.BuildHists(gpair, row_indices, gmat, hist_rows);
+
+      for (size_t node = 0; node < hists.size(); ++node) {
+        std::vector<GHistEntry<double> > expected(nbins);
+        if (row_indices[node].Size() != 0) {
+          builder.BuildHist(gpair, row_indices[node], gmat, {expected.data(), nbins});
+        }
+        for (size_t i = 0; i < nbins; ++i) {
+          ASSERT_NEAR(hists[node][i].GetGrad(), expected[i].GetGrad(), 1e-6);
+          ASSERT_NEAR(hists[node][i].GetHess(), expected[i].GetHess(), 1e-6);
+        }
+      }
+      delete pp_dmat;
+    }
+  }
+}
+
 }  // namespace common
 }  // namespace xgboost
@@ -0,0 +1,91 @@
+// Copyright by Contributors
+#include <dmlc/filesystem.h>
+#include <dmlc/memory_io.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../../../src/common/io.h"
+
+namespace xgboost {
+namespace common {
+TEST(MmapReadStream, Read) {
+  dmlc::TemporaryDirectory tempdir;
+  const std::string path = tempdir.path + "/mmap.bin";
+  std::vector<uint32_t> values(1000);
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = static_cast<uint32_t>(i * 2654435761U);
+  }
+  {
+    std::ofstream fo(path, std::ios::binary);
+    fo.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(uint32_t));
+  }
+
+  std::unique_ptr<MmapReadStream> fi(MmapReadStream::Create(path));
+#if !defined(_WIN32)
+  ASSERT_NE(fi, nullptr);
+  ASSERT_EQ(fi->Size(), values.size() * sizeof(uint32_t));
+  ASSERT_EQ(std::memcmp(fi->Data(), values.data(), fi->Size()), 0);
+  uint32_t first;
+  ASSERT_EQ(fi->Read(&first, sizeof(first)), sizeof(first));
+  ASSERT_EQ(first, values[0]);
+  std::vector<uint32_t> rest(values.size() - 1);
+  ASSERT_EQ(fi->Read(rest.data(), rest.size() * sizeof(uint32_t)),
+            rest.size() * sizeof(uint32_t));
+  ASSERT_TRUE(std::equal(rest.begin(), rest.end(), values.begin() + 1));
+  // at the end of the file
+  ASSERT_EQ(fi->Read(&first, sizeof(first)), 0);
+#endif  // !defined(_WIN32)
+
+  ASSERT_EQ(MmapReadStream::Create(tempdir.path + "/missing.bin"), nullptr);
+  ASSERT_EQ(MmapReadStream::Create("s3://bucket/file"), nullptr);
+}
+
+TEST(WritePredictions, Format) {
+  std::vector<bst_float> preds {0.0f, -0.0f, 1.0f, 0.1f, -2.5e-8f, 1.0f / 3.0f, 123456789.0f,
+                                std::numeric_limits<bst_float>::min(),
+                                std::numeric_limits<bst_float>::denorm_min(),
+                                std::numeric_limits<bst_float>::max(),
+                                std::numeric_limits<bst_float>::infinity(),
+                                -std::numeric_limits<bst_float>::infinity(),
+                                std::numeric_limits<bst_float>::quiet_NaN()};
+  for (int i = 0; i < 1000; ++i) {
+    preds.push_back(std::sin(static_cast<bst_float>(i)) * std::pow(10.0f, i % 20 - 10));
+  }
+  // text as written by an ostream before
+  std::ostringstream expected;
+  for (bst_float p : preds) {
+    expected << std::setprecision(std::numeric_limits<bst_float>::max_digits10) << p << '\n';
+  }
+  std::string text;
+  {
+    dmlc::MemoryStringStream fo(&text);
+    WritePredictions(preds, false, &fo);
+  }
+  ASSERT_EQ(text, expected.str());
+
+  std::string binary;
+  {
+    dmlc::MemoryStringStream fo(&binary);
+    WritePredictions(preds, true, &fo);
+  }
+  ASSERT_EQ(binary.size(), preds.size() * sizeof(bst_float));
+  std::vector<bst_float> loaded(preds.size());
+  std::memcpy(loaded.data(), binary.data(), binary.size());
+  for (size_t i = 0; i < preds.size(); ++i) {
+    if (std::isnan(preds[i])) {
+      ASSERT_TRUE(std::isnan(loaded[i]));
+    } else {
+      ASSERT_EQ(loaded[i], preds[i]);
+    }
+  }
+}
+}  // namespace common
+}  // namespace xgboost
@@ -0,0 +1,52 @@
+#include <dmlc/io.h>
+#include <dmlc/memory_io.h>
+#include <string>
+
+#include "../../../src/common/quantized_matrix.h"
+#include "../helpers.h"
+#include "gtest/gtest.h"
+
+namespace xgboost {
+namespace common {
+TEST(QuantizedMatrix, SaveLoadBinary) {
+  for (float sparsity : {0.0f, 0.5f}) {
+    auto dmat = CreateDMatrix(100, 10, sparsity);
+    auto quantized = QuantizedMatrix::Create((*dmat).get(), 64, 0.2);
+
+    std::string buffer;
+    {
+      dmlc::MemoryStringStream fo(&buffer);
+      quantized->SaveBinary(&fo);
+    }
+    dmlc::MemoryStringStream fi(&buffer);
+    auto loaded = QuantizedMatrix::LoadBinary(&fi, *(*dmat));
+
+    ASSERT_EQ(loaded->max_bin, 64);
+    ASSERT_EQ(loaded->sparse_threshold, 0.2);
+    const GHistIndexMatrix& expected = quantized->gmat;
+    const GHistIndexMatrix& gmat = loaded->gmat;
+    ASSERT_EQ(gmat.cut.row_ptr, expected.cut.row_ptr);
+    ASSERT_EQ(gmat.cut.min_val, expected.cut.min_val);
+    ASSERT_EQ(gmat.cut.cut, expected.cut.cut);
+    ASSERT_EQ(gmat.row_ptr, expected.row_ptr);
+    ASSERT_EQ(gmat.hit_count, expected.hit_count);
+    ASSERT_EQ(gmat.index.IsDense(), expected.index.IsDense());
+    ASSERT_EQ(gmat.index.GetBinTypeSize(), expected.index.GetBinTypeSize());
+    ASSERT_EQ(gmat.index.Size(), expected.index.Size());
+    for (size_t i = 0; i < gmat.index.Size(); ++i) {
+      ASSERT_EQ(gmat.index[i], expected.index[i]);
+    }
+    // the column matrix is laid out again from the bins
+    ASSERT_EQ(loaded->column_matrix.GetTypeSize(), quantized->column_matrix.GetTypeSize());
+    ASSERT_EQ(loaded->column_matrix.GetNumFeature(), quantized->column_matrix.GetNumFeature());
+
+    // the bins belong to a matrix of the same shape
+    auto other = CreateDMatrix(50, 10, sparsity);
+    dmlc::MemoryStringStream fi_other(&buffer);
+    EXPECT_ANY_THROW(QuantizedMatrix::LoadBinary(&fi_other, *(*other)));
+    delete other;
+    delete dmat;
+  }
+}
+}  // namespace common
+}  // namespace xgboost
@@ -59,5 +59,32 @@ TEST(Transform, DeclareUnifiedTest(Basic)) {
   ASSERT_TRUE(std::equal(h_sol.begin(), h_sol.end(), res.begin()));
 }
 
+TEST(Transform, DeclareUnifiedTest(Blocked)) {
+  // not a multiple of the block size, so the last block is partial
+  const size_t size {kCpuBlockSize * 3 + 17};
+  std::vector<bst_float> h_in(size);
+  InitializeRange(h_in.begin(), h_in.end());
+  std::vector<bst_float> h_sol(size);
+  InitializeRange(h_sol.begin(), h_sol.end());
+
+  const HostDeviceVector<bst_float> in_vec{h_in, TRANSFORM_GPU_DIST};
+  HostDeviceVector<bst_float> out_vec{std::vector<bst_float>(size), TRANSFORM_GPU_DIST};
+  out_vec.Fill(0);
+
+  Transform<>::InitBlocked(TestTransformRange<bst_float>{},
+                           [](size_t begin, size_t end,
+                              Span<bst_float> _out, Span<const bst_float> _in) {
+                             for (size_t i = begin; i < end; ++i) {
+                               _out[i] = _in[i];
+                             }
+                           },
+                           Range{0, static_cast<Range::DifferenceType>(size)},
+                           TRANSFORM_GPU_RANGE)
+      .Eval(&out_vec, &in_vec);
+  std::vector<bst_float> res = out_vec.HostVector();
+
+  ASSERT_TRUE(std::equal(h_sol.begin(), h_sol.end(), res.begin()));
+}
+
 } // namespace common
 } // namespace xgboost
@@ -52,4 +52,31 @@ TEST(SparsePage, PushCSC) {
     ASSERT_EQ(inst[i].index, indices_sol[i % 3]);
   }
 }
+
+TEST(SparsePage, View) {
+  SparsePage page;
+  page.offset.HostVector() = {0, 2, 2, 5};
+  page.data.HostVector() = {Entry(0, 1.0f), Entry(3, 2.0f), Entry(1, 3.0f),
+                            Entry(2, 4.0f), Entry(4, 5.0f)};
+  page.base_rowid = 7;
+
+  const SparsePageView view(page);
+  ASSERT_EQ(view.Size(), page.Size());
+  ASSERT_EQ(view.base_rowid, 7);
+  for (size_t i = 0; i < page.Size(); ++i) {
+    auto expected = page[i];
+    auto inst = view[i];
+    ASSERT_EQ(inst.size(), expected.size());
+    ASSERT_EQ(inst.data(), expected.data());
+  }
+
+  auto transpose = page.GetTranspose(5);
+  ASSERT_EQ(transpose.Size(), 5);
+  ASSERT_EQ(transpose.data.Size(), 5);
+  const SparsePageView column(transpose);
+  ASSERT_EQ(column[3].size(), 1);
+  ASSERT_EQ(column[3][0].index, 7);
+  ASSERT_EQ(column[3][0].fvalue, 2.0f);
+  ASSERT_EQ(column[4][0].index, 9);
+}
 }  // namespace xgboost
@@ -0,0 +1,96 @@
+// Copyright by Contributors
+#include <dmlc/data.h>
+#include <gtest/gtest.h>
+#include <xgboost/data.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "../../../src/data/parser_batches.h"
+
+namespace xgboost {
+namespace data {
+namespace {
+// Parser over fixed row blocks, a block without entries has no index
+class BlockParser : public dmlc::Parser<uint32_t> {
+ public:
+  explicit BlockParser(const std::vector<std::vector<std::vector<uint32_t>>>& blocks) {
+    for (const auto& rows : blocks) {
+      offset_.emplace_back(1, 0);
+      index_.emplace_back();
+      value_.emplace_back();
+      for (const auto& row : rows) {
+        for (uint32_t fid : row) {
+          index_.back().push_back(fid);
+          value_.back().push_back(static_cast<float>(fid) * 0.5f);
+        }
+        offset_.back().push_back(index_.back().size());
+      }
+    }
+  }
+  void BeforeFirst() override { pos_ = 0; }
+  bool Next() override {
+    if (pos_ == offset_.size()) return false;
+    block_ = dmlc::RowBlock<uint32_t>();
+    block_.size = offset_[pos_].size() - 1;
+    block_.offset = offset_[pos_].data();
+    block_.index = index_[pos_].empty() ? nullptr : index_[pos_].data();
+    block_.value = value_[pos_].empty() ? nullptr : value_[pos_].data();
+    ++pos_;
+    return true;
+  }
+  const dmlc::RowBlock<uint32_t>& Value() const override { return block_; }
+  size_t BytesRead() const override { return 0; }
+
+ private:
+  std::vector<std::vector<size_t>> offset_;
+  std::vector<std::vector<uint32_t>> index_;
+  std::vector<std::vector<float>> value_;
+  dmlc::RowBlock<uint32_t> block_;
+  size_t pos_ {0};
+};
+}  // anonymous namespace
+
+TEST(ParserBatches, Split) {
+  // blocks of 5, 0, 2 (both empty) and 4 rows
+  const std::vector<std::vector<std::vector<uint32_t>>> blocks {
+    {{0, 3}, {}, {1}, {2, 4, 6}, {5}},
+    {},
+    {{}, {}},
+    {{7}, {0, 1}, {}, {3}}};
+  std::vector<std::vector<uint32_t>> all_rows;
+  for (const auto& rows : blocks) {
+    all_rows.insert(all_rows.end(), rows.begin(), rows.end());
+  }
+
+  for (size_t batch_rows : {1, 2, 3, 4, 5, 7, 100}) {
+    BlockParser parser(blocks);
+    ParserBatches batches(&parser, batch_rows);
+    size_t row = 0;
+    while (batches.Next()) {
+      DMatrix* batch = batches.Value();
+      const size_t expected_rows = std::min(batch_rows, all_rows.size() - row);
+      ASSERT_EQ(batch->Info().num_row_, expected_rows) << "batch_rows " << batch_rows;
+      uint64_t num_col = 0, num_nonzero = 0;
+      for (const auto& page : batch->GetRowBatches()) {
+        ASSERT_EQ(page.Size(), expected_rows);
+        for (size_t i = 0; i < page.Size(); ++i, ++row) {
+          auto inst = page[i];
+          ASSERT_EQ(static_cast<size_t>(inst.size()), all_rows[row].size()) << "row " << row;
+          for (size_t j = 0; j < inst.size(); ++j) {
+            ASSERT_EQ(inst[j].index, all_rows[row][j]);
+            ASSERT_EQ(inst[j].fvalue, static_cast<float>(all_rows[row][j]) * 0.5f);
+            num_col = std::max(num_col, static_cast<uint64_t>(inst[j].index + 1));
+          }
+          num_nonzero += inst.size();
+        }
+      }
+      ASSERT_EQ(batch->Info().num_col_, num_col);
+      ASSERT_EQ(batch->Info().num_nonzero_, num_nonzero);
+    }
+    ASSERT_EQ(row, all_rows.size()) << "batch_rows " << batch_rows;
+    ASSERT_FALSE(batches.Next());
+  }
+}
+}  // namespace data
+}  // namespace xgboost
@@ -1,6 +1,7 @@
 // Copyright by Contributors
 #include <xgboost/data.h>
 #include <dmlc/filesystem.h>
+#include <fstream>
 #include "../../../src/data/simple_csr_source.h"
 
 #include "../helpers.h"
@@ -33,3 +34,64 @@ TEST(SimpleCSRSource, SaveLoadBinary) {
   delete dmat;
   delete dmat_read;
 }
+
+TEST(SimpleCSRSource, LoadTextLibSVM) {
+  dmlc::TemporaryDirectory tempdir;
+  const std::string tmp_file = tempdir.path + "/text.libsvm";
+  {
+    std::ofstream fo(tmp_file.c_str());
+    fo << "1:0.5 qid:1 0:1.5 3:-2.5e-1 # comment\n"
+       << "\n"
+       << "0:2 qid:1 1 2:3\r\n"
+       << "-1.25:1 qid:2 10:12345678.5\n"
+       << "0:1 qid:2";
+  }
+  xgboost::data::SimpleCSRSource source;
+  ASSERT_TRUE(source.LoadText(tmp_file, "auto"));
+  const xgboost::MetaInfo& info = source.info;
+  EXPECT_EQ(info.num_row_, 4);
+  EXPECT_EQ(info.num_col_, 11);
+  EXPECT_EQ(info.num_nonzero_, 5);
+  EXPECT_EQ(info.labels_.HostVector(),
+            std::vector<xgboost::bst_float>({1.0f, 0.0f, -1.25f, 0.0f}));
+  EXPECT_EQ(info.weights_.HostVector(),
+            std::vector<xgboost::bst_float>({0.5f, 2.0f, 1.0f, 1.0f}));
+  EXPECT_EQ(info.group_ptr_, std::vector<xgboost::bst_uint>({0, 2, 4}));
+
+  const auto& offset = source.page_.offset.HostVector();
+  const auto& data = source.page_.data.HostVector();
+  EXPECT_EQ(offset, std::vector<size_t>({0, 2, 4, 5, 5}));
+  EXPECT_EQ(data[1].index, 3);
+  EXPECT_EQ(data[1].fvalue, -0.25f);
+  EXPECT_EQ(data[2].index, 1);
+  EXPECT_EQ(data[2].fvalue, 1.0f);
+  EXPECT_EQ(data[4].index, 10);
+  EXPECT_EQ(data[4].fvalue, 12345678.5f);
+
+  // unsupported parser arguments are left to dmlc::Parser
+  EXPECT_FALSE(source.LoadText(tmp_file + "?indexing_mode=1", "auto"));
+}
+
+TEST(SimpleCSRSource, LoadTextCSV) {
+  dmlc::TemporaryDirectory tempdir;
+  const std::string tmp_file = tempdir.path + "/text.csv";
+  {
+    std::ofstream fo(tmp_file.c_str());
+    fo << "\xEF\xBB\xBF" << "1.5,7,2\n"
+       << "-3,,4e2\n";
+  }
+  xgboost::data::SimpleCSRSource source;
+  ASSERT_TRUE(source.LoadText(tmp_file + "?format=csv&label_column=1", "auto"));
+  const xgboost::MetaInfo& info = source.info;
+  EXPECT_EQ(info.num_row_, 2);
+  EXPECT_EQ(info.num_col_, 2);
+  EXPECT_EQ(info.labels_.HostVector(), std::vector<xgboost::bst_float>({7.0f, 0.0f}));
+  EXPECT_EQ(info.weights_.Size(), 0);
+  const auto& data = source.page_.data.HostVector();
+  ASSERT_EQ(data.size(), 4);
+  EXPECT_EQ(data[0].fvalue, 1.5f);
+  EXPECT_EQ(data[1].index, 1);
+  EXPECT_EQ(data[1].fvalue, 2.0f);
+  EXPECT_EQ(data[2].fvalue, -3.0f);
+  EXPECT_EQ(data[3].fvalue, 400.0f);
+}
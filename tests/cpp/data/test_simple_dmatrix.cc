@@ -63,3 +63,63 @@ TEST(SimpleDMatrix, ColAccessWithoutBatches) {
   EXPECT_EQ(num_col_batch, 1) << "Expected number of batches to be 1";
   delete dmat;
 }
+
+TEST(SimpleDMatrix, AppendRows) {
+  dmlc::TemporaryDirectory tempdir;
+  const std::string tmp_file = tempdir.path + "/simple.libsvm";
+  CreateSimpleTestData(tmp_file);
+  xgboost::DMatrix * dmat = xgboost::DMatrix::Load(tmp_file, true, false);
+  EXPECT_EQ(dmat->GetColDensity(1), 0.5);
+
+  xgboost::SparsePage page;
+  page.Push(*dmat->GetRowBatches().begin());
+  xgboost::MetaInfo info;
+  info.labels_.HostVector() = {2.0f, 3.0f};
+  dmat->AppendRows(page, info);
+
+  EXPECT_EQ(dmat->Info().num_row_, 4);
+  EXPECT_EQ(dmat->Info().num_col_, 5);
+  EXPECT_EQ(dmat->Info().num_nonzero_, 12);
+  EXPECT_EQ(dmat->Info().labels_.Size(), 4);
+  EXPECT_EQ(dmat->Info().labels_.HostVector()[3], 3.0f);
+  auto &batch = *dmat->GetRowBatches().begin();
+  ASSERT_EQ(batch.Size(), 4);
+  EXPECT_EQ(batch[2][2].fvalue, 20);
+  // column pages are rebuilt with the new rows
+  EXPECT_EQ((*dmat->GetColumnBatches().begin())[0].size(), 4);
+  EXPECT_EQ(dmat->GetColDensity(1), 0.5);
+
+  // meta data must match what the matrix has
+  xgboost::MetaInfo weighted;
+  weighted.labels_.HostVector() = {2.0f, 3.0f};
+  weighted.weights_.HostVector() = {1.0f, 1.0f};
+  EXPECT_ANY_THROW(dmat->AppendRows(page, weighted));
+  EXPECT_ANY_THROW(dmat->AppendRows(page, xgboost::MetaInfo()));
+
+  delete dmat;
+}
+
+TEST(SimpleDMatrix, ColumnPages) {
+  auto pp_a = xgboost::CreateDMatrix(100, 10, 0.3, 1);
+  auto pp_b = xgboost::CreateDMatrix(100, 10, 0.3, 1);
+  xgboost::DMatrix* a = (*pp_a).get();
+  xgboost::DMatrix* b = (*pp_b).get();
+
+  // the sorted page of a is derived from its unsorted one
+  const auto& columns = *a->GetColumnBatches().begin();
+  const auto& sorted_a = *a->GetSortedColumnBatches().begin();
+  const auto& sorted_b = *b->GetSortedColumnBatches().begin();
+  ASSERT_EQ(sorted_a.offset.HostVector(), sorted_b.offset.HostVector());
+  ASSERT_EQ(sorted_a.data.HostVector(), sorted_b.data.HostVector());
+
+  for (size_t fid = 0; fid < columns.Size(); ++fid) {
+    auto column = columns[fid];
+    for (size_t j = 1; j < column.size(); ++j) {
+      ASSERT_LT(column[j - 1].index, column[j].index);
+    }
+    EXPECT_FLOAT_EQ(a->GetColDensity(fid),
+                    static_cast<float>(column.size()) / a->Info().num_row_);
+  }
+  delete pp_a;
+  delete pp_b;
+}
@@ -2,6 +2,7 @@
 #include <xgboost/data.h>
 #include <dmlc/filesystem.h>
 #include <cinttypes>
+#include <fstream>
 
 #include "../../../src/data/sparse_page_dmatrix.h"
 
@@ -25,6 +26,44 @@ TEST(SparsePageDMatrix, MetaInfo) {
   delete dmat;
 }
 
+TEST(SparsePageDMatrix, ColumnFormatSortedColumns) {
+  dmlc::TemporaryDirectory tempdir;
+  const std::string tmp_file = tempdir.path + "/unsorted.libsvm";
+  {
+    std::ofstream fo(tmp_file);
+    fo << "0 0:3 1:1\n1 0:1\n0 0:4 1:2\n1 0:2 1:0.5\n";
+  }
+  // row pages use the column format, the column pages of the cache must not
+  std::unique_ptr<xgboost::DMatrix> dmat(xgboost::DMatrix::Load(
+      tmp_file + "#" + tmp_file + ".cache.fmt-column", true, false));
+
+  auto& rows = *dmat->GetRowBatches().begin();
+  ASSERT_EQ(rows.Size(), 4);
+  EXPECT_EQ(rows[1].size(), 1);
+  EXPECT_EQ(rows[3][1].fvalue, 0.5f);
+
+  for (auto& col_batch : dmat->GetSortedColumnBatches()) {
+    ASSERT_EQ(col_batch.Size(), 2);
+    // column 0 sorted by value: rows 1, 3, 0, 2
+    std::vector<xgboost::bst_uint> expected_rows {1, 3, 0, 2};
+    ASSERT_EQ(col_batch[0].size(), expected_rows.size());
+    for (size_t i = 0; i < expected_rows.size(); ++i) {
+      EXPECT_EQ(col_batch[0][i].index, expected_rows[i]);
+      EXPECT_EQ(col_batch[0][i].fvalue, static_cast<float>(i + 1));
+    }
+    std::vector<xgboost::bst_uint> expected_rows_1 {3, 0, 2};
+    ASSERT_EQ(col_batch[1].size(), expected_rows_1.size());
+    for (size_t i = 0; i < expected_rows_1.size(); ++i) {
+      EXPECT_EQ(col_batch[1][i].index, expected_rows_1[i]);
+    }
+  }
+  for (auto& col_batch : dmat->GetColumnBatches()) {
+    ASSERT_EQ(col_batch.Size(), 2);
+    EXPECT_EQ(col_batch[0].size(), 4);
+    EXPECT_EQ(col_batch[1].size(), 3);
+  }
+}
+
 TEST(SparsePageDMatrix, RowAccess) {
   std::unique_ptr<xgboost::DMatrix> dmat = xgboost::CreateSparsePageDMatrix(12, 64);
 
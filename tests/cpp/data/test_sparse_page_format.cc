@@ -0,0 +1,53 @@
+// Copyright by Contributors
+#include <dmlc/memory_io.h>
+#include <gtest/gtest.h>
+#include <xgboost/data.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../../../src/data/sparse_page_writer.h"
+
+namespace xgboost {
+namespace data {
+TEST(SparsePageFormat, Column) {
+  // rows {0: 1.0, 2: 2.0}, {}, {1: 3.0, 3: 4.0}, {2: 5.0}
+  SparsePage page;
+  auto& offset_vec = page.offset.HostVector();
+  auto& data_vec = page.data.HostVector();
+  offset_vec = {0, 2, 2, 4, 5};
+  data_vec = {Entry(0, 1.0f), Entry(2, 2.0f), Entry(1, 3.0f), Entry(3, 4.0f),
+              Entry(2, 5.0f)};
+
+  std::unique_ptr<SparsePageFormat> format(SparsePageFormat::Create("column"));
+  std::string buffer;
+  dmlc::MemoryStringStream fo(&buffer);
+  // two records, to check that reads stop at the end of a record
+  format->Write(page, &fo);
+  format->Write(page, &fo);
+
+  dmlc::MemoryStringStream fi(&buffer);
+  SparsePage all;
+  ASSERT_TRUE(format->Read(&all, &fi));
+  ASSERT_EQ(all.offset.HostVector(), offset_vec);
+  for (size_t i = 0; i < data_vec.size(); ++i) {
+    ASSERT_EQ(all.data.HostVector()[i].index, data_vec[i].index);
+    ASSERT_EQ(all.data.HostVector()[i].fvalue, data_vec[i].fvalue);
+  }
+
+  // features 2 and 3 only
+  SparsePage subset;
+  ASSERT_TRUE(format->Read(&subset, &fi, {2, 3}));
+  std::vector<size_t> expected_offset = {0, 1, 1, 2, 3};
+  ASSERT_EQ(subset.offset.HostVector(), expected_offset);
+  std::vector<Entry> expected_data = {Entry(2, 2.0f), Entry(3, 4.0f), Entry(2, 5.0f)};
+  for (size_t i = 0; i < expected_data.size(); ++i) {
+    ASSERT_EQ(subset.data.HostVector()[i].index, expected_data[i].index);
+    ASSERT_EQ(subset.data.HostVector()[i].fvalue, expected_data[i].fvalue);
+  }
+
+  ASSERT_FALSE(format->Read(&all, &fi));
+}
+}  // namespace data
+}  // namespace xgboost
@@ -1,6 +1,9 @@
 // Copyright by Contributors
 #include <xgboost/metric.h>
 
+#include <memory>
+#include <vector>
+
 #include "../helpers.h"
 
 TEST(Metric, UnknownMetric) {
@@ -17,3 +20,38 @@ TEST(Metric, UnknownMetric) {
     delete metric;
   }
 }
+
+TEST(Metric, EvalMany) {
+  std::vector<std::unique_ptr<xgboost::Metric> > metrics;
+  for (const char* name : {"rmse", "logloss", "error", "auc", "aucpr",
+                           "ndcg@3", "map", "pre@2", "auc@8", "ams@0"}) {
+    metrics.emplace_back(xgboost::Metric::Create(name));
+  }
+  const std::vector<xgboost::bst_float> preds {
+      0.1f, 0.9f, 0.4f, 0.4f, 0.7f, 0.2f, 0.8f, 0.3f, 0.6f, 0.5f};
+  xgboost::MetaInfo info;
+  info.num_row_ = preds.size();
+  info.labels_.HostVector() = {0, 1, 0, 1, 1, 0, 1, 0, 0, 1};
+  info.weights_.HostVector() = {1, 2, 1, 1, 3, 1, 1, 2, 1, 1};
+  xgboost::HostDeviceVector<xgboost::bst_float> h_preds(preds);
+
+  // same values as evaluating each metric on its own
+  std::vector<xgboost::bst_float> values =
+      xgboost::Metric::EvalMany(metrics, h_preds, info, false);
+  ASSERT_EQ(values.size(), metrics.size());
+  for (size_t i = 0; i < metrics.size(); ++i) {
+    EXPECT_FLOAT_EQ(values[i], metrics[i]->Eval(h_preds, info, false))
+        << metrics[i]->Name();
+  }
+
+  info.group_ptr_ = {0, 4, 10};
+  info.weights_.HostVector().clear();
+  values = xgboost::Metric::EvalMany(metrics, h_preds, info, false);
+  for (size_t i = 0; i < metrics.size(); ++i) {
+    EXPECT_FLOAT_EQ(values[i], metrics[i]->Eval(h_preds, info, false))
+        << metrics[i]->Name();
+  }
+
+  info.labels_.HostVector().pop_back();
+  EXPECT_ANY_THROW(xgboost::Metric::EvalMany(metrics, h_preds, info, false));
+}
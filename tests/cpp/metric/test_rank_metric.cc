@@ -1,7 +1,12 @@
 // Copyright by Contributors
 #include <xgboost/metric.h>
 
+#include <cmath>
+#include <limits>
+#include <memory>
+
 #include "../helpers.h"
+#include "../../../src/metric/metric_common.h"
 
 TEST(Metric, AMS) {
   EXPECT_ANY_THROW(xgboost::Metric::Create("ams"));
@@ -35,6 +40,96 @@ TEST(Metric, AUC) {
   delete metric;
 }
 
+TEST(Metric, AUCLarge) {
+  // long enough for the radix sort, with predictions of both signs; the
+  // positive sample i is ranked above the (i + 1) / 2 negative ones before it
+  const size_t n = 1 << 17;
+  xgboost::HostDeviceVector<xgboost::bst_float> preds(n);
+  std::vector<xgboost::bst_float> labels(n);
+  for (size_t i = 0; i < n; ++i) {
+    preds.HostVector()[i] = (static_cast<xgboost::bst_float>(i) - n / 2) / n;
+    labels[i] = i % 2;
+  }
+  const double m = n / 2;
+  xgboost::Metric * metric = xgboost::Metric::Create("auc");
+  EXPECT_NEAR(GetMetricEval(metric, preds, labels), (m + 1) / (2 * m), 1e-6);
+  delete metric;
+
+  // bins of 16 samples, each holding 8 positive and 8 negative tied samples
+  metric = xgboost::Metric::Create("auc@8192");
+  ASSERT_STREQ(metric->Name(), "auc@8192");
+  EXPECT_NEAR(GetMetricEval(metric, preds, labels), 0.5, 1e-6);
+  delete metric;
+}
+
+TEST(Metric, AUCApprox) {
+  EXPECT_ANY_THROW(xgboost::Metric::Create("auc@0"));
+  EXPECT_ANY_THROW(xgboost::Metric::Create("auc@x"));
+  EXPECT_ANY_THROW(xgboost::Metric::Create("auc@-1"));
+  xgboost::Metric * metric = xgboost::Metric::Create("auc@16");
+  ASSERT_STREQ(metric->Name(), "auc@16");
+  EXPECT_NEAR(GetMetricEval(metric, {0, 1}, {0, 1}), 1, 1e-10);
+  EXPECT_NEAR(GetMetricEval(metric,
+                            {0.1f, 0.9f, 0.1f, 0.9f},
+                            {  0,   0,   1,   1}),
+              0.5f, 0.001f);
+  EXPECT_NEAR(GetMetricEval(metric,
+                            {0.1f, 0.5f, 0.6f, 0.9f},
+                            {  0,   1,   0,   1}),
+              0.75f, 0.001f);
+  // 0.5 and 0.52 share a bin, and are counted as tied
+  EXPECT_NEAR(GetMetricEval(metric,
+                            {0.0f, 0.5f, 0.52f, 1.0f},
+                            {  0,   1,   0,    1}),
+              0.875f, 0.001f);
+  EXPECT_ANY_THROW(GetMetricEval(metric, {0, 0}, {0, 0}));
+  // infinite predictions fall into the outer bins
+  EXPECT_NEAR(GetMetricEval(metric,
+                            {-std::numeric_limits<float>::infinity(), 0.1f, 0.5f, 0.6f, 0.9f,
+                             std::numeric_limits<float>::infinity()},
+                            {0, 0, 1, 0, 1, 1}),
+              8.0f / 9.0f, 0.001f);
+  EXPECT_TRUE(std::isnan(GetMetricEval(metric,
+                                       {0.1f, std::numeric_limits<float>::quiet_NaN()},
+                                       {  0,   1})));
+
+  delete metric;
+}
+
+TEST(Metric, AUCApproxGroups) {
+  // three groups of ten rows, each with its own prediction range
+  xgboost::MetaInfo info;
+  info.num_row_ = 30;
+  info.group_ptr_ = {0, 10, 20, 30};
+  xgboost::HostDeviceVector<xgboost::bst_float> preds(info.num_row_);
+  auto& h_labels = info.labels_.HostVector();
+  h_labels.resize(info.num_row_);
+  for (size_t i = 0; i < info.num_row_; ++i) {
+    const size_t group = i / 10, j = i % 10;
+    preds.HostVector()[i] = static_cast<xgboost::bst_float>(group * 100 + j);
+    h_labels[i] = (j * 7 + group) % 3 == 0;
+  }
+  std::unique_ptr<xgboost::Metric> exact(xgboost::Metric::Create("auc"));
+  std::unique_ptr<xgboost::Metric> approx(xgboost::Metric::Create("auc@64"));
+  ASSERT_FALSE(dynamic_cast<xgboost::metric::SortedPredictionMetric*>(approx.get())
+                   ->UsesOrder(info));
+  // the predictions of each group land in distinct bins of its own histogram,
+  // a histogram of all the rows would put neighbouring ones into the same bin
+  EXPECT_NEAR(approx->Eval(preds, info, false), exact->Eval(preds, info, false), 1e-6);
+
+  // samples sharing a bin count as tied in every group
+  info.num_row_ = 8;
+  info.group_ptr_ = {0, 4, 8};
+  h_labels = {0, 1, 0, 1, 0, 1, 0, 1};
+  preds.HostVector() = {0.0f, 0.5f, 0.52f, 1.0f, 2.0f, 3.0f, 3.04f, 4.0f};
+  std::unique_ptr<xgboost::Metric> coarse(xgboost::Metric::Create("auc@16"));
+  EXPECT_NEAR(exact->Eval(preds, info, false), 0.75f, 1e-6);
+  EXPECT_NEAR(coarse->Eval(preds, info, false), 0.875f, 1e-6);
+
+  preds.HostVector()[5] = std::numeric_limits<float>::quiet_NaN();
+  EXPECT_TRUE(std::isnan(coarse->Eval(preds, info, false)));
+}
+
 TEST(Metric, AUCPR) {
   xgboost::Metric *metric = xgboost::Metric::Create("aucpr");
   ASSERT_STREQ(metric->Name(), "aucpr");
@@ -1,6 +1,8 @@
 // Copyright by Contributors
 #include <xgboost/objective.h>
 
+#include <cmath>
+
 #include "../helpers.h"
 
 TEST(Objective, PairwiseRankingGPair) {
@@ -28,3 +30,52 @@ TEST(Objective, PairwiseRankingGPair) {
 
   delete obj;
 }
+
+TEST(Objective, NDCGRankingGPair) {
+  xgboost::ObjFunction * obj = xgboost::ObjFunction::Create("rank:ndcg");
+  std::vector<std::pair<std::string, std::string> > args;
+  obj->Configure(args);
+  // a group large enough to be split across threads, a small one, and one
+  // without relevant documents
+  const std::vector<unsigned> gptr {0, 20000, 20010, 20020};
+  xgboost::MetaInfo info;
+  info.num_row_ = gptr.back();
+  info.group_ptr_ = gptr;
+  auto& labels = info.labels_.HostVector();
+  xgboost::HostDeviceVector<xgboost::bst_float> preds(gptr.back());
+  auto& preds_h = preds.HostVector();
+  for (unsigned i = 0; i < gptr.back(); ++i) {
+    labels.push_back(i < gptr[2] ? static_cast<xgboost::bst_float>(i * 7 % 5) : 0.0f);
+    preds_h[i] = static_cast<xgboost::bst_float>(i * 13 % 101) / 101.0f;
+  }
+
+  xgboost::HostDeviceVector<xgboost::GradientPair> gpair;
+  obj->GetGradient(preds, info, 0, &gpair);
+  const auto& gpair_h = gpair.HostVector();
+  ASSERT_EQ(gpair_h.size(), gptr.back());
+  for (size_t k = 0; k + 1 < gptr.size(); ++k) {
+    double sum_grad = 0, sum_abs_grad = 0;
+    for (unsigned i = gptr[k]; i < gptr[k + 1]; ++i) {
+      EXPECT_GE(gpair_h[i].GetHess(), 0.0f);
+      sum_grad += gpair_h[i].GetGrad();
+      sum_abs_grad += std::abs(gpair_h[i].GetGrad());
+    }
+    // every pair moves its two documents in opposite directions
+    EXPECT_NEAR(sum_grad, 0.0, 1e-3);
+    if (k + 2 == gptr.size()) {
+      EXPECT_EQ(sum_abs_grad, 0.0);
+    } else {
+      EXPECT_GT(sum_abs_grad, 0.0);
+    }
+  }
+
+  // the sampled pairs depend only on the iteration
+  xgboost::HostDeviceVector<xgboost::GradientPair> again;
+  obj->GetGradient(preds, info, 0, &again);
+  for (size_t i = 0; i < gpair_h.size(); ++i) {
+    ASSERT_EQ(again.HostVector()[i].GetGrad(), gpair_h[i].GetGrad());
+    ASSERT_EQ(again.HostVector()[i].GetHess(), gpair_h[i].GetHess());
+  }
+
+  delete obj;
+}
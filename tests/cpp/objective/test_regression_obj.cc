@@ -4,6 +4,9 @@
 #include <gtest/gtest.h>
 #include <xgboost/objective.h>
 
+#include <algorithm>
+#include <cmath>
+
 #include "../helpers.h"
 
 TEST(Objective, DeclareUnifiedTest(LinearRegressionGPair)) {
@@ -69,6 +72,44 @@ TEST(Objective, DeclareUnifiedTest(LogisticRegressionBasic)) {
   delete obj;
 }
 
+TEST(Objective, DeclareUnifiedTest(LogisticRegressionWeighted)) {
+  xgboost::ObjFunction * obj = xgboost::ObjFunction::Create("reg:logistic");
+  std::vector<std::pair<std::string, std::string> > args {{"scale_pos_weight", "3"}};
+  obj->Configure(args);
+  // enough rows to span several blocks of the CPU kernel
+  const size_t n = 10000;
+  std::vector<xgboost::bst_float> preds(n), labels(n), weights(n);
+  for (size_t i = 0; i < n; ++i) {
+    preds[i] = static_cast<xgboost::bst_float>(i % 17) / 4.0f - 2.0f;
+    labels[i] = static_cast<xgboost::bst_float>(i % 3 == 0);
+    weights[i] = static_cast<xgboost::bst_float>(i % 5 + 1);
+  }
+  xgboost::MetaInfo info;
+  info.num_row_ = n;
+  info.labels_.HostVector() = labels;
+  for (int weighted = 0; weighted < 2; ++weighted) {
+    info.weights_.HostVector() = weighted ? weights : std::vector<xgboost::bst_float>{};
+    xgboost::HostDeviceVector<xgboost::bst_float> in_preds(preds);
+    xgboost::HostDeviceVector<xgboost::GradientPair> out_gpair;
+    obj->GetGradient(in_preds, info, 0, &out_gpair);
+    const auto& gpair = out_gpair.HostVector();
+    ASSERT_EQ(gpair.size(), n);
+    for (size_t i = 0; i < n; ++i) {
+      xgboost::bst_float p = 1.0f / (1.0f + std::exp(-preds[i]));
+      xgboost::bst_float w = (weighted ? weights[i] : 1.0f) * (labels[i] == 1.0f ? 3.0f : 1.0f);
+      EXPECT_NEAR(gpair[i].GetGrad(), (p - labels[i]) * w, 1e-5f);
+      EXPECT_NEAR(gpair[i].GetHess(), std::max(p * (1.0f - p), 1e-16f) * w, 1e-5f);
+    }
+  }
+  // an invalid label in the last block is still reported
+  info.labels_.HostVector().back() = 2.0f;
+  xgboost::HostDeviceVector<xgboost::bst_float> in_preds(preds);
+  xgboost::HostDeviceVector<xgboost::GradientPair> out_gpair;
+  EXPECT_ANY_THROW(obj->GetGradient(in_preds, info, 0, &out_gpair));
+
+  delete obj;
+}
+
 TEST(Objective, DeclareUnifiedTest(LogisticRawGPair)) {
   xgboost::ObjFunction * obj = xgboost::ObjFunction::Create("binary:logitraw");
   std::vector<std::pair<std::string, std::string> > args;
@@ -2,6 +2,7 @@
 #include <dmlc/filesystem.h>
 #include <gtest/gtest.h>
 #include <xgboost/predictor.h>
+#include <thread>
 #include "../helpers.h"
 
 namespace xgboost {
@@ -95,4 +96,119 @@ TEST(cpu_predictor, ExternalMemoryTest) {
     ASSERT_EQ(v, 1.5);
   }
 }
+
+TEST(cpu_predictor, SplitTrees) {
+  // not a multiple of the block size of the predictor
+  int constexpr kRows = 100, kCols = 4;
+  auto dmat = CreateDMatrix(kRows, kCols, 0.3);
+
+  gbm::GBTreeModel model(0.0);
+  model.param.num_output_group = 2;
+  model.param.num_feature = kCols;
+  model.base_margin = 0;
+  for (int gid = 0; gid < 2; ++gid) {
+    std::vector<std::unique_ptr<RegTree>> trees;
+    trees.push_back(std::unique_ptr<RegTree>(new RegTree));
+    RegTree& tree = *trees.back();
+    tree.ExpandNode(0, gid, 0.5f, gid == 0, 0.0f, 0.1f, 0.2f, 0.0f, 0.0f);
+    tree.ExpandNode(tree[0].LeftChild(), 3, 0.3f, gid != 0, 0.0f, 0.3f, 0.4f, 0.0f, 0.0f);
+    model.CommitModel(std::move(trees), gid);
+  }
+
+  std::unique_ptr<Predictor> cpu_predictor =
+      std::unique_ptr<Predictor>(Predictor::Create("cpu_predictor"));
+  std::unique_ptr<Predictor> quantized_predictor =
+      std::unique_ptr<Predictor>(Predictor::Create("cpu_predictor"));
+  quantized_predictor->Init({{"quantized_prediction", "1"}}, {});
+  // predict twice, adding a tree in between, to cover reuse of the compiled model
+  for (int round = 0; round < 2; ++round) {
+    HostDeviceVector<float> out_predictions;
+    cpu_predictor->PredictBatch((*dmat).get(), &out_predictions, model, 0);
+    const std::vector<float>& out_predictions_h = out_predictions.HostVector();
+    ASSERT_EQ(out_predictions_h.size(), kRows * 2);
+
+    // comparing bins must give the same result as comparing values
+    HostDeviceVector<float> quantized_predictions;
+    quantized_predictor->PredictBatch((*dmat).get(), &quantized_predictions, model, 0);
+    ASSERT_EQ(quantized_predictions.HostVector(), out_predictions_h);
+
+    RegTree::FVec feats;
+    feats.Init(kCols);
+    for (const auto& batch : (*dmat)->GetRowBatches()) {
+      for (size_t i = 0; i < batch.Size(); ++i) {
+        feats.Fill(batch[i]);
+        float expected[2] = {0.0f, 0.0f};
+        for (size_t t = 0; t < model.trees.size(); ++t) {
+          const RegTree& tree = *model.trees[t];
+          expected[model.tree_info[t]] += tree[tree.GetLeafIndex(feats)].LeafValue();
+        }
+        feats.Drop(batch[i]);
+        const size_t ridx = batch.base_rowid + i;
+        ASSERT_EQ(out_predictions_h[ridx * 2], expected[0]);
+        ASSERT_EQ(out_predictions_h[ridx * 2 + 1], expected[1]);
+      }
+    }
+
+    std::vector<std::unique_ptr<RegTree>> trees;
+    trees.push_back(std::unique_ptr<RegTree>(new RegTree));
+    trees.back()->ExpandNode(0, 2, 0.6f, true, 0.0f, -0.5f, 0.5f, 0.0f, 0.0f);
+    model.CommitModel(std::move(trees), 1);
+  }
+
+  delete dmat;
+}
+
+TEST(cpu_predictor, ConcurrentPredict) {
+  int constexpr kRows = 100, kCols = 4, kThreads = 4;
+  auto dmat = CreateDMatrix(kRows, kCols, 0.3);
+
+  gbm::GBTreeModel model(0.0);
+  model.param.num_output_group = 1;
+  model.param.num_feature = kCols;
+  for (int i = 0; i < 2; ++i) {
+    std::vector<std::unique_ptr<RegTree>> trees;
+    trees.push_back(std::unique_ptr<RegTree>(new RegTree));
+    RegTree& tree = *trees.back();
+    tree.ExpandNode(0, i, 0.5f, i == 0, 0.0f, 0.1f, 0.2f, 0.0f, 0.0f);
+    tree.ExpandNode(tree[0].LeftChild(), 3, 0.3f, true, 0.0f, 0.3f, 0.4f, 0.0f, 0.0f);
+    model.CommitModel(std::move(trees), 0);
+  }
+
+  std::unique_ptr<Predictor> cpu_predictor =
+      std::unique_ptr<Predictor>(Predictor::Create("cpu_predictor"));
+  // expected predictions with all trees and with the first tree only
+  std::vector<float> expected[2];
+  for (unsigned ntree_limit = 0; ntree_limit < 2; ++ntree_limit) {
+    HostDeviceVector<float> out_predictions;
+    cpu_predictor->PredictBatch((*dmat).get(), &out_predictions, model, 0, ntree_limit);
+    expected[ntree_limit] = out_predictions.HostVector();
+  }
+
+  // alternating tree limits make the threads rebuild the compiled forest
+  std::vector<int> failures(kThreads, 0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int iter = 0; iter < 50; ++iter) {
+        const unsigned ntree_limit = (t + iter) % 2;
+        HostDeviceVector<float> out_predictions;
+        cpu_predictor->PredictBatch((*dmat).get(), &out_predictions, model, 0, ntree_limit);
+        failures[t] += out_predictions.HostVector() != expected[ntree_limit];
+        auto &batch = *(*dmat)->GetRowBatches().begin();
+        std::vector<float> instance_out_predictions;
+        cpu_predictor->PredictInstance(batch[iter], &instance_out_predictions, model,
+                                       ntree_limit);
+        failures[t] += instance_out_predictions[0] != expected[ntree_limit][iter];
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < kThreads; ++t) {
+    ASSERT_EQ(failures[t], 0);
+  }
+
+  delete dmat;
+}
 }  // namespace xgboost
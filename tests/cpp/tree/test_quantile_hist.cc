@@ -20,8 +20,8 @@ namespace tree {
 class QuantileHistMock : public QuantileHistMaker {
   static double constexpr kEps = 1e-6;
 
-  struct BuilderMock : public QuantileHistMaker::Builder {
-    using RealImpl = QuantileHistMaker::Builder;
+  struct BuilderMock : public QuantileHistMaker::Builder<double> {
+    using RealImpl = QuantileHistMaker::Builder<double>;
 
     BuilderMock(const TrainParam& param,
                 std::unique_ptr<TreeUpdater> pruner,
@@ -61,14 +61,15 @@ class QuantileHistMock : public QuantileHistMaker {
 
       /* Validate GHistIndexMatrix */
       ASSERT_EQ(gmat.row_ptr.size(), num_row + 1);
-      ASSERT_LT(*std::max_element(gmat.index.begin(), gmat.index.end()),
-                gmat.cut.row_ptr.back());
+      for (size_t i = 0; i < gmat.index.Size(); ++i) {
+        ASSERT_LT(gmat.index[i], gmat.cut.row_ptr.back());
+      }
       for (const auto& batch : p_fmat->GetRowBatches()) {
         for (size_t i = 0; i < batch.Size(); ++i) {
           const size_t rid = batch.base_rowid + i;
           ASSERT_LT(rid, num_row);
           const size_t gmat_row_offset = gmat.row_ptr[rid];
-          ASSERT_LT(gmat_row_offset, gmat.index.size());
+          ASSERT_LT(gmat_row_offset, gmat.index.Size());
           SparsePage::Inst inst = batch[i];
           ASSERT_EQ(gmat.row_ptr[rid] + inst.size(), gmat.row_ptr[rid + 1]);
           for (size_t j = 0; j < inst.size(); ++j) {
@@ -259,6 +260,14 @@ class QuantileHistMock : public QuantileHistMaker {
     gmat.Init((*dmat_).get(), kMaxBins);
 
     builder_->TestBuildHist(0, gmat, *(*dmat_).get(), tree);
+
+    // dense data is processed without reading row_ptr
+    auto dense = CreateDMatrix(kNRows, kNCols, 0, 3);
+    common::GHistIndexMatrix dense_gmat;
+    dense_gmat.Init((*dense).get(), kMaxBins);
+    ASSERT_TRUE(dense_gmat.index.IsDense());
+    builder_->TestBuildHist(0, dense_gmat, *(*dense).get(), tree);
+    delete dense;
   }
 
   void TestEvaluateSplit() {
@@ -295,5 +304,101 @@ TEST(Updater, QuantileHist_EvalSplits) {
   maker.TestEvaluateSplit();
 }
 
+TEST(Updater, QuantileHist_FloatPrecision) {
+  int constexpr kNRows = 32, kNCols = 16;
+  auto dmat = CreateDMatrix(kNRows, kNCols, 0, 3);
+  HostDeviceVector<GradientPair> gpair(kNRows);
+  auto& h_gpair = gpair.HostVector();
+  for (size_t i = 0; i < h_gpair.size(); ++i) {
+    h_gpair[i] = GradientPair(static_cast<float>(i % 7) / 7.0f - 0.5f, 0.25f);
+  }
+
+  std::vector<RegTree> trees(2);
+  const char* precisions[] = {"double", "float"};
+  for (size_t k = 0; k < trees.size(); ++k) {
+    std::vector<std::pair<std::string, std::string>> cfg
+        {{"num_feature", std::to_string(kNCols)},
+         {"max_depth", "3"},
+         {"hist_precision", precisions[k]}};
+    std::unique_ptr<TreeUpdater> updater(TreeUpdater::Create("grow_quantile_histmaker"));
+    updater->Init(cfg);
+    trees[k].param.InitAllowUnknown(cfg);
+    std::vector<RegTree*> p_trees {&trees[k]};
+    updater->Update(&gpair, dmat->get(), p_trees);
+  }
+
+  // float accumulation of a small dataset must not change the tree
+  ASSERT_EQ(trees[0].param.num_nodes, trees[1].param.num_nodes);
+  for (int nid = 0; nid < trees[0].param.num_nodes; ++nid) {
+    ASSERT_EQ(trees[0][nid].IsLeaf(), trees[1][nid].IsLeaf());
+    if (trees[0][nid].IsLeaf()) {
+      ASSERT_NEAR(trees[0][nid].LeafValue(), trees[1][nid].LeafValue(), 1e-5);
+    } else {
+      ASSERT_EQ(trees[0][nid].SplitIndex(), trees[1][nid].SplitIndex());
+      ASSERT_EQ(trees[0][nid].SplitCond(), trees[1][nid].SplitCond());
+    }
+  }
+
+  delete dmat;
+}
+
+TEST(Updater, QuantileHist_SharedQuantizedMatrix) {
+  int constexpr kNRows = 32, kNCols = 16;
+  auto dmat = CreateDMatrix(kNRows, kNCols, 0, 3);
+  HostDeviceVector<GradientPair> gpair(kNRows, GradientPair(0.5f, 1.0f));
+
+  auto update = [&](const char* max_bin, const char* sparse_threshold) {
+    std::vector<std::pair<std::string, std::string>> cfg
+        {{"num_feature", std::to_string(kNCols)},
+         {"max_bin", max_bin},
+         {"sparse_threshold", sparse_threshold}};
+    std::unique_ptr<TreeUpdater> updater(TreeUpdater::Create("grow_quantile_histmaker"));
+    updater->Init(cfg);
+    RegTree tree;
+    tree.param.InitAllowUnknown(cfg);
+    std::vector<RegTree*> p_trees {&tree};
+    updater->Update(&gpair, dmat->get(), p_trees);
+  };
+
+  update("64", "0.2");
+  std::shared_ptr<common::QuantizedMatrix> quantized = (*dmat)->Quantized();
+  ASSERT_NE(quantized, nullptr);
+  ASSERT_EQ(quantized->max_bin, 64);
+  // same bins are reused, also with another column layout
+  update("64", "0.2");
+  ASSERT_EQ((*dmat)->Quantized(), quantized);
+  update("64", "0.5");
+  ASSERT_EQ((*dmat)->Quantized(), quantized);
+  // other bins are sketched again
+  update("16", "0.2");
+  ASSERT_NE((*dmat)->Quantized(), quantized);
+  ASSERT_EQ((*dmat)->Quantized()->max_bin, 16);
+
+  // the cuts are weighted, setting weights or groups sketches again
+  MetaInfo& info = (*dmat)->Info();
+  std::vector<bst_float> weights(kNRows);
+  for (int i = 0; i < kNRows; ++i) {
+    weights[i] = 1.0f + i % 4;
+  }
+  quantized = (*dmat)->Quantized();
+  info.SetInfo("weight", weights.data(), kFloat32, weights.size());
+  update("16", "0.2");
+  ASSERT_NE((*dmat)->Quantized(), quantized);
+  quantized = (*dmat)->Quantized();
+  info.SetInfo("weight", weights.data(), kFloat32, weights.size());
+  update("16", "0.2");
+  ASSERT_EQ((*dmat)->Quantized(), quantized);
+  weights[0] = 8.0f;
+  info.SetInfo("weight", weights.data(), kFloat32, weights.size());
+  update("16", "0.2");
+  ASSERT_NE((*dmat)->Quantized(), quantized);
+  quantized = (*dmat)->Quantized();
+  std::vector<unsigned> groups {kNRows / 2, kNRows / 2};
+  info.SetInfo("group", groups.data(), kUInt32, groups.size());
+  update("16", "0.2");
+  ASSERT_NE((*dmat)->Quantized(), quantized);
+  delete dmat;
+}
+
 }  // namespace tree
 }  // namespace xgboost